@@ -1,4 +1,4 @@
-// Halley codegen version 123
+// Halley codegen version 127
 #pragma once
 
 #include <halley.hpp>
@@ -31,6 +31,8 @@ public:
 		static_assert(std::is_final_v<T>, "System must be final.");
 	}
 protected:
+	using Halley::System::parallelForEach;
+
 	Halley::World& getWorld() const {
 		return doGetWorld();
 	}
@@ -1,6 +1,11 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <functional>
+#include <memory>
 #include <halley/text/halleystring.h>
 #include "executor.h"
 #include "future.h"
@@ -72,5 +77,88 @@ namespace Halley
 		{
 			foreach(ExecutionQueue::getDefault(), begin, end, f);
 		}
+
+		inline size_t getChunkWorkerCount(ExecutionQueue& e, size_t nChunks)
+		{
+			// The calling thread also takes part in the work
+			return std::max(size_t(1), std::min(nChunks, e.threadCount() + 1));
+		}
+
+		// Splits [0, n) into chunks of chunkSize elements, and calls f(chunkIdx, start, end, workerIdx) for each of them.
+		// Chunks are claimed dynamically by up to getChunkWorkerCount() workers, one of which is the calling thread; workerIdx is stable within a worker.
+		// The caller only waits for chunks that are actually running elsewhere, never for helpers that haven't started, so this is safe to call from
+		// a worker of e even when all of its other workers are busy (the caller then just runs every chunk itself).
+		template <typename F>
+		void foreachChunk(ExecutionQueue& e, size_t n, size_t chunkSize, F f)
+		{
+			chunkSize = std::max(chunkSize, size_t(1));
+			const size_t nChunks = (n + chunkSize - 1) / chunkSize;
+			const size_t nWorkers = getChunkWorkerCount(e, nChunks);
+
+			if (nWorkers <= 1) {
+				for (size_t chunk = 0; chunk < nChunks; ++chunk) {
+					const size_t start = chunk * chunkSize;
+					f(chunk, start, std::min(start + chunkSize, n), 0);
+				}
+				return;
+			}
+
+			// Shared with the helpers, which may only start after this call has returned; by then every chunk is claimed, so they exit without touching f
+			struct State {
+				std::atomic<size_t> nextChunk = 0;
+				size_t chunksDone = 0;
+				bool failed = false;
+				std::exception_ptr exception;
+				std::mutex mutex;
+				std::condition_variable chunksDoneCondition;
+			};
+			auto state = std::make_shared<State>();
+
+			auto work = [state, f = &f, n, nChunks, chunkSize] (size_t workerIdx)
+			{
+				for (size_t chunk = state->nextChunk++; chunk < nChunks; chunk = state->nextChunk++) {
+					std::exception_ptr exception;
+					bool skip;
+					{
+						std::unique_lock<std::mutex> lock(state->mutex);
+						skip = state->failed;
+					}
+					if (!skip) {
+						try {
+							const size_t start = chunk * chunkSize;
+							(*f)(chunk, start, std::min(start + chunkSize, n), workerIdx);
+						} catch (...) {
+							exception = std::current_exception();
+						}
+					}
+
+					std::unique_lock<std::mutex> lock(state->mutex);
+					if (exception && !state->failed) {
+						state->failed = true;
+						state->exception = exception;
+					}
+					if (++state->chunksDone == nChunks) {
+						state->chunksDoneCondition.notify_all();
+					}
+				}
+			};
+
+			for (size_t j = 1; j < nWorkers; ++j) {
+				execute(e, [work, j] () { work(j); });
+			}
+			work(0);
+
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->chunksDoneCondition.wait(lock, [&] { return state->chunksDone == nChunks; });
+			if (state->exception) {
+				std::rethrow_exception(state->exception);
+			}
+		}
+
+		template <typename F>
+		void foreachChunk(size_t n, size_t chunkSize, F f)
+		{
+			foreachChunk(ExecutionQueue::getDefault(), n, chunkSize, f);
+		}
 	}
 }
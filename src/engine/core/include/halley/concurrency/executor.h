@@ -49,6 +49,7 @@ namespace Halley
 
 		static Executors& get();
 		static void setInstance(Executors& e);
+		static bool hasInstance() { return instance != nullptr; }
 
 		static ExecutionQueue& getCPU() { return instance->cpu; }
 		static ExecutionQueue& getCPUAux() { return instance->cpuAux; }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "vector.h"
+#include "hash_map.h"
+
+namespace Halley {
+	// Per-thread bump allocator for short-lived allocations made while building a frame.
+	// Each thread's arena rewinds as soon as everything allocated from it has been released, so scoped containers cost a pointer bump and nothing else.
+	// Memory must be released on the thread that allocated it.
+	// At the end of each Core frame, arenas also release any blocks beyond what the thread needed during that frame.
+	class FrameArena
+	{
+	public:
+		static void* alloc(size_t size, size_t alignment);
+		static void free(void* p, size_t size) noexcept;
+
+		static void endFrame();
+
+		// Bytes currently held by the calling thread's arena
+		static size_t getReservedBytes();
+	};
+
+	template <typename T>
+	class FrameAllocator
+	{
+	public:
+		using value_type = T;
+
+		FrameAllocator() noexcept = default;
+		template <typename U> FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(FrameArena::alloc(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* p, size_t n) noexcept
+		{
+			FrameArena::free(p, n * sizeof(T));
+		}
+
+		template <typename U> bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+		template <typename U> bool operator!=(const FrameAllocator<U>&) const noexcept { return false; }
+	};
+
+	// Containers for temporaries that don't outlive the function (or at most the frame) that builds them
+	template <typename T>
+	using FrameVector = Vector<T, FrameAllocator<T>>;
+
+	template<typename Key, typename Value, typename Hash = std::hash<Key>>
+	using FrameHashMap = ska::flat_hash_map<Key, Value, Hash, typename EqualToPicker<Key>::type, FrameAllocator<std::pair<Key, Value>>>;
+}
@@ -1,23 +1,37 @@
 #pragma once
 
 #include "flat_map.h"
+#include "vector.h"
 #include <mutex>
 
 namespace Halley {
+	struct SizePoolStats
+	{
+		size_t objectSize = 0;
+		size_t liveBytes = 0;
+		size_t peakLiveBytes = 0;
+		size_t reservedBytes = 0;
+
+		// Fraction of the reserved slab memory that isn't holding live objects
+		float getFragmentation() const;
+	};
+
+	// Fixed-size allocator backed by a shared size class.
+	// Allocations and same-thread frees go through a per-thread cache without locking; frees from other threads are handed back to the owning cache lock-free.
 	class SizePool
 	{
 	public:
 		explicit SizePool(size_t size);
-		~SizePool();
 
 		size_t getSize() const { return size; }
 		void* alloc();
 		void free(void* p);
 
+		SizePoolStats getStats() const;
+
 	private:
-		void* pimpl;
 		size_t size;
-		std::mutex mutex;
+		int sizeClass;
 	};
 
 	// yo dawg
@@ -26,10 +40,18 @@ namespace Halley {
 	public:
 		static SizePool* getPool(size_t size);
 
+		// One entry per size class that has reserved memory. Live counts are batched per thread, so they may lag by a few objects.
+		static Vector<SizePoolStats> getStats();
+
 	private:
+		PoolPool();
 		static PoolPool& get();
 
-		FlatMap<size_t, SizePool*> pools;
+		Vector<SizePool> pools;
+
+		// Sizes too large for a size class fall back to malloc, and are rare enough to go through a lock
+		std::mutex oversizedMutex;
+		FlatMap<size_t, std::unique_ptr<SizePool>> oversized;
 	};
 
 	template <typename T>
@@ -38,9 +60,9 @@ namespace Halley {
 	public:
 		PoolAllocator()
 		{
-			pool = new SizePool(sizeof(T));
+			pool = PoolPool::getPool(sizeof(T));
 		}
-		
+
 		void* alloc()
 		{
 			return pool->alloc();
@@ -55,5 +77,5 @@ namespace Halley {
 
 		SizePool* pool;
 	};
-	
+
 }
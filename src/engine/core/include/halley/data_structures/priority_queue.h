@@ -1,3 +1,5 @@
+#pragma once
+
 #include <algorithm>
 #include "halley/data_structures/vector.h"
 
@@ -45,6 +47,11 @@ namespace Halley {
 	        heap.reserve(size);
         }
 
+        void clear()
+        {
+            heap.clear();
+        }
+
     private:
         Vector<T> heap;
         Comparator comparator;
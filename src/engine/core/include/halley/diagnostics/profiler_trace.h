@@ -0,0 +1,30 @@
+#pragma once
+
+#include "halley/api/core_api.h"
+#include "halley/support/profiler.h"
+
+namespace Halley
+{
+	// Collects a run of consecutive profiler frames and exports them in the Chrome trace event format,
+	// which can be loaded in chrome://tracing or Perfetto.
+	class ProfilerTraceCapture : public CoreAPI::IProfileCallback
+	{
+	public:
+		ProfilerTraceCapture(CoreAPI& core, size_t maxFrames);
+		~ProfilerTraceCapture() override;
+
+		void onProfileData(std::shared_ptr<ProfilerData> data) override;
+
+		size_t getNumFrames() const;
+		bool isFinished() const;
+		void stop();
+
+		String toChromeTrace() const;
+		static String toChromeTrace(gsl::span<const std::shared_ptr<ProfilerData>> frames);
+
+	private:
+		CoreAPI* core;
+		size_t maxFrames;
+		Vector<std::shared_ptr<ProfilerData>> frames;
+	};
+}
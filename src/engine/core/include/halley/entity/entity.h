@@ -24,17 +24,6 @@ namespace Halley {
 	template <class, class = std::void_t<>> struct HasOnAddedToEntityMember : std::false_type {};
 	template <class T> struct HasOnAddedToEntityMember<T, decltype(std::declval<T&>().onAddedToEntity(std::declval<EntityRef&>()))> : std::true_type { };
 	
-	class MessageEntry
-	{
-	public:
-		std::unique_ptr<Message> msg;
-		int type = -1;
-		int age = -1;
-
-		MessageEntry() {}
-		MessageEntry(std::unique_ptr<Message> msg, int type, int age) : msg(std::move(msg)), type(type), age(age) {}
-	};
-
 	class EntityRef;
 	class ConstEntityRef;
 
@@ -123,7 +112,7 @@ namespace Halley {
 			return enabled;
 		}
 
-		void setEnabled(bool enabled);
+		void setEnabled(World& world, bool enabled);
 		
 		const UUID& getPrefabUUID() const
 		{
@@ -174,7 +163,6 @@ namespace Halley {
 		Vector<Entity*> children; // Cacheline 1 starts 16 bytes into this
 
 		// Cacheline 1
-		Vector<MessageEntry> inbox;
 		String name;
 
 		// Cacheline 2
@@ -184,6 +172,8 @@ namespace Halley {
 
 		uint8_t hierarchyRevision = 0;
 
+		uint32_t worldIdx = 0;
+
 		Entity();
 		void destroyComponents(ComponentDeleterTable& storage);
 
@@ -217,14 +207,14 @@ namespace Halley {
 		ComponentDeleterTable& getComponentDeleterTable(World& world);
 
 		Entity* getParent() const { return parent; }
-		void setParent(Entity* parent, bool propagate = true, size_t childIdx = -1);
+		void setParent(World& world, Entity* parent, bool propagate = true, size_t childIdx = -1);
 		const Vector<Entity*>& getChildren() const { return children; }
-		void addChild(Entity& child);
-		void detachChildren();
+		void addChild(World& world, Entity& child);
+		void detachChildren(World& world);
 		void markHierarchyDirty();
 		void propagateChildrenChange();
 		void propagateChildWorldPartition(uint8_t newWorldPartition);
-		void propagateEnabled(bool enabled, bool parentEnabled);
+		void propagateEnabled(World& world, bool enabled, bool parentEnabled);
 
 		DataInterpolatorSet& setupNetwork(EntityRef& ref, uint8_t peerId);
 		std::optional<uint8_t> getOwnerPeerId() const;
@@ -592,13 +582,13 @@ namespace Halley {
 		void setParent(const EntityRef& parent, size_t childIdx = -1)
 		{
 			validate();
-			entity->setParent(parent.entity, true, childIdx);
+			entity->setParent(*world, parent.entity, true, childIdx);
 		}
 
 		void setParent()
 		{
 			validate();
-			entity->setParent(nullptr);
+			entity->setParent(*world, nullptr);
 		}
 
 		const Vector<Entity*>& getRawChildren() const
@@ -635,13 +625,13 @@ namespace Halley {
 		void addChild(EntityRef& child)
 		{
 			validate();
-			entity->addChild(*child.entity);
+			entity->addChild(*world, *child.entity);
 		}
 
 		void detachChildren()
 		{
 			validate();
-			entity->detachChildren();
+			entity->detachChildren(*world);
 		}
 
 		uint8_t getHierarchyRevision() const
@@ -694,7 +684,7 @@ namespace Halley {
 		void setEnabled(bool enabled)
 		{
 			validate();
-			entity->setEnabled(enabled);
+			entity->setEnabled(*world, enabled);
 		}
 
 		bool operator==(const EntityRef& other) const
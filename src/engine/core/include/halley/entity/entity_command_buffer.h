@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <gsl/span>
+#include "entity.h"
+#include "entity_id.h"
+#include "world.h"
+#include "halley/data_structures/vector.h"
+
+namespace Halley {
+	// Records structural changes (adding/removing components, destroying entities) so they can be applied later on the thread that owns the World.
+	// This is what parallel iteration hands to its body, as the World itself must not be modified from worker threads.
+	class EntityCommandBuffer {
+	public:
+		using Command = std::function<void(World&)>;
+
+		template <typename T>
+		void addComponent(EntityId id, T component)
+		{
+			add([id, component = std::move(component)] (World& world) mutable
+			{
+				doAddComponent(world, id, std::move(component));
+			});
+		}
+
+		template <typename T>
+		void removeComponent(EntityId id)
+		{
+			add([id] (World& world)
+			{
+				doRemoveComponent<T>(world, id);
+			});
+		}
+
+		void destroyEntity(EntityId id);
+		void run(Command command);
+
+		bool empty() const;
+		void clear();
+
+		void apply(World& world);
+
+		// Applies all buffers in order of the sort key their commands were recorded under, so results don't depend on thread scheduling
+		static void applyAll(gsl::span<EntityCommandBuffer> buffers, World& world);
+
+		void setSortKey(size_t key);
+
+	private:
+		Vector<std::pair<size_t, Command>> commands;
+		size_t sortKey = 0;
+
+		void add(Command command);
+
+		template <typename T>
+		static void doAddComponent(World& world, EntityId id, T component)
+		{
+			if (auto entity = world.tryGetEntity(id); entity.isValid()) {
+				entity.addComponent(std::move(component));
+			}
+		}
+
+		template <typename T>
+		static void doRemoveComponent(World& world, EntityId id)
+		{
+			if (auto entity = world.tryGetEntity(id); entity.isValid()) {
+				entity.template removeComponent<T>();
+			}
+		}
+	};
+}
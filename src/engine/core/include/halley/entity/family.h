@@ -1,6 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <gsl/gsl_assert>
 #include "family_type.h"
 #include "family_mask.h"
@@ -42,6 +46,14 @@ namespace Halley {
 		void notifyRemove(void* entities, size_t count);
 		void notifyReload(void* entities, size_t count);
 
+		// By default, removing entities swaps the last entity into the freed slot.
+		// Stable order keeps the remaining entities in insertion order instead, at the cost of a linear pass on frames with removals.
+		void setStableOrder(bool stable);
+		bool isStableOrder() const;
+
+		// Index of the entity within this family, if it's a member
+		std::optional<size_t> tryGetIndex(EntityId id) const;
+
 	protected:
 		virtual void addEntity(Entity& entity) = 0;
 		virtual void refreshEntity(Entity& entity) = 0;
@@ -55,6 +67,17 @@ namespace Halley {
 		size_t elemSize = 0;
 		Vector<EntityId> toRemove;
 		Vector<EntityId> toReload;
+		bool stableOrder = false;
+
+		// Sparse EntityId -> slot index, split into pages so that families only pay for the id ranges they actually hold
+		constexpr static uint32_t invalidSlot = std::numeric_limits<uint32_t>::max();
+		constexpr static size_t slotPageSize = 1024;
+		Vector<std::unique_ptr<std::array<uint32_t, slotPageSize>>> slotPages;
+
+		uint32_t getSlot(EntityId id) const;
+		void setSlot(EntityId id, size_t slot);
+		void clearSlot(EntityId id);
+		void clearSlots();
 
 		Vector<FamilyBindingBase*> addEntityCallbacks;
 		Vector<FamilyBindingBase*> removeEntityCallbacks;
@@ -116,6 +139,7 @@ namespace Halley {
 	protected:
 		void addEntity(Entity& entity) override
 		{
+			setSlot(entity.getEntityId(), entities.size());
 			auto& e = entities.emplace_back();
 			e.entityId = entity.getEntityId();
 			T::Type::loadComponents(entity, &e.data[0]);
@@ -125,11 +149,8 @@ namespace Halley {
 		
 		void refreshEntity(Entity& entity) override
 		{
-			for (auto& e: entities) {
-				if (e.entityId == entity.getEntityId()) {
-					T::Type::loadComponents(entity, &e.data[0]);
-					break;
-				}
+			if (auto* e = tryGetStorage(entity.getEntityId())) {
+				T::Type::loadComponents(entity, &e->data[0]);
 			}
 		}
 
@@ -153,9 +174,10 @@ namespace Halley {
 				// Notify reloads
 				HALLEY_DEBUG_TRACE();
 				Vector<StorageType*> reloadedEntities;
-				for (auto& entity : entities) {
-					if (std::find(toReload.begin(), toReload.end(), entity.entityId) != toReload.end()) {
-						reloadedEntities.push_back(&entity);
+				reloadedEntities.reserve(toReload.size());
+				for (const auto& id: toReload) {
+					if (auto* e = tryGetStorage(id)) {
+						reloadedEntities.push_back(e);
 					}
 				}
 				notifyReload(reloadedEntities.data(), reloadedEntities.size());
@@ -170,6 +192,7 @@ namespace Halley {
 		{
 			notifyRemove(entities.data(), entities.size());
 			entities.clear();
+			clearSlots();
 			updateElems();
 		}
 
@@ -184,49 +207,45 @@ namespace Halley {
 			elemSize = sizeof(StorageType);
 		}
 
+		StorageType* tryGetStorage(EntityId id)
+		{
+			const auto slot = getSlot(id);
+			if (slot != invalidSlot && entities[slot].entityId == id) {
+				return &entities[slot];
+			}
+			return nullptr;
+		}
+
 		void removeDeadEntities()
 		{
 			// Performance-critical code
-			// Benchmarks suggest that using a Vector is faster than std::set and std::unordered_set
+			// Every removal is a slot lookup, so this is O(removed) rather than O(family)
 			if (!toRemove.empty()) {
 				HALLEY_DEBUG_TRACE();
-				size_t removeCount = toRemove.size();
-				Expects(removeCount > 0);
+				const size_t removeCount = toRemove.size();
 				Expects(removeCount <= entities.size());
-				std::sort(toRemove.begin(), toRemove.end());
 
-				for (size_t i = 1; i < toRemove.size(); ++i) {
-					Expects(toRemove[i - 1] != toRemove[i]);
-				}
-
-				// Move all entities to be removed to the back of the vector
-				{
-					int n = int(entities.size());
-					// Note: it's important to scan it forward. Scanning backwards would improve performance for short-lived entities,
-					// but it causes an issue where an entity is removed and added to the same family in one frame.
-					for (int i = 0; i < n; i++) {
-						EntityId id = entities[i].entityId;
-						auto iter = std::lower_bound(toRemove.begin(), toRemove.end(), id);
-						if (iter != toRemove.end() && id == *iter) {
-							toRemove.erase(iter);
-							if (i != n - 1) {
-								std::swap(entities[i], entities[n - 1]);
-								i--;
-							}
-							n--;
-							if (toRemove.empty()) {
-								break;
-							}
+				if (stableOrder) {
+					removeDeadEntitiesStable();
+				} else {
+					// Move all entities to be removed to the back of the vector
+					size_t n = entities.size();
+					for (const auto& id: toRemove) {
+						const auto slot = getSlot(id);
+						Expects(slot != invalidSlot && slot < n && entities[slot].entityId == id);
+						clearSlot(id);
+						if (slot != n - 1) {
+							std::swap(entities[slot], entities[n - 1]);
+							setSlot(entities[slot].entityId, slot);
 						}
+						--n;
 					}
-					Ensures(size_t(n) + removeCount == entities.size());
+					Ensures(n + removeCount == entities.size());
 				}
-
-				Expects(toRemove.empty());
+				toRemove.clear();
 
 				// Notify removal
-				size_t newSize = entities.size() - removeCount;
-				Ensures(newSize < entities.size());
+				const size_t newSize = entities.size() - removeCount;
 				notifyRemove(entities.data() + newSize, removeCount);
 
 				// Remove them
@@ -235,5 +254,23 @@ namespace Halley {
 			}
 			Ensures(toRemove.empty());
 		}
+
+		void removeDeadEntitiesStable()
+		{
+			// Flag the entities being removed by clearing their slots, then move them to the back without changing the order of the others
+			size_t firstRemoved = entities.size();
+			for (const auto& id: toRemove) {
+				const auto slot = getSlot(id);
+				Expects(slot != invalidSlot && entities[slot].entityId == id);
+				firstRemoved = std::min(firstRemoved, size_t(slot));
+				clearSlot(id);
+			}
+
+			std::stable_partition(entities.begin() + firstRemoved, entities.end(), [&] (const StorageType& e) { return getSlot(e.entityId) != invalidSlot; });
+
+			for (size_t i = firstRemoved; i < entities.size() - toRemove.size(); ++i) {
+				setSlot(entities[i].entityId, i);
+			}
+		}
 	};
 }
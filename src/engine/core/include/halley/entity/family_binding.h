@@ -14,6 +14,9 @@ namespace Halley {
 		size_t count() const { return family->count(); }
 		size_t size() const { return family->count(); }
 
+		// See Family::setStableOrder()
+		void setStableOrder(bool stable);
+
 		~FamilyBindingBase();
 
 	protected:
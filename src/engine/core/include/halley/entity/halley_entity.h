@@ -16,6 +16,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "halley/entity/world.h"
 #include "halley/entity/world_scene_data.h"
 #include "halley/entity/family_binding.h"
+#include "halley/entity/entity_command_buffer.h"
 #include "halley/entity/family.h"
 #include "halley/entity/entity_data.h"
 #include "halley/entity/entity_data_delta.h"
@@ -31,6 +32,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 
 #include "halley/diagnostics/frame_debugger.h"
 #include "halley/diagnostics/performance_stats.h"
+#include "halley/diagnostics/profiler_trace.h"
 #include "halley/diagnostics/world_stats.h"
 
 #include "halley/scripting/script_environment.h"
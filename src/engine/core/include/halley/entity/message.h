@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <typeinfo>
 
 #include "halley/support/exception.h"
@@ -18,6 +19,10 @@ namespace Halley
 		uint8_t fromPeerId = 0;
 
 		virtual ~Message() {}
+
+		void* operator new(size_t size);
+		void operator delete(void* ptr, size_t size);
+
 		virtual size_t getSize() const = 0;
 		virtual int getId() const = 0;
 
@@ -36,4 +41,15 @@ namespace Halley
 			throw Exception("Message " + String(typeid(*this).name()) + " is not serializable.", HalleyExceptions::Entity);
 		}
 	};
+
+	class MessageEntry
+	{
+	public:
+		std::unique_ptr<Message> msg;
+		int type = -1;
+		int age = -1;
+
+		MessageEntry() {}
+		MessageEntry(std::unique_ptr<Message> msg, int type, int age) : msg(std::move(msg)), type(type), age(age) {}
+	};
 }
@@ -8,9 +8,11 @@
 #include "family_mask.h"
 #include "family_type.h"
 #include "entity.h"
+#include "entity_command_buffer.h"
 #include "halley/utils/type_traits.h"
 #include "system_message.h"
 #include "halley/bytes/byte_serializer.h"
+#include "halley/support/profiler.h"
 
 namespace Halley {
 	class Message;
@@ -40,6 +42,19 @@ namespace Halley {
 		System* system = nullptr;
 	};
 	
+	// Declares what a system touches during its update, so the World can run non-conflicting systems concurrently.
+	// Generated by codegen; a default-constructed declaration is exclusive, i.e. it conflicts with every other system.
+	struct SystemAccessDeclaration {
+		Vector<int> componentsRead;
+		Vector<int> componentsWritten;
+		Vector<String> services;
+		Vector<int> messagesSent;
+		Vector<int> messagesReceived;
+		bool exclusive = true;
+
+		bool conflictsWith(const SystemAccessDeclaration& other) const;
+	};
+
 	class System
 	{
 		friend class SystemMessageBridge;
@@ -49,11 +64,12 @@ namespace Halley {
 		virtual ~System() {}
 
 		const String& getName() const { return name; }
-		void setName(String n) { name = std::move(n); }
+		void setName(String n);
 		size_t getEntityCount() const;
 		bool tryInit();
 
 		virtual bool canHandleSystemMessage(int messageId, const String& targetSystem) const { return false; }
+		virtual SystemAccessDeclaration getAccessDeclaration() const { return {}; }
 		void receiveSystemMessage(const SystemMessageContext& context);
 		void prepareSystemMessages();
 		void processSystemMessages();
@@ -91,11 +107,61 @@ namespace Halley {
 		template <typename F, typename V>
 		static void invokeParallel(F&& f, V& fam)
 		{
-			Concurrent::foreach(std::begin(fam), std::end(fam), [&] (auto& e) {
-				f(e);
+			if (!Executors::hasInstance()) {
+				invokeIndividual(f, fam);
+				return;
+			}
+
+			using T = std::remove_reference_t<decltype(*std::begin(fam))>;
+			auto* elems = std::begin(fam);
+			Concurrent::foreachChunk(Executors::getCPU(), fam.count(), getDefaultChunkSize<T>(), [&] (size_t, size_t start, size_t end, size_t) {
+				for (size_t i = start; i < end; ++i) {
+					f(elems[i]);
+				}
 			});
 		}
 
+		// Runs f(element, commands) for every element of the family, in chunks spread over the CPU executors.
+		// The body may only touch that element's components; structural changes (adding/removing components, destroying entities)
+		// must be recorded on the EntityCommandBuffer passed in, and are applied once all chunks are done.
+		// A chunkSize of zero picks a size that keeps each chunk's family data within a cache-friendly block.
+		// Without executors (e.g. in tools and tests) the elements are visited serially on the calling thread.
+		template <typename T, typename F>
+		void parallelForEach(FamilyBinding<T>& family, size_t chunkSize, F&& f)
+		{
+			if (!Executors::hasInstance()) {
+				EntityCommandBuffer commands;
+				for (auto& e: family) {
+					f(e, commands);
+				}
+				commands.apply(*world);
+				return;
+			}
+
+			auto& queue = Executors::getCPU();
+			const size_t n = family.count();
+			chunkSize = chunkSize == 0 ? getDefaultChunkSize<T>() : chunkSize;
+
+			Vector<EntityCommandBuffer> commandBuffers(Concurrent::getChunkWorkerCount(queue, (n + chunkSize - 1) / chunkSize));
+			T* elems = family.begin();
+			Concurrent::foreachChunk(queue, n, chunkSize, [&] (size_t chunk, size_t start, size_t end, size_t worker) {
+				auto& commands = commandBuffers[worker];
+				commands.setSortKey(chunk);
+				for (size_t i = start; i < end; ++i) {
+					f(elems[i], commands);
+				}
+			});
+
+			EntityCommandBuffer::applyAll(commandBuffers, *world);
+		}
+
+		template <typename T>
+		constexpr static size_t getDefaultChunkSize()
+		{
+			constexpr size_t chunkBytes = 16 * 1024;
+			return std::max(size_t(1), chunkBytes / sizeof(T));
+		}
+
 		template <typename T>
 		void sendMessageGeneric(EntityId entityId, T msg)
 		{
@@ -190,8 +256,10 @@ namespace Halley {
 
 		Vector<FamilyBindingBase*> families;
 		Vector<int> messageTypesReceived;
-		Vector<EntityId> messagesSentTo;
+		Vector<int> messageTypesSent;
 		Vector<std::pair<EntityId, MessageEntry>> outbox;
+		Vector<Message*> receivedMessages;
+		Vector<size_t> receivedIndices;
 		Vector<const SystemMessageContext*> systemMessageInbox;
 		Vector<const SystemMessageContext*> systemMessages;
 
@@ -199,10 +267,13 @@ namespace Halley {
 		const HalleyAPI* api = nullptr;
 		Resources* resources = nullptr;
 		String name;
+		ProfilerNameId profilerName = 0;
 		int systemId = -1;
 		bool initialised = false;
 
 		void doUpdate(Time time);
+		void doUpdateConcurrent(Time time);
+		void finishConcurrentUpdate();
 		void doRender(RenderContext& rc);
 		void onAddedToWorld(World& world, int id);
 
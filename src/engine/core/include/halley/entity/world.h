@@ -116,9 +116,9 @@ namespace Halley {
 
 		void spawnPending(); // Warning: use with care, will invalidate entities
 
-		void onEntityDirty();
+		void onEntityDirty(Entity& entity);
 
-		void setEntityReloaded();
+		void setEntityReloaded(Entity& entity);
 
 		template <typename T>
 		Family& getFamily() noexcept
@@ -153,6 +153,11 @@ namespace Halley {
 		std::unique_ptr<SystemMessage> deserializeSystemMessage(int msgId, gsl::span<const std::byte> data);
 		std::unique_ptr<SystemMessage> deserializeSystemMessage(const String& messageName, const ConfigNode& data);
 
+		// Entity messages in flight, indexed by message type. Each entry keeps the target entity and the id of the system that sent it.
+		using EntityMessageQueue = Vector<std::pair<EntityId, MessageEntry>>;
+		EntityMessageQueue& getEntityMessageQueue(int msgType);
+		const EntityMessageQueue* tryGetEntityMessageQueue(int msgType) const;
+
 		bool isDevMode() const;
 
 		void setEditor(bool isEditor);
@@ -164,6 +169,11 @@ namespace Halley {
 		float getTransform2DAnisotropy() const;
 		void setTransform2DAnisotropy(float anisotropy);
 
+		// When enabled, systems whose declared access doesn't conflict run concurrently on the CPU executors.
+		// Those systems may still fan out onto the CPU executors themselves (e.g. with parallelForEach), as the batch never blocks on an idle worker.
+		void setParallelUpdate(bool enabled);
+		bool isParallelUpdate() const;
+
 		template <typename T>
 		T& getInterface()
 		{
@@ -186,15 +196,17 @@ namespace Halley {
 		const HalleyAPI& api;
 		Resources& resources;
 		std::array<Vector<std::unique_ptr<System>>, static_cast<int>(TimeLine::NUMBER_OF_TIMELINES)> systems;
+		std::array<Vector<Vector<System*>>, static_cast<int>(TimeLine::NUMBER_OF_TIMELINES)> systemBatches;
 		WorldReflection reflection;
-		bool entityDirty = false;
-		bool entityReloaded = false;
 		bool editor = false;
 		bool devMode = false;
 		bool terminating = false;
+		bool parallelUpdate = false;
 		
 		Vector<Entity*> entities;
 		Vector<Entity*> entitiesPendingCreation;
+		Vector<Entity*> dirtyEntities;
+		Vector<Entity*> reloadedEntities;
 		MappedPool<Entity*> entityMap;
 		HashMap<UUID, Entity*> uuidMap;
 
@@ -209,6 +221,19 @@ namespace Halley {
 		std::shared_ptr<PoolAllocator<Entity>> entityPool;
 
 		std::list<SystemMessageContext> pendingSystemMessages;
+		Vector<EntityMessageQueue> entityMessageQueues;
+
+		struct FamilyTodo {
+			FamilyMaskType mask;
+			Vector<std::pair<FamilyMaskType, Entity*>> toRemove;
+			Vector<std::pair<FamilyMaskType, Entity*>> toAdd;
+			Vector<Entity*> toReload;
+		};
+
+		// Reused every frame, only the first familyTodoCount entries are live
+		Vector<FamilyTodo> familyTodos;
+		size_t familyTodoCount = 0;
+		Vector<Entity*> entitiesRemoved;
 		
 		IWorldNetworkInterface* networkInterface = nullptr;
 		float transform2DAnisotropy = 1.0f;
@@ -217,6 +242,7 @@ namespace Halley {
 
 		void allocateEntity(Entity* entity);
 		void updateEntities();
+		FamilyTodo& getFamilyTodo(FamilyMaskType mask);
 		void initSystems(gsl::span<const TimeLine> timelines);
 
 		void doDestroyEntity(EntityId id);
@@ -224,6 +250,8 @@ namespace Halley {
 		void deleteEntity(Entity* entity);
 
 		void updateSystems(TimeLine timeline, Time elapsed);
+		void updateSystemsParallel(TimeLine timeline, Time elapsed);
+		const Vector<Vector<System*>>& getSystemBatches(TimeLine timeline);
 		void renderSystems(RenderContext& rc) const;
 
 		NOINLINE Family& addFamily(std::unique_ptr<Family> family) noexcept;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "halley/data_structures/vector.h"
+#include "halley/graphics/texture_descriptor.h"
+#include <gsl/span>
+#include <memory>
+
+namespace Halley {
+	class Image;
+
+	// CPU encoders for GPU block-compressed texture formats, so textures can be stored compressed and uploaded as they are
+	class BlockCompression {
+	public:
+		// Encodes an RGB or RGBA image followed by the rest of its mip chain, mipLevels in total.
+		// Sizes that aren't a multiple of the block size are padded by repeating the edge texels.
+		static Bytes encode(const Image& image, TextureFormat format, int mipLevels = 1);
+
+		// Decodes the first level back to RGBA. Only the block modes produced by encode() are supported, this is meant for tests and tools.
+		static std::unique_ptr<Image> decode(gsl::span<const gsl::byte> data, Vector2i size, TextureFormat format);
+
+		// Half size, box-filtered copy of the image
+		static std::unique_ptr<Image> makeMip(const Image& image);
+	};
+}
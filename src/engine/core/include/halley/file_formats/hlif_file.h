@@ -21,6 +21,7 @@ namespace Halley {
 
     private:
      	constexpr static uint8_t hlifId[8] = "HLIFv01";
+     	constexpr static uint8_t hlifIdV2[8] = "HLIFv02";
 
     	enum class Format : uint8_t {
 			RGBA,
@@ -44,6 +45,22 @@ namespace Halley {
             uint8_t reserved = 0;
 		};
 
+    	// v2 splits the image into bands of rows that are filtered and compressed independently, so they can be encoded and decoded in parallel.
+    	// Layout: HeaderV2, compressed size of each band (uint32_t), LZ4 block with palettes and line encodings, then each band's LZ4 block.
+		struct HeaderV2 {
+			uint8_t id[8];
+			uint16_t width = 0;
+			uint16_t height = 0;
+			Format format = Format::RGBA;
+            uint8_t flags = 0;
+            uint8_t numPalettes = 0;
+            uint8_t reserved = 0;
+            uint16_t bandHeight = 0;
+            uint16_t numBands = 0;
+			uint32_t metaCompressedSize = 0;
+			uint32_t metaUncompressedSize = 0;
+		};
+
     public:
     	// Same as PNG
         enum class LineEncoding: uint8_t {
@@ -63,6 +80,11 @@ namespace Halley {
             Palette();
         };
         
+        static void decodeV1(Image& dst, gsl::span<const gsl::byte> data);
+        static void decodeV2(Image& dst, gsl::span<const gsl::byte> data);
+        static Image::Format getImageFormat(Format format, uint8_t flags);
+        static int getBandHeight(Vector2i size, int bpp);
+
     	static void decodeLines(Vector2i size, gsl::span<const uint8_t> lineData, gsl::span<uint8_t> pixelData, int bpp);
     	static void encodeLines(Vector2i size, gsl::span<uint8_t> lineData, gsl::span<uint8_t> pixelData, int bpp);
         static LineEncoding findBestLineEncoding(gsl::span<const uint8_t> curLine, gsl::span<const uint8_t> prevLine, int bpp);
@@ -72,7 +94,7 @@ namespace Halley {
 
         static std::optional<std::pair<Vector<Palette>, Bytes>> makePalettes(gsl::span<const int> pixels, std::string_view name = {});
         static void optimizePalettes(gsl::span<Palette> palettes, gsl::span<uint8_t> pixels);
-        static void applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst);
+        static void applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst, size_t firstPixel = 0);
         static void deltaEncodePalettes(gsl::span<Palette> palettes);
         static void deltaDecodePalettes(gsl::span<Palette> palettes);
     };
@@ -4,6 +4,7 @@
 #include "halley/maths/colour.h"
 #include "graphics_enums.h"
 #include <condition_variable>
+#include <functional>
 #include <halley/maths/vector4.h>
 
 
@@ -79,6 +80,11 @@ namespace Halley
 		// vertPosOffset is the offset, in bytes, from the start of each vertex's data, to a Vector2f which will be filled with the vertex's position in 0-1 space.
 		void drawSprites(const std::shared_ptr<const Material>& material, size_t numSprites, const void* vertexData);
 
+		// Same as above, but instead of copying from a buffer, writer(firstSprite, numSprites, dst, dstStride) fills each sprite's vertex directly in the vertex stream.
+		// Sprite i of that batch goes at dst + i * dstStride. It may be called several times for large counts.
+		using SpriteVertexWriter = std::function<void(size_t firstSprite, size_t numSprites, char* dst, size_t dstStride)>;
+		void drawSprites(const std::shared_ptr<const Material>& material, size_t numSprites, const SpriteVertexWriter& writer);
+
 		// Draw one sliced sprite. Slices -> x = left, y = top, z = right, w = bottom, in [0..1] space relative to the texture
 		void drawSlicedSprite(const std::shared_ptr<const Material>& material, Vector2f scale, Vector4f slices, const void* vertexData);
 
@@ -7,8 +7,8 @@
 #include "halley/maths/colour_gradient.h"
 
 namespace Halley {
-	class Random;
 	class Animation;
+	class Painter;
 
 	enum class ParticleSpawnAreaShape : uint8_t {
 		Rectangle,
@@ -26,14 +26,23 @@ namespace Halley {
 	};
 	
 	class Particles {
-		struct Particle {
-			Vector3f pos;
-			Vector3f vel;
-			Angle1f angle;
-			float scale = 1;
-			float time = 0;
-			float ttl = 1;
-			bool alive = true;
+		// Simulation state is kept as structure-of-arrays so it can be stepped several particles at a time.
+		// Arrays are always sized to a multiple of 8, so the SIMD loops can run past the last live particle without a scalar tail.
+		struct ParticleData {
+			Vector<float> posX;
+			Vector<float> posY;
+			Vector<float> posZ;
+			Vector<float> velX;
+			Vector<float> velY;
+			Vector<float> velZ;
+			Vector<float> time;
+			Vector<float> ttl;
+			Vector<float> scale;
+			Vector<float> angle;
+
+			size_t size() const;
+			void resize(size_t size);
+			void move(size_t from, size_t to);
 		};
 		
 	public:
@@ -45,6 +54,10 @@ namespace Halley {
 
 		void burstParticles(float n);
 
+		// Each emitter draws from its own generator, so the simulation doesn't depend on which thread steps it.
+		// Emitters are seeded in creation order by default, set a seed explicitly to tie an emitter to something more stable.
+		void setSeed(uint32_t seed);
+
 		void reset();
 
 		void setEnabled(bool enabled);
@@ -87,25 +100,31 @@ namespace Halley {
 
 		bool isAnimated() const;
 		bool isAlive() const;
-		
+		size_t getNumParticles() const;
+
+		// Writes the visible particles straight into the painter's vertex stream, without going through Sprite objects.
+		// Doesn't modify the emitter, so it's safe to call while other emitters are being updated.
+		void draw(Painter& painter) const;
+
+		// Sprites are only brought up to date with the simulation when requested, prefer draw() where possible
 		[[nodiscard]] gsl::span<Sprite> getSprites();
-		[[nodiscard]] gsl::span<const Sprite> getSprites() const;
 
 	private:
-		Random* rng;
 		std::shared_ptr<Material> material;
 
 		bool enabled = true;
 		bool firstUpdate = true;
 		float spawnRateMultiplier = 1.0f;
 
-		Vector<Sprite> sprites;
-		Vector<Particle> particles;
+		Vector<Sprite> sprites; // Per-particle base sprite, only its position, rotation, scale, colour and custom1 are overwritten by the simulation
+		bool spritesDirty = false;
+		ParticleData particles;
 		Vector<AnimationPlayerLite> animationPlayers;
 		
 		size_t nParticlesAlive = 0;
 		size_t nParticlesVisible = 0;
 		float pendingSpawn = 0;
+		uint32_t rngState = 1;
 
 		float spawnRate = 100;
 		Vector2f spawnArea;
@@ -137,9 +156,19 @@ namespace Halley {
 		void start();
 		void initializeParticle(size_t index, float time);
 		void updateParticles(float t);
+		void integrateParticles(float t);
+		void removeDeadParticles();
 		void spawn(size_t n, float time);
 
-		Vector3f getSpawnPosition() const;
+		void writeVertex(size_t index, SpriteVertexAttrib& dst) const;
+		void updateSprite(size_t index, Sprite& sprite) const;
+		void updateSprites();
+
+		uint32_t getRandomInt();
+		float getRandomFloat(float min, float max);
+		float getRandomFloat(Range<float> range);
+
+		Vector3f getSpawnPosition();
 	};
 
 	class Resources;
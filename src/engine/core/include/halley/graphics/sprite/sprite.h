@@ -135,6 +135,9 @@ namespace Halley
 		Vector4f getCustom2() const { return vertexAttrib.custom2; }
 		Vector4f& getCustom2() { return vertexAttrib.custom2; }
 		
+		// The data that gets sent to the vertex shader, see Painter::drawSprites
+		const SpriteVertexAttrib& getVertexAttributes() const { return vertexAttrib; }
+
 		Sprite& setSliced(Vector4s slices);
 		Sprite& setNotSliced();
 		bool isSliced() const { return sliced; }
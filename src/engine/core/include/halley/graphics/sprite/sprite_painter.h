@@ -13,6 +13,7 @@ namespace Halley
 	class TextRenderer;
 	class String;
 	class Sprite;
+	class Particles;
 	class Painter;
 	class Material;
 
@@ -22,6 +23,7 @@ namespace Halley
 		SpriteCached,
 		TextRef,
 		TextCached,
+		ParticlesRef,
 		Callback
 	};
 
@@ -32,12 +34,15 @@ namespace Halley
 		
 		SpritePainterEntry(gsl::span<const Sprite> sprites, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 		SpritePainterEntry(gsl::span<const TextRenderer> texts, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
+		SpritePainterEntry(const Particles& particles, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 		SpritePainterEntry(SpritePainterEntryType type, size_t spriteIdx, size_t count, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip);
 
 		bool operator<(const SpritePainterEntry& o) const;
+		uint64_t getSortKey() const;
 		SpritePainterEntryType getType() const;
 		gsl::span<const Sprite> getSprites() const;
 		gsl::span<const TextRenderer> getTexts() const;
+		const Particles& getParticles() const;
 		uint32_t getIndex() const;
 		uint32_t getCount() const;
 		int getMask() const;
@@ -68,6 +73,7 @@ namespace Halley
 		void add(const TextRenderer& sprite, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		void add(TextRenderer&& text, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		void addCopy(const TextRenderer& text, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
+		void add(const Particles& particles, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		void add(SpritePainterEntry::Callback callback, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip = {});
 		
 		void draw(int mask, Painter& painter);
@@ -81,8 +87,23 @@ namespace Halley
 		bool dirty = false;
 		bool forceCopy = false;
 
-		void draw(gsl::span<const Sprite> sprite, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
+		// Scratch buffers, kept around to avoid reallocating every frame
+		Vector<SpritePainterEntry> sortScratch;
+		Vector<uint64_t> sortKeys;
+		Vector<uint64_t> sortKeysScratch;
+		Vector<const Sprite*> cullList;
+		Vector<float> cullMinX;
+		Vector<float> cullMinY;
+		Vector<float> cullMaxX;
+		Vector<float> cullMaxY;
+		Vector<uint8_t> cullVisible;
+
+		void sortEntries();
+		void cullSprites(Rect4f view);
+
+		void draw(gsl::span<const Sprite> sprite, size_t& cullIdx, Painter& painter, const std::optional<Rect4f>& clip) const;
 		void draw(gsl::span<const TextRenderer> text, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const;
+		void draw(const Particles& particles, Painter& painter, const std::optional<Rect4f>& clip) const;
 		void draw(const SpritePainterEntry::Callback& callback, Painter& painter, const std::optional<Rect4f>& clip) const;
 	};
 }
@@ -20,6 +20,23 @@ namespace Halley
 
 	class TextRenderer
 	{
+		// A glyph ready to be drawn, positioned relative to the text's origin
+		struct LayoutGlyph {
+			Vector2f pos;
+			Vector2f pivot;
+			Vector2f size;
+			Rect4f texRect;
+			Colour4f colour;
+			float scale = 1;
+			uint32_t index = 0; // Position among all glyphs in the text
+		};
+
+		// All glyphs sharing a material, drawn in a single batch
+		struct GlyphRun {
+			std::shared_ptr<const Material> material;
+			Vector<LayoutGlyph> glyphs;
+		};
+
 	public:
 		using SpriteFilter = std::function<void(gsl::span<Sprite>)>;
 
@@ -105,11 +122,16 @@ namespace Halley
 
 		Vector<ColourOverride> colourOverrides;
 
-		mutable Vector<Sprite> spritesCache;
+		mutable Vector<GlyphRun> glyphRuns;
+		mutable size_t nLayoutGlyphs = 0;
+		mutable Vector2f layoutOrigin;
+		mutable Vector2f layoutExtents;
+		mutable Vector<Sprite> spritesCache; // Only used with a sprite filter
 		mutable bool materialDirty = true;
 		mutable bool glyphsDirty = true;
 		mutable bool positionDirty = true;
 
+		void updateLayout() const;
 		std::shared_ptr<Material> getMaterial(const Font& font) const;
 		void updateMaterial(Material& material, const Font& font) const;
 		void updateMaterialForFont(const Font& font) const;
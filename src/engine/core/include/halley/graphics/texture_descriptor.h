@@ -17,12 +17,20 @@ namespace Halley
 		BGRA5551,
 		BGRX,
 		SRGBA,
-		RGBAFloat16
+		RGBAFloat16,
+
+		// Block-compressed, 4x4 texels per block
+		BC1,
+		BC3,
+		BC7,
+		ETC2RGB,
+		ETC2RGBA,
+		ASTC4x4
 	};
 
 	template <>
 	struct EnumNames<TextureFormat> {
-		constexpr std::array<const char*, 10> operator()() const {
+		constexpr std::array<const char*, 16> operator()() const {
 			return{{
 				"indexed",
 				"rgb",
@@ -33,7 +41,13 @@ namespace Halley
 				"rgba5551",
 				"xrgb",
 				"srgba",
-				"rgbaFloat16"
+				"rgbaFloat16",
+				"bc1",
+				"bc3",
+				"bc7",
+				"etc2rgb",
+				"etc2rgba",
+				"astc4x4"
 			}};
 		}
 	};
@@ -117,6 +131,7 @@ namespace Halley
 		bool isHardwareVideoDecodeTexture = false;
 		bool retainPixelData = false;
 		bool canBeReadOnCPU = false;
+		int mipLevels = 1; // Number of levels included in pixelData, only block-compressed formats come with precomputed mipmaps
 
 		TextureDescriptor() = default;
 		TextureDescriptor(TextureDescriptor&& other) noexcept = default;
@@ -125,6 +140,11 @@ namespace Halley
 		TextureDescriptor& operator=(TextureDescriptor&& other) noexcept;
 
 		static int getBytesPerPixel(TextureFormat format);
+		static bool isBlockCompressed(TextureFormat format);
+		static size_t getBytesPerBlock(TextureFormat format);
+		static size_t getByteSize(TextureFormat format, Vector2i size);
+		static int getMaxMipLevels(Vector2i size);
+		static Vector2i getMipSize(Vector2i size, int level);
 
 		size_t getMemoryUsage() const;
 	};
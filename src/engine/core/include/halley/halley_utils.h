@@ -19,6 +19,7 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "data_structures/config_database.h"
 #include "data_structures/config_node.h"
 #include "data_structures/dynamic_grid.h"
+#include "data_structures/frame_arena.h"
 #include "data_structures/hash_map.h"
 #include "data_structures/mapped_pool.h"
 #include "data_structures/maybe.h"
@@ -81,6 +82,8 @@ namespace Halley {} // Get GitHub to realise this is C++ :3
 #include "navigation/navigation_query.h"
 #include "navigation/navigation_path.h"
 #include "navigation/navigation_path_follower.h"
+#include "navigation/navigation_flow_field.h"
+#include "navigation/pathfinding_service.h"
 #include "navigation/world_position.h"
 
 #include "plugin/plugin.h"
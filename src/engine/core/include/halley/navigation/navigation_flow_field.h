@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include "navmesh.h"
+#include "world_position.h"
+#include "halley/data_structures/hash_map.h"
+
+namespace Halley {
+	class NavmeshSet;
+
+	// Directions towards a single goal from anywhere that can reach it, computed once and shared.
+	// Meant for crowds chasing the same target: instead of one path per agent, every agent looks up where to go next from its own position.
+	// The goal's region gets a search over its nodes; every other region is seeded from one search over the region graph, and leads into the portal it should leave through.
+	class NavigationFlowField {
+	public:
+		NavigationFlowField(const NavmeshSet& navmeshSet, WorldPosition goal);
+
+		[[nodiscard]] bool isValid() const;
+		[[nodiscard]] WorldPosition getGoal() const { return goal; }
+		[[nodiscard]] uint16_t getRegionId() const { return regionId; }
+
+		[[nodiscard]] bool contains(const NavmeshSet& navmeshSet, WorldPosition pos) const;
+		// Region that pos is in, or empty if it's not on the navmesh or the goal can't be reached from there
+		[[nodiscard]] std::optional<uint16_t> getRegionAt(const NavmeshSet& navmeshSet, WorldPosition pos) const;
+
+		// Next point to head towards, or empty if pos can't reach the goal
+		[[nodiscard]] std::optional<Vector2f> getNextPosition(const NavmeshSet& navmeshSet, WorldPosition pos) const;
+		[[nodiscard]] std::optional<Vector2f> getNextPosition(const NavmeshSet& navmeshSet, WorldPosition pos, uint16_t region) const;
+		[[nodiscard]] std::optional<float> getCost(const NavmeshSet& navmeshSet, WorldPosition pos) const;
+
+	private:
+		struct RegionField {
+			Vector<float> costs;
+			Vector<Navmesh::NodeAndConn> nextHops;
+		};
+
+		WorldPosition goal;
+		uint16_t regionId = std::numeric_limits<uint16_t>::max();
+		HashMap<uint16_t, RegionField> regions;
+
+		const RegionField* getRegionField(const NavmeshSet& navmeshSet, uint16_t region) const;
+		std::optional<Navmesh::NodeId> getNodeAt(const NavmeshSet& navmeshSet, WorldPosition pos, uint16_t region) const;
+	};
+
+	// Keeps one flow field per goal region, only rebuilding it once the goal moves further than the threshold from where the field was built.
+	// Must be cleared whenever the navmesh set changes.
+	class NavigationFlowFieldCache {
+	public:
+		explicit NavigationFlowFieldCache(float goalMoveThreshold = 16.0f);
+
+		std::shared_ptr<const NavigationFlowField> getFlowField(const NavmeshSet& navmeshSet, WorldPosition goal);
+		void clear();
+
+	private:
+		float goalMoveThreshold;
+		HashMap<uint16_t, std::shared_ptr<const NavigationFlowField>> fields;
+	};
+}
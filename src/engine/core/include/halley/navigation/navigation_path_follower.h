@@ -1,10 +1,12 @@
 #pragma once
 
+#include <memory>
 #include "navigation_path.h"
 #include "world_position.h"
 
 namespace Halley {
 	class NavmeshSet;
+	class NavigationFlowField;
 
 	class NavigationPathFollower {
 	public:
@@ -17,6 +19,11 @@ namespace Halley {
 		const std::optional<NavigationPath>& getPath() const;
 		gsl::span<const Vector2f> getNextPathPoints() const;
 
+		// Follows a flow field shared with other agents instead of an individual path. Only when off the field altogether
+		// (e.g. slightly outside of the navmesh) is a regular path to its goal used, until the field is reached. Flow fields are not serialized.
+		void setFlowField(std::shared_ptr<const NavigationFlowField> field, ConfigNode params = {});
+		const std::shared_ptr<const NavigationFlowField>& getFlowField() const;
+
 		void update(WorldPosition curPos, const NavmeshSet& navmeshSet, float threshold);
 		
 		Vector2f getNextPosition() const;
@@ -38,8 +45,13 @@ namespace Halley {
 		bool needsToReEvaluatePath = false;
 		int navmeshSubWorld = 0;
 		ConfigNode params;
+		std::shared_ptr<const NavigationFlowField> flowField;
+		std::optional<Vector2f> flowFieldTarget;
+		uint16_t flowFieldRegionId = std::numeric_limits<uint16_t>::max();
 
 		void doSetPath(std::optional<NavigationPath> p);
+		void updatePath(const NavmeshSet& navmeshSet, float threshold);
+		void updateFlowField(const NavmeshSet& navmeshSet, float threshold);
 		void goToNextRegion(const NavmeshSet& navmeshSet);
 		void reEvaluatePath(const NavmeshSet& navmeshSet);
 	};
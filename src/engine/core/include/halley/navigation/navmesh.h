@@ -2,6 +2,8 @@
 
 #include "navigation_path.h"
 #include "navigation_query.h"
+#include "search_state.h"
+#include "halley/data_structures/priority_queue.h"
 #include "halley/maths/polygon.h"
 #include "halley/maths/base_transform.h"
 
@@ -119,6 +121,8 @@ namespace Halley {
 		[[nodiscard]] std::optional<NodeId> getNodeAt(Vector2f position) const;
 		[[nodiscard]] bool containsPoint(Vector2f position) const;
 		[[nodiscard]] std::optional<Vector2f> getClosestPointTo(Vector2f pos, float anisotropy = 1.0f) const;
+		[[nodiscard]] const Rect4f& getBoundingBox() const { return boundingBox; }
+		[[nodiscard]] Vector2f getScaleFactor() const { return scaleFactor; }
 		
 		// Returns empty if no collision is found (i.e. fully contained within navmesh)
 		// Otherwise returns collision point
@@ -133,12 +137,31 @@ namespace Halley {
 		void markPortalConnected(size_t idx);
 		void markPortalsDisconnected();
 
+		// Travel costs between pairs of portals of this navmesh (infinity if one can't be reached from the other), used by NavmeshSet's region graph.
+		// They only depend on this navmesh's own geometry, so they're computed once and kept when it's moved or linked again.
+		void computePortalCosts();
+		[[nodiscard]] bool hasPortalCosts() const;
+		[[nodiscard]] float getPortalCost(size_t fromPortal, size_t toPortal) const;
+		// Travel cost from pos to each portal, indexed like getPortals(). The search stops as soon as every portal has been reached.
+		[[nodiscard]] Vector<float> getPortalCostsFrom(Vector2f pos) const;
+
+		// Cost of reaching goal from every node, and the next hop towards it: the node to move into, and which of this node's connections leads there
+		// (unset on the goal's node and on unreachable nodes)
+		void computeCostsToGoal(Vector2f goal, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const;
+		// Cost of reaching the goal from each portal, indexed like getPortals(), given the node costs from computeCostsToGoal
+		[[nodiscard]] Vector<float> getPortalCostsToGoal(gsl::span<const float> nodeCosts) const;
+		// Same as computeCostsToGoal, for a goal outside of this navmesh: portalCosts is the cost of reaching it from each portal, indexed like getPortals().
+		// Nodes that should leave through portal i get NodeAndConn(-1, i) as their next hop.
+		void computeCostsToExits(gsl::span<const float> portalCosts, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const;
+
 		float getArea() const;
 		Vector2f getRandomPoint(Random& rng) const;
 
 		Base2D getNormalisedCoordinatesBase() const { return normalisedCoordinatesBase; }
 
 	private:
+		constexpr static int version = 1;
+
 		struct State {
 			float gScore = std::numeric_limits<float>::infinity();
 			float fScore = std::numeric_limits<float>::infinity();
@@ -149,7 +172,7 @@ namespace Halley {
 
 		class NodeComparator {
 		public:
-			NodeComparator(const Vector<State>& state) : state(state) {}
+			NodeComparator(SearchStateArray<State>& state) : state(state) {}
 			
 			bool operator()(Navmesh::NodeId a, Navmesh::NodeId b) const
 			{
@@ -157,7 +180,23 @@ namespace Halley {
 			}
 
 		private:
-			const Vector<State>& state;
+			SearchStateArray<State>& state;
+		};
+
+		struct CostSeed {
+			NodeId node;
+			NodeAndConn nextHop;
+			float cost;
+		};
+
+		// Reused by every search on the same thread
+		struct SearchContext {
+			SearchStateArray<State> state;
+			PriorityQueue<NodeId, NodeComparator> openSet;
+
+			SearchContext() : openSet(NodeComparator(state)) {}
+			SearchContext(const SearchContext&) = delete;
+			SearchContext& operator=(const SearchContext&) = delete;
 		};
 
 		Vector<Node> nodes;
@@ -169,6 +208,10 @@ namespace Halley {
 
 		Vector2i gridSize = Vector2i(20, 20);
 		Vector<Vector<NodeId>> polyGrid; // Quick lookup of polygons
+		Vector<Vector<uint32_t>> edgeGrid; // Indices into openEdges, for closest point queries outside of the navmesh
+		float minCellExtent = 0; // Shortest distance across a grid cell
+		bool gridCoversMesh = true; // False if some polygon sticks out of the grid, in which case edge searches can't stop early
+		Rect4f boundingBox;
 
 		Vector2f origin;
 		Base2D normalisedCoordinatesBase;
@@ -179,8 +222,14 @@ namespace Halley {
 
 		float totalArea = 0;
 
+		Vector<float> portalCosts; // portals.size() squared, row is the source portal
+
 		std::optional<Vector<NodeAndConn>> pathfind(int fromId, int toId) const;
-		Vector<NodeAndConn> makeResult(const Vector<State>& state, int startId, int endId) const;
+		Vector<NodeAndConn> makeResult(SearchStateArray<State>& state, int startId, int endId) const;
+		void computeCostsToPortals(gsl::span<const std::pair<NodeId, float>> sources, gsl::span<float> dst) const;
+		void computeCostsFromSeeds(gsl::span<const CostSeed> seeds, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const;
+		void getPortalNodes(const Portal& portal, Vector<NodeId>& dst) const;
+		static SearchContext& getSearchContext();
 		std::optional<NavigationPath> makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath) const;
 		void postProcessPath(Vector<Vector2f>& points, NavigationQuery::PostProcessingType type) const;
 
@@ -188,6 +237,9 @@ namespace Halley {
 		void addPolygonsToGrid();
 		void addPolygonToGrid(const Polygon& poly, NodeId idx);
 		gsl::span<const NodeId> getPolygonsAt(Vector2f pos, bool allowOutside) const;
+		Vector2i getGridCoordinates(Vector2f pos) const;
+		void addEdgesToGrid();
+		std::optional<std::pair<NodeId, Vector2f>> findClosestOpenEdge(Vector2f pos, float anisotropy, float maxDistance) const;
 
 		void addToPortals(NodeAndConn nodeAndConn, int id);
 		Portal& getPortals(int id);
@@ -16,7 +16,15 @@ namespace Halley {
 			std::function<float(int, const Polygon&)> getPolygonWeightCallback;
 		};
 
+		// Polygons generated for each cell of the bounds, kept between generations so regenerate() only has to redo the cells an obstacle change touches
+		class CellCache;
+
 		static NavmeshSet generate(const Params& params);
+		static NavmeshSet generate(const Params& params, CellCache& cache);
+
+		// Regenerates after changedObstacles were added, removed or moved (pass both their old and new shapes), reusing every cell they don't overlap.
+		// params.obstacles must still contain all current obstacles. Falls back to a full generation if the cache was built for different bounds or agent size.
+		static NavmeshSet regenerate(const Params& params, CellCache& cache, gsl::span<const Polygon> changedObstacles);
 
 	private:
 		enum class NavmeshNodePortalSide {
@@ -49,6 +57,9 @@ namespace Halley {
 		
 		constexpr static size_t maxPolygonSides = 8;
 
+		static void generateCells(const NavmeshBounds& bounds, gsl::span<const Polygon> obstacles, CellCache& cache, gsl::span<const size_t> cellIdxs);
+		static NavmeshSet generateFromCells(const Params& params, const CellCache& cache);
+
 		static Vector<Polygon> generateByPolygonSubtraction(gsl::span<const Polygon> inputPolygons, gsl::span<const Polygon> obstacles, Circle bounds);
 		static Vector<Polygon> preProcessObstacles(gsl::span<const Polygon> obstacles, float agentSize);
 		static Polygon makeAgentMask(float agentSize);
@@ -83,4 +94,28 @@ namespace Halley {
 
 		static Navmesh makeNavmesh(gsl::span<NavmeshNode> nodes, const NavmeshBounds& bounds, gsl::span<const NavmeshSubworldPortal> subworldPortals, int region, int subWorld, std::function<float(int, const Polygon&)> getPolygonWeightCallback);
 	};
+
+	class NavmeshGenerator::CellCache {
+	public:
+		[[nodiscard]] bool isEmpty() const { return cells.empty(); }
+		void clear() { cells.clear(); }
+
+		// How many cells the last generation actually had to build, the rest were reused
+		[[nodiscard]] size_t getNumCellsGenerated() const { return numCellsGenerated; }
+
+	private:
+		friend class NavmeshGenerator;
+
+		Vector<Vector<NavmeshNode>> cells; // Indexed by x * side1Divisions + y
+		Vector2f origin;
+		Vector2f side0;
+		Vector2f side1;
+		size_t side0Divisions = 0;
+		size_t side1Divisions = 0;
+		float agentSize = 0;
+		size_t numCellsGenerated = 0;
+
+		bool matches(const NavmeshBounds& bounds, float agentSize) const;
+		void reset(const NavmeshBounds& bounds, float agentSize);
+	};
 }
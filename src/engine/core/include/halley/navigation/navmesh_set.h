@@ -42,6 +42,10 @@ namespace Halley {
 
 		std::pair<uint16_t, uint16_t> getPortalDestination(uint16_t region, uint16_t edge) const;
 
+		// Cost of reaching a goal in goalRegion from each portal of every region, found with one search over the region graph.
+		// Indexed by region, then like that navmesh's getPortals(). goalPortalCosts are the goal region's own, see Navmesh::getPortalCostsToGoal.
+		Vector<Vector<float>> getPortalCostsToGoal(uint16_t goalRegion, gsl::span<const float> goalPortalCosts) const;
+
 	private:
 		struct PortalConnection {
 			uint16_t portalId;
@@ -87,7 +91,7 @@ namespace Halley {
 
 		class NodeComparator {
 		public:
-			NodeComparator(const Vector<State>& state) : state(state) {}
+			NodeComparator(SearchStateArray<State>& state) : state(state) {}
 			
 			bool operator()(NodeId a, NodeId b) const
 			{
@@ -95,12 +99,23 @@ namespace Halley {
 			}
 
 		private:
-			const Vector<State>& state;
+			SearchStateArray<State>& state;
+		};
+
+		// Reused by every search on the same thread
+		struct SearchContext {
+			SearchStateArray<State> state;
+			PriorityQueue<NodeId, NodeComparator> openSet;
+
+			SearchContext() : openSet(NodeComparator(state)) {}
+			SearchContext(const SearchContext&) = delete;
+			SearchContext& operator=(const SearchContext&) = delete;
 		};
 
 		Vector<Navmesh> navmeshes;
 		Vector<PortalNode> portalNodes;
 		Vector<RegionNode> regionNodes;
+		Vector2f heuristicScale = Vector2f(1, 1); // Lowest scale factor times lowest weight over every navmesh, so the region search heuristic never overestimates
 
 		void tryLinkNavMeshes(uint16_t idxA, uint16_t idxB);
 
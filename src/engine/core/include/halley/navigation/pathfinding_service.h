@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include "navigation_path.h"
+#include "navigation_query.h"
+#include "halley/concurrency/future.h"
+#include "halley/data_structures/vector.h"
+#include "halley/text/halleystring.h"
+
+namespace Halley {
+	class NavmeshSet;
+
+	// Runs NavmeshSet queries on the CPU aux workers, so many agents can repath on the same frame without stalling the caller.
+	// Requests are either queued with request() and sent as a single batch by flush(), with results picked up later through collectResults(),
+	// or submitted all at once with pathfind(), which returns a future for the whole batch.
+	// The navmesh set must not be modified (or reloaded) while requests are in flight; call wait() first.
+	class PathfindingService {
+	public:
+		using RequestId = uint32_t;
+
+		struct Request {
+			NavigationQuery query;
+			float anisotropy = 1.0f;
+			float nudge = 0.1f;
+
+			Request() = default;
+			Request(NavigationQuery query, float anisotropy = 1.0f, float nudge = 0.1f);
+		};
+
+		struct Result {
+			RequestId id = 0;
+			std::optional<NavigationPath> path;
+			String error;
+		};
+
+		explicit PathfindingService(std::shared_ptr<const NavmeshSet> navmeshSet, size_t requestsPerTask = 8);
+		~PathfindingService();
+
+		PathfindingService(const PathfindingService& other) = delete;
+		PathfindingService& operator=(const PathfindingService& other) = delete;
+
+		// Queues a request to be sent on the next flush(). The returned id is used to match it with its result.
+		RequestId request(Request request);
+		// Dispatches every queued request to the workers
+		void flush();
+		// Appends the results completed since the last call to dst, in completion order. Returns how many were added.
+		size_t collectResults(Vector<Result>& dst);
+
+		// Runs a batch independently of the request queue. Results are in the same order as the requests, with ids set to their indices.
+		Future<Vector<Result>> pathfind(Vector<Request> requests);
+
+		// Blocks until every dispatched request has completed
+		void wait();
+
+		size_t getNumQueued() const;
+		size_t getNumInFlight() const;
+
+	private:
+		struct Batch;
+
+		std::shared_ptr<const NavmeshSet> navmeshSet;
+		size_t requestsPerTask;
+
+		Vector<Request> queued;
+		Vector<RequestId> queuedIds;
+		RequestId nextId = 0;
+
+		mutable std::mutex completedMutex;
+		Vector<Result> completed;
+
+		Vector<Future<void>> tasks;
+		size_t nInFlight = 0;
+
+		void dispatch(std::shared_ptr<Batch> batch);
+		void runBatchRange(Batch& batch, size_t start, size_t end) const;
+		void pruneTasks();
+	};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include "halley/data_structures/vector.h"
+
+namespace Halley {
+	// Scratch state for graph searches, meant to be kept around (e.g. thread_local) and reused between queries.
+	// Starting a new search doesn't touch the entries: each one records the generation it was last written on, and is reset the first time it's accessed on a new generation.
+	template <typename State>
+	class SearchStateArray {
+	public:
+		void startSearch(size_t nNodes)
+		{
+			if (entries.size() < nNodes) {
+				entries.resize(nNodes);
+			}
+
+			if (++generation == 0) {
+				// Wrapped around, entries from 2^32 searches ago would look current
+				for (auto& e: entries) {
+					e.generation = 0;
+				}
+				generation = 1;
+			}
+		}
+
+		State& operator[](size_t idx)
+		{
+			auto& e = entries[idx];
+			if (e.generation != generation) {
+				e.state = State{};
+				e.generation = generation;
+			}
+			return e.state;
+		}
+
+	private:
+		struct Entry {
+			State state;
+			uint32_t generation = 0;
+		};
+
+		Vector<Entry> entries;
+		uint32_t generation = 0;
+	};
+}
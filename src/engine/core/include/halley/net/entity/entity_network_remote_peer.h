@@ -37,7 +37,8 @@ namespace Halley {
             bool alive = true;
             Time timeSinceSend = 0;
             EntityNetworkId networkId = 0;
-            EntityData data;
+            uint64_t revision = 0;
+            std::shared_ptr<const EntityData> data;
         };
 
         class InboundEntity {
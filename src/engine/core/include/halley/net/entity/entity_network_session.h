@@ -31,6 +31,16 @@ namespace Halley {
 
 	class EntityNetworkSession : NetworkSession::IListener, NetworkSession::ISharedDataHandler, public IWorldNetworkInterface {
     public:
+		// The state of an outbound entity for the current tick, serialized once and shared by all peers.
+		// Encoded messages are cached per baseline revision, so peers that are in sync get the same bytes.
+		class EntitySnapshot {
+		public:
+			uint64_t revision = 0;
+			std::shared_ptr<const EntityData> data;
+			std::optional<Bytes> createBytes;
+			HashMap<uint64_t, std::optional<Bytes>> updateBytes;
+		};
+
 		class IEntityNetworkSessionListener {
 		public:
 			virtual ~IEntityNetworkSessionListener() = default;
@@ -60,6 +70,8 @@ namespace Halley {
 
 		Time getMinSendInterval() const;
 
+		EntitySnapshot& getEntitySnapshot(EntityRef entity);
+
 		void onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId);
 		void requestSetupInterpolators(DataInterpolatorSet& interpolatorSet, EntityRef entity, bool remote);
 		void setupOutboundInterpolators(EntityRef entity);
@@ -113,6 +125,9 @@ namespace Halley {
 
 		HashMap<int, Vector<EntityNetworkMessage>> outbox;
 
+		HashMap<EntityId, EntitySnapshot> snapshots;
+		uint64_t nextSnapshotRevision = 1;
+
 		bool readyToStart = false;
 
 		bool canProcessMessage(const EntityNetworkMessage& msg) const;
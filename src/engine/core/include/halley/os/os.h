@@ -75,6 +75,7 @@ namespace Halley {
 		virtual void createDirectories(const Path& path);
 		virtual bool atomicWriteFile(const Path& path, gsl::span<const gsl::byte> data, std::optional<Path> backupOldVersionPath = {});
 		virtual Vector<Path> enumerateDirectory(const Path& path);
+		virtual std::unique_ptr<ResourceDataReader> mapFileToMemory(const Path& path);
 
 		virtual void setConsoleColor(int foreground, int background);
 		virtual int runCommand(String command, String cwd = "", ILoggerSink* sink = nullptr);
@@ -18,6 +18,10 @@ namespace Halley
 			String path;
 			Metadata meta;
 
+			// Location inside an asset pack. These aren't serialized with the entry, but in the pack's binary entry table.
+			uint64_t packPos = 0;
+			uint64_t packSize = 0;
+
 			Entry();
 			Entry(const String& path, const Metadata& meta);
 
@@ -41,6 +45,8 @@ namespace Halley
 			const HashMap<String, Entry>& getAssets() const;
 			AssetType getType() const;
 
+			void getEntriesSorted(Vector<Entry*>& dst);
+
 		private:
 			AssetType type;
 			HashMap<String, Entry> assets;
@@ -55,6 +61,10 @@ namespace Halley
 		void deserialize(Deserializer& s);
 		Vector<String> enumerate(AssetType type) const;
 
+		// Ordered by type and then name, which is stable across serialization
+		Vector<Entry*> getEntriesSorted();
+		Vector<const Entry*> getEntriesSorted() const;
+
 	private:
 		mutable TreeMap<int, TypedDB> dbs;
 	};
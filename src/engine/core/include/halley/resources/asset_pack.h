@@ -19,7 +19,23 @@ namespace Halley {
 		uint64_t assetDbStartPos;
 		uint64_t dataStartPos;
 
-		void init(size_t assetDbSize);
+		// Version 2 onwards, the location of each asset is stored in a binary table instead of being parsed from its path
+		uint64_t entryTableStartPos;
+		uint64_t entryTableCount;
+
+		constexpr static size_t headerSizeV1 = 8 + 16 + 8 + 8;
+
+		// Alignment of the data section and of each entry in it, for packs written with their index after the data
+		constexpr static size_t dataAlignment = 4096;
+		constexpr static size_t entryAlignment = 64;
+
+		void init(size_t assetDbSize, size_t entryCount);
+		void initWithTrailingIndex(uint64_t dataStart, uint64_t dataSize, size_t assetDbSize, size_t entryCount);
+	};
+
+	struct AssetPackEntryLocation {
+		uint64_t pos;
+		uint64_t size;
 	};
 
     class AssetPack {
@@ -40,6 +56,9 @@ namespace Halley {
 
 		Bytes writeOut() const;
 
+		// For packs whose data was written out separately (e.g. streamed to disk), fills in the header and returns the index that goes right after the data
+		Bytes writeOutIndex(AssetPackHeader& header, uint64_t dataStartPos, uint64_t dataSize) const;
+
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream);
 
 		void readToMemory();
@@ -51,6 +70,7 @@ namespace Halley {
 		std::unique_ptr<ResourceDataReader> extractReader();
 
 		std::shared_ptr<bool> getAliveToken() const;
+		bool isMemoryMapped() const;
 
     private:
 		std::unique_ptr<AssetDatabase> assetDb;
@@ -59,8 +79,12 @@ namespace Halley {
 		std::mutex readerMutex;
 		size_t dataOffset = 0;
 		Bytes data;
+		std::shared_ptr<const char> mappedData;
+		size_t mappedSize = 0;
 		std::array<char, 16> iv;
 		mutable std::shared_ptr<bool> aliveToken;
+
+		void readEntryLocations(const AssetPackHeader& header, bool hasEntryTable);
     };
 
 
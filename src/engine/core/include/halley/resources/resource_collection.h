@@ -4,7 +4,11 @@
 #include <memory>
 #include <functional>
 #include <shared_mutex>
+#include <future>
+#include <thread>
+#include <gsl/span>
 #include <halley/concurrency/shared_recursive_mutex.h>
+#include <halley/concurrency/concurrent.h>
 #include <halley/text/halleystring.h>
 #include <halley/resources/resource_data.h>
 #include <halley/data_structures/hash_map.h>
@@ -31,6 +35,14 @@ namespace Halley
 			int depth;
 		};
 
+		// An asset that is currently being loaded; other threads requesting it wait on this instead of the whole collection
+		class PendingLoad
+		{
+		public:
+			std::thread::id loadingThread;
+			std::shared_future<std::shared_ptr<Resource>> result;
+		};
+
 	public:
 		using ResourceLoaderFunc = std::function<std::shared_ptr<Resource>(std::string_view, ResourceLoadPriority)>;
 		using ResourceEnumeratorFunc = std::function<Vector<String>()>;
@@ -53,6 +65,10 @@ namespace Halley
 
 		std::shared_ptr<Resource> getUntyped(std::string_view name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
 
+		// Loads on the disk IO executors. Failed loads are logged and resolve to nullptr.
+		Future<std::shared_ptr<Resource>> getUntypedAsync(std::string_view name, ResourceLoadPriority priority = ResourceLoadPriority::Normal);
+		Future<void> preload(gsl::span<const String> names, ResourceLoadPriority priority = ResourceLoadPriority::Low);
+
 		Vector<String> enumerate() const;
 
 		AssetType getAssetType() const;
@@ -69,11 +85,13 @@ namespace Halley
 		virtual std::shared_ptr<Resource> loadResource(ResourceLoader& loader) = 0;
 
 		std::shared_ptr<Resource> doGet(std::string_view name, ResourceLoadPriority priority, bool allowFallback);
+		std::shared_ptr<Resource> doTryGet(std::string_view name, ResourceLoadPriority priority);
 		std::pair<std::shared_ptr<Resource>, bool> loadAsset(std::string_view assetId, ResourceLoadPriority priority, bool allowFallback);
 
 	private:
 		Resources& parent;
 		HashMap<String, Wrapper> resources;
+		HashMap<String, std::shared_ptr<PendingLoad>> pendingLoads;
 		String fallback;
 		AssetType type;
 		ResourceLoaderFunc resourceLoader;
@@ -96,6 +114,14 @@ namespace Halley
 			return std::static_pointer_cast<T>(doGet(assetId, priority, true));
 		}
 
+		Future<std::shared_ptr<const T>> getAsync(std::string_view assetId, ResourceLoadPriority priority = ResourceLoadPriority::Normal)
+		{
+			return Concurrent::execute(Executors::getDiskIO(), [this, assetId = String(assetId), priority] () -> std::shared_ptr<const T>
+			{
+				return std::static_pointer_cast<T>(doTryGet(assetId, priority));
+			});
+		}
+
 	protected:
 		std::shared_ptr<Resource> loadResource(ResourceLoader& loader) override {
 			return T::loadResource(loader);
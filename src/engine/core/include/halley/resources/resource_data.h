@@ -42,9 +42,31 @@ namespace Halley {
 		virtual void close() = 0;
 		virtual bool isAvailable() const { return true; }
 
+		// Readers backed by memory (e.g. a mapped file) can expose their whole contents, allowing zero-copy access
+		virtual gsl::span<const gsl::byte> getMappedData() const { return {}; }
+
 		Bytes readAll();
 	};
 
+	class ResourceDataReaderMemoryMapped final : public ResourceDataReader {
+	public:
+		using UnmapCallback = std::function<void()>;
+
+		ResourceDataReaderMemoryMapped(gsl::span<const gsl::byte> data, UnmapCallback unmap);
+		~ResourceDataReaderMemoryMapped() override;
+		size_t size() const override;
+		int read(gsl::span<gsl::byte> dst) override;
+		void seek(int64_t pos, int whence) override;
+		size_t tell() const override;
+		void close() override;
+		gsl::span<const gsl::byte> getMappedData() const override;
+
+	private:
+		gsl::span<const gsl::byte> data;
+		UnmapCallback unmap;
+		size_t curPos = 0;
+	};
+
 	class ResourceDataReaderFileSystem : public ResourceDataReader {
 	public:
 		ResourceDataReaderFileSystem(Path path);
@@ -75,6 +97,7 @@ namespace Halley {
 	public:
 		ResourceDataStatic(String path);
 		ResourceDataStatic(const void* data, size_t size, String path, bool owning = true);
+		ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path);
 
 		void set(const void* data, size_t size, bool owning = true);
 		bool isLoaded() const;
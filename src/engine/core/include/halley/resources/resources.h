@@ -66,12 +66,24 @@ namespace Halley {
 			return of<T>().get(name, priority);
 		}
 
+		template <typename T>
+		Future<std::shared_ptr<const T>> getAsync(std::string_view name, ResourceLoadPriority priority = ResourceLoadPriority::Normal) const
+		{
+			return of<T>().getAsync(name, priority);
+		}
+
 		template <typename T>
 		void preload(std::string_view name) const
 		{
 			static_cast<void>(of<T>().get(name, ResourceLoadPriority::Low));
 		}
 
+		template <typename T>
+		Future<void> preload(gsl::span<const String> names) const
+		{
+			return of<T>().preload(names, ResourceLoadPriority::Low);
+		}
+
 		template <typename T>
 		void preloadAll() const
 		{
@@ -5,6 +5,7 @@
 #include "halley/bytes/config_node_serializer.h"
 #include "halley/graph/base_graph.h"
 #include "halley/utils/hash.h"
+#include "halley/support/profiler.h"
 
 namespace Halley {
 	class IScriptNodeType;
@@ -134,6 +135,8 @@ namespace Halley {
 
 		const ScriptGraph* getPreviousVersion(uint64_t hash) const;
 
+		ProfilerNameId getProfilerName() const;
+
 	private:
 		Vector<std::pair<GraphNodeId, GraphNodeId>> callerToCallee;
 		Vector<std::pair<GraphNodeId, GraphNodeId>> returnToCaller;
@@ -141,6 +144,7 @@ namespace Halley {
 
 		uint64_t hash = 0;
 		mutable uint64_t lastAssignTypeHash = 1;
+		mutable ProfilerNameId profilerName = 0;
 
 		ScriptGraphNodeRoots roots;
 
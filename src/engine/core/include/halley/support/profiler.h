@@ -4,6 +4,8 @@
 #include <thread>
 #include <gsl/span>
 #include <atomic>
+#include <deque>
+#include <mutex>
 
 #include "halley/data_structures/hash_map.h"
 #include "halley/time/halleytime.h"
@@ -48,6 +50,8 @@ namespace Halley {
         UserDefined
     };	
 
+	using ProfilerNameId = uint32_t;
+
     class ProfilerData {
     public:
         using TimePoint = std::chrono::steady_clock::time_point;
@@ -64,7 +68,7 @@ namespace Halley {
 
 		class Event {
         public:
-	        String name;
+	        ProfilerNameId name;
         	std::thread::id threadId;
 			ProfilerEventType type;
 			int16_t depth;
@@ -94,6 +98,7 @@ namespace Halley {
     	const Vector<Event>& getEvents() const;
     	Duration getTotalElapsedTime() const;
 		Duration getElapsedTime(ProfilerEventType eventType) const;
+		const String& getEventName(const Event& event) const;
 
     	gsl::span<const ThreadInfo> getThreads() const;
 
@@ -111,13 +116,19 @@ namespace Halley {
     public:
         using EventId = uint64_t;
     	
-        ProfilerCapture(size_t maxEvents = 16384);
+        ProfilerCapture(size_t maxEventsPerThread = 8192);
+    	~ProfilerCapture();
     	
     	[[nodiscard]] static ProfilerCapture& get();
 
-    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, std::string_view name);
+    	// Names are interned once (e.g. when a system is named) and referenced by id afterwards, so recording an event never locks or allocates.
+    	// Id 0 is always the empty name.
+    	[[nodiscard]] static ProfilerNameId internName(std::string_view name);
+    	[[nodiscard]] static const String& getName(ProfilerNameId id);
+
+    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, ProfilerNameId name);
     	void recordEventEnd(EventId id);
-    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, std::string_view name, std::chrono::steady_clock::time_point time);
+    	[[nodiscard]] EventId recordEventStart(ProfilerEventType type, ProfilerNameId name, std::chrono::steady_clock::time_point time);
     	void recordEventEnd(EventId id, std::chrono::steady_clock::time_point time);
 
     	[[nodiscard]] bool isRecording() const;
@@ -135,21 +146,44 @@ namespace Halley {
     		FrameEnded
     	};
 
+    	// Each thread writes only to its own ring buffer, so recording is wait-free.
+    	// Slots are published with a sequence number, which lets the reader discard any slot that was overwritten while being copied.
+    	struct EventSlot {
+    		std::atomic<uint64_t> seq;
+    		std::atomic<int64_t> startTime;
+    		std::atomic<int64_t> endTime;
+    		std::atomic<ProfilerNameId> name;
+    		std::atomic<ProfilerEventType> type;
+    	};
+
+    	struct ThreadBuffer {
+    		ThreadBuffer(size_t capacity, uint16_t index);
+
+    		std::thread::id threadId;
+    		uint16_t index;
+    		std::unique_ptr<EventSlot[]> slots;
+    		size_t mask;
+    		std::atomic<uint64_t> head;
+    		uint64_t frameStart = 0;
+    	};
+
     	std::atomic<bool> recording;
-    	std::atomic<uint64_t> curId;
-    	uint64_t startId;
-    	std::atomic<uint64_t> endId;
+    	const size_t maxEventsPerThread;
         State state = State::Idle;
     	
     	std::chrono::steady_clock::time_point frameStartTime;
     	std::chrono::steady_clock::time_point frameEndTime;
 
-    	Vector<ProfilerData::Event> events;
+    	std::mutex threadBuffersMutex;
+    	std::deque<ThreadBuffer> threadBuffers;
+
+    	ThreadBuffer& getThreadBuffer();
+    	ThreadBuffer& registerThreadBuffer();
     };
 
 	class ProfilerEvent {
 	public:
-		ProfilerEvent(ProfilerEventType type, std::string_view name = "");
+		ProfilerEvent(ProfilerEventType type, ProfilerNameId name = 0);
 		~ProfilerEvent() noexcept;
 
 		ProfilerEvent(const ProfilerEvent& other) = delete;
@@ -158,6 +192,6 @@ namespace Halley {
 		ProfilerEvent& operator=(ProfilerEvent&& other) = delete;
 
 	private:
-		ProfilerCapture::EventId id;
+		ProfilerCapture::EventId id = 0;
 	};
 }
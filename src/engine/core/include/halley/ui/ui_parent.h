@@ -35,7 +35,12 @@ namespace Halley {
 		bool removeDeadChildren();
 		bool isWaitingToSpawnChildren() const;
 
+		// Invalidates both the measured size and the placement of children
 		virtual void markAsNeedingLayout();
+		// Invalidates only the placement of children, e.g. when one of them was moved by hand
+		virtual void markLayoutDirty();
+		// Called by children when something below them needs layout. sizeChanged is false if their measured size is known to be unaffected.
+		virtual void markDescendantAsNeedingLayout(bool sizeChanged);
 		virtual void onChildrenAdded() {}
 		virtual void onChildrenRemoved() {}
 		virtual void onChildAdded(UIWidget& child) {}
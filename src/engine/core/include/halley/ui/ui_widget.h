@@ -170,7 +170,10 @@ namespace Halley {
 		std::optional<AudioHandle> playSound(const String& eventName);
 
 		bool needsLayout() const;
+		bool hasPendingLayout() const;
 		void markAsNeedingLayout() final override;
+		void markLayoutDirty() final override;
+		void markDescendantAsNeedingLayout(bool sizeChanged) final override;
 
 		virtual bool canReceiveFocus() const;
 		std::shared_ptr<UIWidget> getFocusableOrAncestor();
@@ -210,6 +213,8 @@ namespace Halley {
 		virtual TextInputData *getTextInputData();
 
 		virtual void onLayout();
+		// Return false if getLayoutMinimumSize() can't change when children change, so invalidation stops here instead of reaching the parent
+		virtual bool childrenAffectLayoutSize() const;
 		virtual bool onDestroyRequested();
 		virtual void onParentChanged();
 		virtual void onActiveChanged(bool active);
@@ -240,6 +245,7 @@ namespace Halley {
 		void notifyTreeRemovedFromRoot(UIRoot& root);
 
 		void setWidgetRect(Rect4f rect);
+		void layoutDirtyChildren();
 		void resetInputResults();
 		void updateActive(bool wasActiveBefore);
 		void notifyActivationChange(bool active);
@@ -258,6 +264,8 @@ namespace Halley {
 		UIInputType lastInputType = UIInputType::Undefined;
 	private:
 		mutable int layoutNeeded = 1;
+		Rect4f lastLayoutRect;
+		Rect4f lastSizerRect;
 		
 		Vector2f position;
 		Vector2f size;
@@ -286,6 +294,8 @@ namespace Halley {
 		bool focused = false;
 		bool mouseOver = false;
 		bool positionUpdated = false;
+		bool layoutDirty = true;
+		bool descendantLayoutDirty = false;
 		bool modal = true;
 		bool mouseBlocker = true;
 		bool mouseInteraction = false;
@@ -55,6 +55,7 @@ namespace Halley {
 	    void drawChildren(UIPainter& painter) const override;
 	    Vector2f getLayoutMinimumSize(bool force) const override;
 	    Vector2f getLayoutOriginPosition() const override;
+	    bool childrenAffectLayoutSize() const override;
 	    bool canInteractWithMouse() const override;
 		void onLayout() override;
 
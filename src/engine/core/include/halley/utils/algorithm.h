@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cassert>
 #include <set>
 #include <map>
 #include "halley/data_structures/vector.h"
@@ -183,6 +185,50 @@ namespace Halley
 			std::swap(begin[i], begin[j]);
 		}
 	}
+
+	// Stable LSD radix sort of values by their keys, one byte at a time. Bytes that are the same for every key are skipped.
+	// The scratch vectors are just storage, pass the same ones every time to avoid reallocating.
+	template <typename T>
+	void radixSortStable(Vector<T>& values, Vector<uint64_t>& keys, Vector<T>& valuesScratch, Vector<uint64_t>& keysScratch)
+	{
+		const size_t n = values.size();
+		assert(keys.size() == n);
+
+		bool sorted = true;
+		for (size_t i = 1; i < n && sorted; ++i) {
+			sorted = keys[i - 1] <= keys[i];
+		}
+		if (sorted) {
+			return;
+		}
+
+		valuesScratch.resize(n, values[0]);
+		keysScratch.resize(n);
+		std::array<size_t, 256> offsets;
+		for (int shift = 0; shift < 64; shift += 8) {
+			offsets.fill(0);
+			for (size_t i = 0; i < n; ++i) {
+				++offsets[(keys[i] >> shift) & 0xFF];
+			}
+			if (offsets[(keys[0] >> shift) & 0xFF] == n) {
+				continue;
+			}
+
+			size_t total = 0;
+			for (auto& o: offsets) {
+				const auto count = o;
+				o = total;
+				total += count;
+			}
+			for (size_t i = 0; i < n; ++i) {
+				const auto dst = offsets[(keys[i] >> shift) & 0xFF]++;
+				valuesScratch[dst] = std::move(values[i]);
+				keysScratch[dst] = keys[i];
+			}
+			std::swap(values, valuesScratch);
+			std::swap(keys, keysScratch);
+		}
+	}
 }
 
 namespace std_ex {
@@ -0,0 +1,163 @@
+#include "halley/data_structures/frame_arena.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace Halley;
+
+namespace {
+	constexpr size_t minBlockSize = 64 * 1024;
+
+	struct alignas(std::max_align_t) Block
+	{
+		Block* prev;
+		size_t size;
+
+		char* getData() { return reinterpret_cast<char*>(this + 1); }
+	};
+
+	std::atomic<uint64_t> frameIndex = 0;
+
+	class ThreadArena
+	{
+	public:
+		~ThreadArena()
+		{
+			releaseBlocks();
+		}
+
+		void* alloc(size_t size, size_t alignment)
+		{
+			const auto curFrame = frameIndex.load(std::memory_order_relaxed);
+			if (curFrame != frame) {
+				onNewFrame(curFrame);
+			}
+
+			char* result = block ? alignPointer(pos, alignment) : nullptr;
+			if (!block || result > end || size_t(end - result) < size) {
+				addBlock(size + alignment);
+				result = alignPointer(pos, alignment);
+			}
+
+			used += size_t(result + size - pos);
+			framePeak = std::max(framePeak, used);
+			pos = result + size;
+			++live;
+			return result;
+		}
+
+		void free(void* p, size_t size) noexcept
+		{
+			if (!p) {
+				return;
+			}
+
+			if (--live == 0) {
+				rewind();
+			} else if (static_cast<char*>(p) + size == pos) {
+				// Last allocation, can be reclaimed straight away
+				pos = static_cast<char*>(p);
+			}
+		}
+
+		size_t getReservedBytes() const
+		{
+			return reserved;
+		}
+
+	private:
+		Block* block = nullptr;
+		char* pos = nullptr;
+		char* end = nullptr;
+		size_t live = 0;
+		size_t used = 0;
+		size_t reserved = 0;
+		size_t framePeak = 0;
+		uint64_t frame = 0;
+
+		static char* alignPointer(char* p, size_t alignment)
+		{
+			const auto addr = reinterpret_cast<uintptr_t>(p);
+			return p + ((alignment - (addr % alignment)) % alignment);
+		}
+
+		void addBlock(size_t minSize)
+		{
+			// Grow geometrically, so a thread that needs a lot of transient memory settles on a few large blocks
+			const size_t size = std::max({ minBlockSize, minSize, reserved });
+			auto* newBlock = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+			if (!newBlock) {
+				throw std::bad_alloc();
+			}
+			newBlock->prev = block;
+			newBlock->size = size;
+
+			block = newBlock;
+			pos = block->getData();
+			end = pos + size;
+			reserved += size;
+		}
+
+		void releaseBlocks()
+		{
+			while (block) {
+				auto* prev = block->prev;
+				std::free(block);
+				block = prev;
+			}
+			pos = nullptr;
+			end = nullptr;
+			reserved = 0;
+		}
+
+		void rewind()
+		{
+			used = 0;
+			if (!block) {
+				return;
+			}
+
+			if (block->prev) {
+				// Replace the chain with a single block that fits everything it held
+				const size_t total = reserved;
+				releaseBlocks();
+				addBlock(total);
+			} else {
+				pos = block->getData();
+			}
+		}
+
+		void onNewFrame(uint64_t curFrame)
+		{
+			// Give back memory that the last frame didn't need. Allocations still live from an earlier frame keep the arena as it is.
+			frame = curFrame;
+			if (live == 0 && reserved > 2 * std::max(framePeak, minBlockSize)) {
+				releaseBlocks();
+			}
+			framePeak = used;
+		}
+	};
+
+	thread_local ThreadArena threadArena;
+}
+
+void* FrameArena::alloc(size_t size, size_t alignment)
+{
+	return threadArena.alloc(size, alignment);
+}
+
+void FrameArena::free(void* p, size_t size) noexcept
+{
+	threadArena.free(p, size);
+}
+
+void FrameArena::endFrame()
+{
+	frameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t FrameArena::getReservedBytes()
+{
+	return threadArena.getReservedBytes();
+}
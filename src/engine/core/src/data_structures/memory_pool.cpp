@@ -1,52 +1,344 @@
-#define _LIBCPP_DISABLE_DEPRECATION_WARNINGS
-#include <boost/pool/pool.hpp>
 #include "halley/data_structures/memory_pool.h"
+#include "halley/utils/utils.h"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <gsl/gsl_assert>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
 
 using namespace Halley;
 
-PoolPool& PoolPool::get()
+namespace {
+	// Size classes are 16-byte steps up to 256 bytes, then four steps per power of two up to 4 KiB
+	constexpr size_t maxPooledSize = 4096;
+	constexpr int numSmallClasses = 16;
+	constexpr int numSizeClasses = numSmallClasses + 4 * 4;
+
+	// Slabs are aligned to their own size, so the header of the slab owning any object is found by masking its address
+	constexpr size_t slabSize = 64 * 1024;
+	constexpr size_t slabHeaderSize = 64;
+	constexpr size_t cacheLineSize = 64;
+
+	constexpr int64_t statsFlushThreshold = 32;
+
+	int getSizeClass(size_t size)
+	{
+		if (size <= 256) {
+			return static_cast<int>(std::max(size, size_t(1)) + 15) / 16 - 1;
+		}
+		const int log = fastLog2Floor(static_cast<uint32_t>(size - 1));
+		const int sub = static_cast<int>((size - 1) >> (log - 2));
+		return numSmallClasses + (log - 8) * 4 + (sub - 4);
+	}
+
+	size_t getSizeClassSize(int sizeClass)
+	{
+		if (sizeClass < numSmallClasses) {
+			return size_t(sizeClass + 1) * 16;
+		}
+		const int k = sizeClass - numSmallClasses;
+		return size_t(4 + k % 4 + 1) << (8 + k / 4 - 2);
+	}
+
+	void* allocateSlab()
+	{
+#ifdef _MSC_VER
+		void* result = _aligned_malloc(slabSize, slabSize);
+#else
+		void* result = nullptr;
+		if (posix_memalign(&result, slabSize, slabSize) != 0) {
+			result = nullptr;
+		}
+#endif
+		if (!result) {
+			throw std::bad_alloc();
+		}
+		return result;
+	}
+
+	struct FreeNode
+	{
+		FreeNode* next;
+	};
+
+	struct alignas(cacheLineSize) Bin
+	{
+		// Only touched by the thread owning the cache
+		FreeNode* localFree = nullptr;
+		char* bumpPos = nullptr;
+		char* bumpEnd = nullptr;
+		int64_t pendingLive = 0;
+
+		// Objects freed by other threads, pushed lock-free and taken all at once by the owner
+		alignas(cacheLineSize) std::atomic<FreeNode*> remoteFree = nullptr;
+	};
+
+	struct ThreadCache
+	{
+		std::array<Bin, numSizeClasses> bins;
+		ThreadCache* nextReleased = nullptr;
+	};
+
+	struct SlabHeader
+	{
+		ThreadCache* owner;
+		int sizeClass;
+	};
+	static_assert(sizeof(SlabHeader) <= slabHeaderSize);
+
+	struct alignas(cacheLineSize) SizeClassStats
+	{
+		std::atomic<int64_t> live = 0;
+		std::atomic<int64_t> peak = 0;
+		std::atomic<size_t> reserved = 0;
+	};
+
+	// Thread caches are never freed. When a thread exits its cache (with its slabs and pending remote frees) is parked and adopted by the next new thread.
+	struct AllocatorState
+	{
+		std::array<SizeClassStats, numSizeClasses> stats;
+		std::mutex cacheMutex;
+		ThreadCache* releasedCaches = nullptr;
+	};
+
+	AllocatorState& getState()
+	{
+		static AllocatorState* state = new AllocatorState();
+		return *state;
+	}
+
+	ThreadCache* acquireCache()
+	{
+		auto& state = getState();
+		std::unique_lock lock(state.cacheMutex);
+		if (auto* cache = state.releasedCaches) {
+			state.releasedCaches = cache->nextReleased;
+			cache->nextReleased = nullptr;
+			return cache;
+		}
+		return new ThreadCache();
+	}
+
+	void flushStats(Bin& bin, int sizeClass);
+
+	void releaseCache(ThreadCache* cache)
+	{
+		for (int i = 0; i < numSizeClasses; ++i) {
+			flushStats(cache->bins[i], i);
+		}
+
+		auto& state = getState();
+		std::unique_lock lock(state.cacheMutex);
+		cache->nextReleased = state.releasedCaches;
+		state.releasedCaches = cache;
+	}
+
+	thread_local ThreadCache* threadCache = nullptr;
+	thread_local bool threadCacheReleased = false;
+
+	struct ThreadCacheGuard
+	{
+		bool active = false;
+
+		~ThreadCacheGuard()
+		{
+			if (threadCache) {
+				releaseCache(threadCache);
+				threadCache = nullptr;
+			}
+			threadCacheReleased = true;
+		}
+	};
+	thread_local ThreadCacheGuard threadCacheGuard;
+
+	ThreadCache& getThreadCache()
+	{
+		if (!threadCache) {
+			threadCache = acquireCache();
+			if (!threadCacheReleased) {
+				// Anything allocated during thread teardown keeps its cache for the rest of the process
+				threadCacheGuard.active = true;
+			}
+		}
+		return *threadCache;
+	}
+
+	void flushStats(Bin& bin, int sizeClass)
+	{
+		if (bin.pendingLive == 0) {
+			return;
+		}
+
+		auto& stats = getState().stats[sizeClass];
+		const int64_t live = stats.live.fetch_add(bin.pendingLive, std::memory_order_relaxed) + bin.pendingLive;
+		bin.pendingLive = 0;
+
+		int64_t peak = stats.peak.load(std::memory_order_relaxed);
+		while (live > peak && !stats.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+	}
+
+	void addLive(Bin& bin, int sizeClass, int64_t delta)
+	{
+		bin.pendingLive += delta;
+		if (bin.pendingLive >= statsFlushThreshold || bin.pendingLive <= -statsFlushThreshold) {
+			flushStats(bin, sizeClass);
+		}
+	}
+
+	void refillBin(ThreadCache& cache, Bin& bin, int sizeClass)
+	{
+		const size_t objSize = getSizeClassSize(sizeClass);
+		const size_t capacity = (slabSize - slabHeaderSize) / objSize;
+
+		auto* slab = static_cast<char*>(allocateSlab());
+		new (slab) SlabHeader{ &cache, sizeClass };
+		bin.bumpPos = slab + slabHeaderSize;
+		bin.bumpEnd = bin.bumpPos + capacity * objSize;
+
+		getState().stats[sizeClass].reserved.fetch_add(slabSize, std::memory_order_relaxed);
+	}
+
+	void* allocFromClass(int sizeClass)
+	{
+		auto& cache = getThreadCache();
+		auto& bin = cache.bins[sizeClass];
+
+		if (!bin.localFree) {
+			// Only look at remote frees once the current slab is used up, then take them all in one go
+			const size_t objSize = getSizeClassSize(sizeClass);
+			if (size_t(bin.bumpEnd - bin.bumpPos) >= objSize) {
+				void* result = bin.bumpPos;
+				bin.bumpPos += objSize;
+				addLive(bin, sizeClass, 1);
+				return result;
+			}
+
+			bin.localFree = bin.remoteFree.exchange(nullptr, std::memory_order_acquire);
+			if (!bin.localFree) {
+				refillBin(cache, bin, sizeClass);
+				return allocFromClass(sizeClass);
+			}
+		}
+
+		auto* node = bin.localFree;
+		bin.localFree = node->next;
+		addLive(bin, sizeClass, 1);
+		return node;
+	}
+
+	void freeToClass(void* p, int sizeClass)
+	{
+		const auto* slab = reinterpret_cast<const SlabHeader*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(slabSize - 1));
+		Expects(slab->sizeClass == sizeClass);
+
+		auto* node = static_cast<FreeNode*>(p);
+		auto* cache = threadCache;
+		if (slab->owner == cache) {
+			auto& bin = cache->bins[sizeClass];
+			node->next = bin.localFree;
+			bin.localFree = node;
+		} else {
+			auto& remote = slab->owner->bins[sizeClass].remoteFree;
+			node->next = remote.load(std::memory_order_relaxed);
+			while (!remote.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+		}
+
+		if (cache) {
+			addLive(cache->bins[sizeClass], sizeClass, -1);
+		} else {
+			getState().stats[sizeClass].live.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+float SizePoolStats::getFragmentation() const
 {
-	static PoolPool* pools = nullptr;
-	if (!pools) {
-		pools = new PoolPool();
+	return reservedBytes > 0 ? 1.0f - float(std::min(liveBytes, reservedBytes)) / float(reservedBytes) : 0.0f;
+}
+
+PoolPool::PoolPool()
+{
+	pools.reserve(numSizeClasses);
+	for (int i = 0; i < numSizeClasses; ++i) {
+		pools.emplace_back(getSizeClassSize(i));
 	}
+}
+
+PoolPool& PoolPool::get()
+{
+	static PoolPool* pools = new PoolPool();
 	return *pools;
 }
 
 SizePool* PoolPool::getPool(size_t size)
 {
-	auto& pools = get().pools;
-	auto iter = pools.find(size);
-	if (iter != pools.end()) {
-		return iter->second;
+	auto& pp = get();
+	if (size <= maxPooledSize) {
+		return &pp.pools[getSizeClass(size)];
 	}
 
-	auto pool = new SizePool(size);
-	pools[size] = pool;
-	return pool;
+	std::unique_lock lock(pp.oversizedMutex);
+	auto& pool = pp.oversized[size];
+	if (!pool) {
+		pool = std::make_unique<SizePool>(size);
+	}
+	return pool.get();
 }
 
-typedef boost::pool<boost::default_user_allocator_malloc_free> PoolType;
+Vector<SizePoolStats> PoolPool::getStats()
+{
+	Vector<SizePoolStats> result;
+	for (const auto& pool: get().pools) {
+		auto stats = pool.getStats();
+		if (stats.reservedBytes > 0) {
+			result.push_back(stats);
+		}
+	}
+	return result;
+}
 
 SizePool::SizePool(size_t size)
 	: size(size)
+	, sizeClass(size <= maxPooledSize ? getSizeClass(size) : -1)
 {
-	pimpl = new PoolType(size);
 }
 
-SizePool::~SizePool()
+void* SizePool::alloc()
 {
-	delete reinterpret_cast<PoolType*>(pimpl);
+	if (sizeClass < 0) {
+		if (void* result = std::malloc(size)) {
+			return result;
+		}
+		throw std::bad_alloc();
+	}
+	return allocFromClass(sizeClass);
 }
 
-void* SizePool::alloc()
+void SizePool::free(void* p)
 {
-	std::unique_lock lock(mutex);
-	return reinterpret_cast<PoolType*>(pimpl)->malloc();
+	if (!p) {
+		return;
+	}
+	if (sizeClass < 0) {
+		std::free(p);
+	} else {
+		freeToClass(p, sizeClass);
+	}
 }
 
-void SizePool::free(void* p)
+SizePoolStats SizePool::getStats() const
 {
-	std::unique_lock lock(mutex);
-	reinterpret_cast<PoolType*>(pimpl)->free(p);
+	SizePoolStats result;
+	result.objectSize = sizeClass < 0 ? size : getSizeClassSize(sizeClass);
+	if (sizeClass >= 0) {
+		const auto& stats = getState().stats[sizeClass];
+		result.liveBytes = size_t(std::max(stats.live.load(std::memory_order_relaxed), int64_t(0))) * result.objectSize;
+		result.peakLiveBytes = size_t(stats.peak.load(std::memory_order_relaxed)) * result.objectSize;
+		result.reservedBytes = stats.reserved.load(std::memory_order_relaxed);
+	}
+	return result;
 }
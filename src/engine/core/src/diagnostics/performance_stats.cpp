@@ -112,9 +112,9 @@ void PerformanceStatsView::onProfileData(std::shared_ptr<ProfilerData> data)
 	}
 	for (const auto& e: data->getEvents()) {
 		if (e.type == ProfilerEventType::WorldSystemUpdate || e.type == ProfilerEventType::WorldSystemRender) {
-			systemHistory[e.name].update(e.type, (e.endTime - e.startTime).count());
+			systemHistory[data->getEventName(e)].update(e.type, (e.endTime - e.startTime).count());
 		} else if (e.type == ProfilerEventType::ScriptUpdate) {
-			scriptHistory[e.name].update(e.type, (e.endTime - e.startTime).count());
+			scriptHistory[data->getEventName(e)].update(e.type, (e.endTime - e.startTime).count());
 		}
 	}
 	std_ex::erase_if_value(systemHistory, [&](const auto& e) { return !e.isVisited(); });
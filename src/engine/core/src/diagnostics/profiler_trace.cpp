@@ -0,0 +1,193 @@
+#include "halley/diagnostics/profiler_trace.h"
+#include <string>
+
+using namespace Halley;
+
+namespace {
+	const char* getEventTypeName(ProfilerEventType type)
+	{
+		switch (type) {
+		case ProfilerEventType::CorePumpEvents: return "CorePumpEvents";
+		case ProfilerEventType::CoreDevConClient: return "CoreDevConClient";
+		case ProfilerEventType::CorePumpAudio: return "CorePumpAudio";
+		case ProfilerEventType::CoreFixedUpdate: return "CoreFixedUpdate";
+		case ProfilerEventType::CoreVariableUpdate: return "CoreVariableUpdate";
+		case ProfilerEventType::CoreUpdateSystem: return "CoreUpdateSystem";
+		case ProfilerEventType::CoreUpdatePlatform: return "CoreUpdatePlatform";
+		case ProfilerEventType::CoreUpdate: return "CoreUpdate";
+		case ProfilerEventType::CoreStartRender: return "CoreStartRender";
+		case ProfilerEventType::CoreRender: return "CoreRender";
+		case ProfilerEventType::CoreVSync: return "CoreVSync";
+		case ProfilerEventType::PainterDrawCall: return "PainterDrawCall";
+		case ProfilerEventType::PainterEndRender: return "PainterEndRender";
+		case ProfilerEventType::PainterUpdateProjection: return "PainterUpdateProjection";
+		case ProfilerEventType::WorldVariableUpdate: return "WorldVariableUpdate";
+		case ProfilerEventType::WorldFixedUpdate: return "WorldFixedUpdate";
+		case ProfilerEventType::WorldRender: return "WorldRender";
+		case ProfilerEventType::WorldSystemUpdate: return "WorldSystemUpdate";
+		case ProfilerEventType::WorldSystemRender: return "WorldSystemRender";
+		case ProfilerEventType::ScriptUpdate: return "ScriptUpdate";
+		case ProfilerEventType::AudioGenerateBuffer: return "AudioGenerateBuffer";
+		case ProfilerEventType::GPU: return "GPU";
+		case ProfilerEventType::DiskIO: return "DiskIO";
+		case ProfilerEventType::StatsView: return "StatsView";
+		case ProfilerEventType::Game: return "Game";
+		case ProfilerEventType::ExternalCode: return "ExternalCode";
+		case ProfilerEventType::UserDefined: return "UserDefined";
+		}
+		return "Unknown";
+	}
+
+	const char* getThreadTypeName(ProfilerData::ThreadType type)
+	{
+		switch (type) {
+		case ProfilerData::ThreadType::Update: return "Update";
+		case ProfilerData::ThreadType::Render: return "Render";
+		case ProfilerData::ThreadType::GPU: return "GPU";
+		case ProfilerData::ThreadType::Audio: return "Audio";
+		case ProfilerData::ThreadType::Network: return "Network";
+		case ProfilerData::ThreadType::Misc: return "Misc";
+		}
+		return "Misc";
+	}
+
+	void appendJSONString(std::string& dst, std::string_view str)
+	{
+		dst += '"';
+		for (const char c: str) {
+			switch (c) {
+			case '"': dst += "\\\""; break;
+			case '\\': dst += "\\\\"; break;
+			case '\n': dst += "\\n"; break;
+			case '\r': dst += "\\r"; break;
+			case '\t': dst += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					constexpr const char* hex = "0123456789abcdef";
+					dst += "\\u00";
+					dst += hex[(c >> 4) & 0xF];
+					dst += hex[c & 0xF];
+				} else {
+					dst += c;
+				}
+			}
+		}
+		dst += '"';
+	}
+
+	void appendMicroseconds(std::string& dst, ProfilerData::Duration duration)
+	{
+		// Chrome traces are in microseconds, but keep the nanosecond precision as a fraction
+		auto ns = duration.count();
+		if (ns < 0) {
+			dst += '-';
+			ns = -ns;
+		}
+		dst += std::to_string(ns / 1000);
+		dst += '.';
+		const auto frac = std::to_string(ns % 1000);
+		dst.append(3 - frac.size(), '0');
+		dst += frac;
+	}
+}
+
+ProfilerTraceCapture::ProfilerTraceCapture(CoreAPI& core, size_t maxFrames)
+	: core(&core)
+	, maxFrames(maxFrames)
+{
+	frames.reserve(maxFrames);
+	core.addProfilerCallback(this);
+}
+
+ProfilerTraceCapture::~ProfilerTraceCapture()
+{
+	stop();
+}
+
+void ProfilerTraceCapture::onProfileData(std::shared_ptr<ProfilerData> data)
+{
+	if (frames.size() < maxFrames) {
+		frames.push_back(std::move(data));
+	}
+	if (frames.size() >= maxFrames) {
+		stop();
+	}
+}
+
+size_t ProfilerTraceCapture::getNumFrames() const
+{
+	return frames.size();
+}
+
+bool ProfilerTraceCapture::isFinished() const
+{
+	return core == nullptr;
+}
+
+void ProfilerTraceCapture::stop()
+{
+	if (core) {
+		core->removeProfilerCallback(this);
+		core = nullptr;
+	}
+}
+
+String ProfilerTraceCapture::toChromeTrace() const
+{
+	return toChromeTrace(frames);
+}
+
+String ProfilerTraceCapture::toChromeTrace(gsl::span<const std::shared_ptr<ProfilerData>> frames)
+{
+	std::string result;
+	result += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	if (frames.empty()) {
+		result += "]}";
+		return result;
+	}
+
+	const auto origin = frames[0]->getStartTime();
+	HashMap<std::thread::id, size_t> threadIds;
+	bool first = true;
+
+	auto beginEntry = [&] ()
+	{
+		if (!first) {
+			result += ",\n";
+		}
+		first = false;
+	};
+
+	for (const auto& frame: frames) {
+		for (const auto& thread: frame->getThreads()) {
+			if (threadIds.find(thread.id) == threadIds.end()) {
+				const auto tid = threadIds.size() + 1;
+				threadIds[thread.id] = tid;
+
+				beginEntry();
+				result += "{\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(tid) + ",\"name\":\"thread_name\",\"args\":{\"name\":";
+				appendJSONString(result, std::string(getThreadTypeName(thread.type)) + " " + std::to_string(tid));
+				result += "}}";
+			}
+		}
+
+		for (const auto& e: frame->getEvents()) {
+			const auto& name = frame->getEventName(e);
+			const auto* category = getEventTypeName(e.type);
+
+			beginEntry();
+			result += "{\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(threadIds[e.threadId]) + ",\"name\":";
+			appendJSONString(result, name.isEmpty() ? std::string_view(category) : std::string_view(name.cppStr()));
+			result += ",\"cat\":";
+			appendJSONString(result, category);
+			result += ",\"ts\":";
+			appendMicroseconds(result, e.startTime - origin);
+			result += ",\"dur\":";
+			appendMicroseconds(result, e.endTime - e.startTime);
+			result += "}";
+		}
+	}
+
+	result += "]}";
+	return result;
+}
@@ -0,0 +1,64 @@
+#include "halley/entity/entity_command_buffer.h"
+#include "halley/entity/world.h"
+
+using namespace Halley;
+
+void EntityCommandBuffer::destroyEntity(EntityId id)
+{
+	add([id] (World& world)
+	{
+		world.destroyEntity(id);
+	});
+}
+
+void EntityCommandBuffer::run(Command command)
+{
+	add(std::move(command));
+}
+
+bool EntityCommandBuffer::empty() const
+{
+	return commands.empty();
+}
+
+void EntityCommandBuffer::clear()
+{
+	commands.clear();
+	sortKey = 0;
+}
+
+void EntityCommandBuffer::apply(World& world)
+{
+	for (auto& c: commands) {
+		c.second(world);
+	}
+	clear();
+}
+
+void EntityCommandBuffer::applyAll(gsl::span<EntityCommandBuffer> buffers, World& world)
+{
+	Vector<std::pair<size_t, Command>*> all;
+	for (auto& buffer: buffers) {
+		for (auto& c: buffer.commands) {
+			all.push_back(&c);
+		}
+	}
+	std::stable_sort(all.begin(), all.end(), [] (const auto* a, const auto* b) { return a->first < b->first; });
+
+	for (auto* c: all) {
+		c->second(world);
+	}
+	for (auto& buffer: buffers) {
+		buffer.clear();
+	}
+}
+
+void EntityCommandBuffer::setSortKey(size_t key)
+{
+	sortKey = key;
+}
+
+void EntityCommandBuffer::add(Command command)
+{
+	commands.emplace_back(sortKey, std::move(command));
+}
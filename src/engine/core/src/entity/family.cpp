@@ -70,3 +70,60 @@ void Family::reloadEntity(Entity& entity)
 {
 	toReload.push_back(entity.getEntityId());
 }
+
+void Family::setStableOrder(bool stable)
+{
+	stableOrder = stable;
+}
+
+bool Family::isStableOrder() const
+{
+	return stableOrder;
+}
+
+std::optional<size_t> Family::tryGetIndex(EntityId id) const
+{
+	const auto slot = getSlot(id);
+	if (slot != invalidSlot && slot < elemCount && static_cast<const FamilyBase*>(getElement(slot))->entityId == id) {
+		return slot;
+	}
+	return std::nullopt;
+}
+
+uint32_t Family::getSlot(EntityId id) const
+{
+	const auto idx = static_cast<uint32_t>(id.value & 0xFFFFFFFFll);
+	const auto page = idx / slotPageSize;
+	if (page >= slotPages.size() || !slotPages[page]) {
+		return invalidSlot;
+	}
+	return (*slotPages[page])[idx % slotPageSize];
+}
+
+void Family::setSlot(EntityId id, size_t slot)
+{
+	const auto idx = static_cast<uint32_t>(id.value & 0xFFFFFFFFll);
+	const auto page = idx / slotPageSize;
+	if (page >= slotPages.size()) {
+		slotPages.resize(page + 1);
+	}
+	if (!slotPages[page]) {
+		slotPages[page] = std::make_unique<std::array<uint32_t, slotPageSize>>();
+		slotPages[page]->fill(invalidSlot);
+	}
+	(*slotPages[page])[idx % slotPageSize] = static_cast<uint32_t>(slot);
+}
+
+void Family::clearSlot(EntityId id)
+{
+	const auto idx = static_cast<uint32_t>(id.value & 0xFFFFFFFFll);
+	const auto page = idx / slotPageSize;
+	if (page < slotPages.size() && slotPages[page]) {
+		(*slotPages[page])[idx % slotPageSize] = invalidSlot;
+	}
+}
+
+void Family::clearSlots()
+{
+	slotPages.clear();
+}
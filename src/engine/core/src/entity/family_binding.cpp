@@ -37,6 +37,11 @@ void FamilyBindingBase::setFamily(Family* f) noexcept {
 	family = f;
 }
 
+void FamilyBindingBase::setStableOrder(bool stable)
+{
+	family->setStableOrder(stable);
+}
+
 void FamilyBindingBase::setOnEntitiesAdded(std::function<void(void*, size_t)> callback)
 {
 	addedCallback = callback;
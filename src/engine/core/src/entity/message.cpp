@@ -1,15 +1,15 @@
 #include "halley/entity/message.h"
+#include <halley/data_structures/memory_pool.h>
 
 using namespace Halley;
 
-/*
 void* Message::operator new(size_t size)
 {
 	return PoolPool::getPool(size)->alloc();
 }
 
-void Message::operator delete(void* ptr)
+void Message::operator delete(void* ptr, size_t size)
 {
-	PoolPool::getPool(static_cast<Message*>(ptr)->getSize())->free(ptr);
+	// Sized delete gets the dynamic type's size through the virtual destructor, the object can't be queried at this point
+	PoolPool::getPool(size)->free(ptr);
 }
-*/
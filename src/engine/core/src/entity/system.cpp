@@ -32,12 +32,37 @@ void SystemMessageBridge::sendMessageToSystem(const String& targetSystem, int me
 	system->sendSystemMessage(targetSystem, messageType, data, std::move(callback), fromPeerId);
 }
 
+bool SystemAccessDeclaration::conflictsWith(const SystemAccessDeclaration& other) const
+{
+	if (exclusive || other.exclusive) {
+		return true;
+	}
+
+	const auto intersects = [] (const auto& a, const auto& b)
+	{
+		return std::any_of(a.begin(), a.end(), [&] (const auto& v) { return std_ex::contains(b, v); });
+	};
+
+	return intersects(componentsWritten, other.componentsWritten)
+		|| intersects(componentsWritten, other.componentsRead)
+		|| intersects(componentsRead, other.componentsWritten)
+		|| intersects(services, other.services)
+		|| intersects(messagesSent, other.messagesReceived)
+		|| intersects(messagesReceived, other.messagesSent);
+}
+
 System::System(Vector<FamilyBindingBase*> uninitializedFamilies, Vector<int> messageTypesReceived)
 	: families(std::move(uninitializedFamilies))
 	, messageTypesReceived(std::move(messageTypesReceived))
 {
 }
 
+void System::setName(String n)
+{
+	name = std::move(n);
+	profilerName = ProfilerCapture::internName(name);
+}
+
 size_t System::getEntityCount() const
 {
 	size_t n = 0;
@@ -67,17 +92,11 @@ void System::onAddedToWorld(World& w, int id) {
 
 void System::purgeMessages()
 {
-	if (!messagesSentTo.empty()) {
-		for (auto& target: messagesSentTo) {
-			// Purge all messages of this age
-			Entity* entity = world->tryGetRawEntity(target);
-
-			if (entity) {
-				std_ex::erase_if(entity->inbox, [&] (const MessageEntry& e) { return e.age == systemId; });
-			}
-		}
-		messagesSentTo.clear();
+	// Only the queues this system sent to need to be visited
+	for (const int type: messageTypesSent) {
+		std_ex::erase_if(world->getEntityMessageQueue(type), [&] (const auto& e) { return e.second.age == systemId; });
 	}
+	messageTypesSent.clear();
 }
 
 void System::processMessages()
@@ -86,32 +105,24 @@ void System::processMessages()
 
 void System::doProcessMessages(FamilyBindingBase& family, gsl::span<const int> typesAccepted)
 {
-	// This whole method is probably very inefficient.
-	struct MessageBox
-	{
-		Vector<Message*> msg;
-		Vector<size_t> elemIdx;
-	};
-	HashMap<int, MessageBox> inboxes;
-
-	const size_t sz = family.count();
-	for (size_t i = 0; i < sz; i++) {
-		const FamilyBase* elem = static_cast<FamilyBase*>(family.getElement(i));
-		const Entity* entity = world->tryGetRawEntity(elem->entityId);
-		if (entity) {
-			for (const auto& msg: entity->inbox) {
-				if (std::find(typesAccepted.begin(), typesAccepted.end(), msg.type) != typesAccepted.end()) {
-					auto& inbox = inboxes[msg.type];
-					inbox.msg.emplace_back(msg.msg.get());
-					inbox.elemIdx.emplace_back(i);
-				}
+	for (const int type: typesAccepted) {
+		const auto* queue = world->tryGetEntityMessageQueue(type);
+		if (!queue || queue->empty()) {
+			continue;
+		}
+
+		receivedMessages.clear();
+		receivedIndices.clear();
+		for (const auto& [target, entry]: *queue) {
+			if (const auto idx = family.family->tryGetIndex(target)) {
+				receivedMessages.push_back(entry.msg.get());
+				receivedIndices.push_back(*idx);
 			}
 		}
-	}
-	for (auto& iter: inboxes) {
-		const int msgId = iter.first;
-		auto& inbox = iter.second;
-		onMessagesReceived(msgId, inbox.msg.data(), inbox.elemIdx.data(), inbox.msg.size(), family);
+
+		if (!receivedMessages.empty()) {
+			onMessagesReceived(type, receivedMessages.data(), receivedIndices.data(), receivedMessages.size(), family);
+		}
 	}
 }
 
@@ -133,10 +144,12 @@ void System::dispatchMessages()
 {
 	if (!outbox.empty()) {
 		for (auto& o: outbox) {
-			Entity* entity = world->tryGetRawEntity(o.first);
-			if (entity) {
-				entity->inbox.emplace_back(std::move(o.second));
-				messagesSentTo.push_back(o.first);
+			if (world->tryGetRawEntity(o.first)) {
+				const int type = o.second.type;
+				world->getEntityMessageQueue(type).emplace_back(std::move(o));
+				if (std::find(messageTypesSent.begin(), messageTypesSent.end(), type) == messageTypesSent.end()) {
+					messageTypesSent.push_back(type);
+				}
 			}
 		}
 		outbox.clear();
@@ -217,7 +230,7 @@ void System::sendSystemMessageConfig(const String& targetSystem, const String& m
 
 void System::doUpdate(Time time) {
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
-	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, name);
+	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, profilerName);
 
 	if (!messageTypesReceived.empty()) {
 		processMessages();
@@ -229,12 +242,29 @@ void System::doUpdate(Time time) {
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
 }
 
+void System::doUpdateConcurrent(Time time)
+{
+	// Called from a worker thread; anything that touches the world's message queues is deferred to finishConcurrentUpdate()
+	ProfilerEvent event(ProfilerEventType::WorldSystemUpdate, profilerName);
+
+	if (!messageTypesReceived.empty()) {
+		processMessages();
+	}
+	updateBase(time);
+}
+
+void System::finishConcurrentUpdate()
+{
+	purgeMessages();
+	dispatchMessages();
+}
+
 void System::doRender(RenderContext& rc) {
 	if (!initialised) {
 		throw Exception("System " + name + " is being rendered before being initialised. Make sure a World::step() happens before World::render().", HalleyExceptions::Entity);
 	}
 	
-	ProfilerEvent event(ProfilerEventType::WorldSystemRender, name);
+	ProfilerEvent event(ProfilerEventType::WorldSystemRender, profilerName);
 	renderBase(rc);
 
 	HALLEY_DEBUG_TRACE_COMMENT(name.c_str());
@@ -18,6 +18,7 @@
 #include "halley/graphics/render_context.h"
 #include "halley/support/logger.h"
 #include "halley/support/profiler.h"
+#include "halley/concurrency/concurrent.h"
 
 using namespace Halley;
 
@@ -74,16 +75,20 @@ System& World::addSystem(std::unique_ptr<System> system, TimeLine timelineType)
 	auto& ref = *system.get();
 	auto& timeline = getSystems(timelineType);
 	timeline.emplace_back(std::move(system));
+	systemBatches[static_cast<int>(timelineType)].clear();
 	ref.onAddedToWorld(*this, int(timeline.size()));
 	return ref;
 }
 
 void World::removeSystem(System& system)
 {
-	for (auto& sys : systems) {
+	for (size_t tl = 0; tl < systems.size(); ++tl) {
+		auto& sys = systems[tl];
 		for (size_t i = 0; i < sys.size(); i++) {
 			if (sys[i].get() == &system) {
+				system.purgeMessages();
 				sys.erase(sys.begin() + i);
+				systemBatches[tl].clear();
 				return;
 			}
 		}
@@ -141,6 +146,8 @@ Service& World::addService(std::shared_ptr<Service> service)
 
 void World::loadSystems(const ConfigNode& root)
 {
+	parallelUpdate = root["parallelUpdate"].asBool(false);
+
 	for (const auto& [timelineName, tlSystems]: root["timelines"].asMap()) {
 		TimeLine timeline;
 		if (timelineName == "fixedUpdate") {
@@ -251,7 +258,6 @@ void World::doDestroyEntity(EntityId id)
 void World::doDestroyEntity(Entity* e)
 {
 	e->destroy(*this);
-	entityDirty = true;
 }
 
 EntityRef World::getEntity(EntityId id)
@@ -367,15 +373,17 @@ Vector<ConstEntityRef> World::getTopLevelEntities() const
 	return result;
 }
 
-void World::onEntityDirty()
+void World::onEntityDirty(Entity& entity)
 {
-	entityDirty = true;
+	dirtyEntities.push_back(&entity);
 }
 
-void World::setEntityReloaded()
+void World::setEntityReloaded(Entity& entity)
 {
-	entityReloaded = true;
-	entityDirty = true;
+	if (!entity.reloaded) {
+		entity.reloaded = true;
+		reloadedEntities.push_back(&entity);
+	}
 }
 
 const WorldReflection& World::getReflection() const
@@ -483,6 +491,16 @@ void World::setTransform2DAnisotropy(float anisotropy)
 	transform2DAnisotropy = anisotropy;
 }
 
+void World::setParallelUpdate(bool enabled)
+{
+	parallelUpdate = enabled;
+}
+
+bool World::isParallelUpdate() const
+{
+	return parallelUpdate;
+}
+
 void World::deleteEntity(Entity* entity)
 {
 	Expects (entity);
@@ -528,97 +546,99 @@ void World::spawnPending()
 		HALLEY_DEBUG_TRACE();
 		for (auto& e : entitiesPendingCreation) {
 			e->onReady();
+			e->worldIdx = static_cast<uint32_t>(entities.size());
+			entities.push_back(e);
 		}
-		std::move(entitiesPendingCreation.begin(), entitiesPendingCreation.end(), std::insert_iterator<decltype(entities)>(entities, entities.end()));
 		entitiesPendingCreation.clear();
-		entityDirty = true;
 		HALLEY_DEBUG_TRACE();
 	}
 
 	updateEntities();
 }
 
+World::FamilyTodo& World::getFamilyTodo(FamilyMaskType mask)
+{
+	// Only a handful of distinct masks change in a typical frame, and consecutive entities tend to share them
+	for (size_t i = familyTodoCount; i-- > 0; ) {
+		if (familyTodos[i].mask == mask) {
+			return familyTodos[i];
+		}
+	}
+
+	if (familyTodoCount == familyTodos.size()) {
+		familyTodos.emplace_back();
+	}
+	auto& todo = familyTodos[familyTodoCount++];
+	todo.mask = mask;
+	return todo;
+}
+
 void World::updateEntities()
 {
-	if (!entityDirty) {
+	if (dirtyEntities.empty() && reloadedEntities.empty()) {
 		return;
 	}
 
-	entityDirty = false;
-
 	HALLEY_DEBUG_TRACE();
-	size_t nEntities = entities.size();
-
-	Vector<size_t> entitiesRemoved;
-
-	struct FamilyTodo {
-		Vector<std::pair<FamilyMaskType, Entity*>> toAdd;
-		Vector<std::pair<FamilyMaskType, Entity*>> toRemove;
-		Vector<std::pair<FamilyMaskType, Entity*>> toReload;
-	};
-	std::map<FamilyMaskType, FamilyTodo> pending;
 
-	// Update all entities
+	// Update dirty entities only
 	// This loop should be as fast as reasonably possible
-	for (size_t i = 0; i < nEntities; i++) {
-		auto& entity = *entities[i];
-		if (i + 20 < nEntities) { // Watch out for sign! Don't subtract!
-			prefetchL2(entities[i + 20]);
+	const size_t nDirty = dirtyEntities.size();
+	for (size_t i = 0; i < nDirty; i++) {
+		auto& entity = *dirtyEntities[i];
+		if (i + 8 < nDirty) { // Watch out for sign! Don't subtract!
+			prefetchL2(dirtyEntities[i + 8]);
 		}
 
-		// Check if it needs any sort of updating
-		if (entity.needsRefresh()) {
-			// First of all, let's check if it's dead
-			if (!entity.isAlive()) {
-				// Remove from systems
-				pending[entity.getMask()].toRemove.emplace_back(FamilyMaskType(), &entity);
-				entitiesRemoved.push_back(i);
-			} else {
-				// It's alive, so check old and new system inclusions
-				FamilyMaskType oldMask = entity.getMask();
-				entity.refresh(*maskStorage, *componentDeleterTable);
-				FamilyMaskType newMask = entity.getMask();
-
-				// Did it change?
-				if (oldMask != newMask) {
-					pending[oldMask].toRemove.emplace_back(newMask, &entity);
-					pending[newMask].toAdd.emplace_back(oldMask, &entity);
-				}
+		// First of all, let's check if it's dead
+		if (!entity.isAlive()) {
+			// Remove from systems
+			getFamilyTodo(entity.getMask()).toRemove.emplace_back(FamilyMaskType(), &entity);
+			entitiesRemoved.push_back(&entity);
+		} else {
+			// It's alive, so check old and new system inclusions
+			FamilyMaskType oldMask = entity.getMask();
+			entity.refresh(*maskStorage, *componentDeleterTable);
+			FamilyMaskType newMask = entity.getMask();
+
+			// Did it change?
+			if (oldMask != newMask) {
+				getFamilyTodo(oldMask).toRemove.emplace_back(newMask, &entity);
+				getFamilyTodo(newMask).toAdd.emplace_back(oldMask, &entity);
 			}
 		}
 	}
+	// Entities marked dirty while refreshing these (e.g. by component destructors) stay queued for the next pass
+	dirtyEntities.erase(dirtyEntities.begin(), dirtyEntities.begin() + nDirty);
 
-	if (entityReloaded) {
-		for (size_t i = 0; i < nEntities; i++) {
-			auto& entity = *entities[i];
-			if (entity.reloaded && entity.isAlive()) {
-				pending[entity.getMask()].toReload.emplace_back(entity.getMask(), &entity);
-				entity.reloaded = false;
-			}
+	for (auto* entity: reloadedEntities) {
+		if (entity->isAlive()) {
+			getFamilyTodo(entity->getMask()).toReload.push_back(entity);
 		}
+		entity->reloaded = false;
 	}
-
-	entityReloaded = false;
+	reloadedEntities.clear();
 
 	HALLEY_DEBUG_TRACE();
 	// Go through every family adding/removing entities as needed
-	for (auto& todo: pending) {
-		for (auto* fam: getFamiliesFor(todo.first)) {
+	for (size_t i = 0; i < familyTodoCount; ++i) {
+		auto& todo = familyTodos[i];
+		for (auto* fam: getFamiliesFor(todo.mask)) {
 			const auto& famMask = fam->inclusionMask;
 			const auto& optFamMask = fam->optionalMask;
 			auto& ms = *maskStorage;
 			
-			for (auto& e: todo.second.toRemove) {
+			for (auto& e: todo.toRemove) {
 				// Only remove if the entity is not about to be re-added
 				const auto& newMask = e.first;
 				if (!newMask.contains(famMask, ms)) {
 					fam->removeEntity(*e.second);
 				}
 			}
-			for (auto& e: todo.second.toAdd) {
+			for (auto& e: todo.toAdd) {
 				// Only add if the entity was not already in this
 				const auto& oldMask = e.first;
-				const auto& newMask = todo.first;
+				const auto& newMask = todo.mask;
 				if (!oldMask.contains(famMask, ms)) {
 					fam->addEntity(*e.second);
 				} else if (optFamMask.unionChangedBetween(oldMask, newMask, ms)) {
@@ -627,11 +647,16 @@ void World::updateEntities()
 				}
 			}
 
-			for (auto& e : todo.second.toReload) {
-				fam->reloadEntity(*e.second);
+			for (auto* e : todo.toReload) {
+				fam->reloadEntity(*e);
 			}
 		}
+
+		todo.toRemove.clear();
+		todo.toAdd.clear();
+		todo.toReload.clear();
 	}
+	familyTodoCount = 0;
 
 	HALLEY_DEBUG_TRACE();
 	// Update families
@@ -642,19 +667,19 @@ void World::updateEntities()
 	HALLEY_DEBUG_TRACE();
 	// Actually remove dead entities
 	if (!entitiesRemoved.empty()) {
-		size_t livingEntityCount = entities.size();
-		for (int i = int(entitiesRemoved.size()); --i >= 0; ) {
-			size_t idx = entitiesRemoved[i];
-			auto& entity = *entities[idx];
+		for (auto* entity: entitiesRemoved) {
+			// Swap it with the last entity, so the array just shrinks
+			const auto idx = entity->worldIdx;
+			auto* last = entities.back();
+			entities[idx] = last;
+			last->worldIdx = idx;
+			entities.pop_back();
 
 			// Remove
-			entityMap.freeId(entity.getEntityId().value);
-			deleteEntity(&entity);
-
-			// Put it at the back of the array, so it's removed when the array gets resized
-			std::swap(entities[idx], entities[--livingEntityCount]);
+			entityMap.freeId(entity->getEntityId().value);
+			deleteEntity(entity);
 		}
-		entities.resize(livingEntityCount);
+		entitiesRemoved.clear();
 	}
 
 	HALLEY_DEBUG_TRACE();
@@ -674,12 +699,71 @@ void World::initSystems(gsl::span<const TimeLine> timelines)
 
 void World::updateSystems(TimeLine timeline, Time elapsed)
 {
+	if (parallelUpdate && Executors::getCPU().threadCount() > 0) {
+		updateSystemsParallel(timeline, elapsed);
+		return;
+	}
+
 	for (auto& system : getSystems(timeline)) {
 		system->doUpdate(elapsed);
 		spawnPending();
 	}
 }
 
+void World::updateSystemsParallel(TimeLine timeline, Time elapsed)
+{
+	for (const auto& batch: getSystemBatches(timeline)) {
+		if (batch.size() == 1) {
+			batch[0]->doUpdate(elapsed);
+		} else {
+			// Systems are claimed one at a time by this thread and any free CPU workers. Like every foreachChunk, this never waits on
+			// a worker that hasn't picked anything up, so systems in a batch may themselves fan out onto the CPU executors (e.g. parallelForEach).
+			Concurrent::foreachChunk(Executors::getCPU(), batch.size(), 1, [&] (size_t idx, size_t, size_t, size_t)
+			{
+				batch[idx]->doUpdateConcurrent(elapsed);
+			});
+
+			// Sync point: deliver messages in declaration order
+			for (auto* system: batch) {
+				system->finishConcurrentUpdate();
+			}
+		}
+		spawnPending();
+	}
+}
+
+const Vector<Vector<System*>>& World::getSystemBatches(TimeLine timeline)
+{
+	auto& batches = systemBatches[static_cast<int>(timeline)];
+	const auto& timelineSystems = getSystems(timeline);
+	if (batches.empty() && !timelineSystems.empty()) {
+		// Each system goes into the batch after the last one containing a system it conflicts with.
+		// This preserves the declared order between any two conflicting systems, while independent systems share a batch.
+		Vector<SystemAccessDeclaration> declarations;
+		Vector<size_t> batchIdx;
+		declarations.reserve(timelineSystems.size());
+		batchIdx.reserve(timelineSystems.size());
+
+		for (const auto& system: timelineSystems) {
+			auto declaration = system->getAccessDeclaration();
+			size_t idx = 0;
+			for (size_t i = 0; i < declarations.size(); ++i) {
+				if (declaration.conflictsWith(declarations[i])) {
+					idx = std::max(idx, batchIdx[i] + 1);
+				}
+			}
+
+			if (idx >= batches.size()) {
+				batches.resize(idx + 1);
+			}
+			batches[idx].push_back(system.get());
+			declarations.push_back(std::move(declaration));
+			batchIdx.push_back(idx);
+		}
+	}
+	return batches;
+}
+
 void World::renderSystems(RenderContext& rc) const
 {
 	for (auto& system : getSystems(TimeLine::Render)) {
@@ -789,6 +873,23 @@ void World::sendNetworkSystemMessage(const String& targetSystem, const SystemMes
 	}
 }
 
+World::EntityMessageQueue& World::getEntityMessageQueue(int msgType)
+{
+	Expects(msgType >= 0);
+	if (static_cast<size_t>(msgType) >= entityMessageQueues.size()) {
+		entityMessageQueues.resize(msgType + 1);
+	}
+	return entityMessageQueues[msgType];
+}
+
+const World::EntityMessageQueue* World::tryGetEntityMessageQueue(int msgType) const
+{
+	if (msgType < 0 || static_cast<size_t>(msgType) >= entityMessageQueues.size()) {
+		return nullptr;
+	}
+	return &entityMessageQueues[msgType];
+}
+
 std::unique_ptr<Message> World::deserializeMessage(int msgId, gsl::span<const std::byte> data)
 {
 	auto msg = reflection.createMessage(msgId);
@@ -0,0 +1,1186 @@
+#include "halley/file_formats/block_compression.h"
+#include "halley/file_formats/image.h"
+#include "halley/support/exception.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+using namespace Halley;
+
+namespace {
+	using Texel = std::array<uint8_t, 4>;
+	using Block = std::array<Texel, 16>; // Row-major
+	using Mask = std::array<bool, 16>;
+	using Weights = std::array<float, 16>;
+
+	template <int N>
+	using Endpoint = std::array<float, N>;
+
+	constexpr int maxError = std::numeric_limits<int>::max();
+
+	int quantize(float value, int maxValue)
+	{
+		return std::clamp(static_cast<int>(std::lround(value * float(maxValue) / 255.0f)), 0, maxValue);
+	}
+
+	Mask makeFullMask()
+	{
+		Mask mask;
+		mask.fill(true);
+		return mask;
+	}
+
+	template <int N>
+	int distance(const Texel& a, const Texel& b)
+	{
+		int result = 0;
+		for (int c = 0; c < N; ++c) {
+			const int d = int(a[c]) - int(b[c]);
+			result += d * d;
+		}
+		return result;
+	}
+
+	Block readBlock(const Image& image, int bx, int by)
+	{
+		const auto bytes = image.getPixelBytes();
+		const int bpp = image.getBytesPerPixel();
+		const int w = int(image.getWidth());
+		const int h = int(image.getHeight());
+
+		Block block;
+		for (int y = 0; y < 4; ++y) {
+			const int py = std::min(by * 4 + y, h - 1);
+			for (int x = 0; x < 4; ++x) {
+				const int px = std::min(bx * 4 + x, w - 1);
+				const auto* src = bytes.data() + (size_t(py) * size_t(w) + size_t(px)) * size_t(bpp);
+				block[y * 4 + x] = Texel{ src[0], src[1], src[2], uint8_t(bpp == 4 ? src[3] : 255) };
+			}
+		}
+		return block;
+	}
+
+	void writeBlock(Image& image, int bx, int by, const Block& block)
+	{
+		const auto bytes = image.getPixelBytes();
+		const int w = int(image.getWidth());
+		const int h = int(image.getHeight());
+
+		for (int y = 0; y < 4 && by * 4 + y < h; ++y) {
+			for (int x = 0; x < 4 && bx * 4 + x < w; ++x) {
+				auto* dst = bytes.data() + (size_t(by * 4 + y) * size_t(w) + size_t(bx * 4 + x)) * 4;
+				std::copy(block[y * 4 + x].begin(), block[y * 4 + x].end(), dst);
+			}
+		}
+	}
+
+	class BitWriter {
+	public:
+		BitWriter(uint8_t* dst, size_t nBytes)
+			: dst(dst)
+		{
+			std::fill(dst, dst + nBytes, uint8_t(0));
+		}
+
+		void write(uint32_t value, int bits)
+		{
+			writeAt(pos, value, bits);
+			pos += bits;
+		}
+
+		void writeAt(size_t bitPos, uint32_t value, int bits)
+		{
+			for (int i = 0; i < bits; ++i) {
+				if ((value >> i) & 1) {
+					dst[(bitPos + i) >> 3] |= uint8_t(1 << ((bitPos + i) & 7));
+				}
+			}
+		}
+
+	private:
+		uint8_t* dst;
+		size_t pos = 0;
+	};
+
+	class BitReader {
+	public:
+		explicit BitReader(const uint8_t* src)
+			: src(src)
+		{}
+
+		uint32_t read(int bits)
+		{
+			const auto result = readAt(pos, bits);
+			pos += bits;
+			return result;
+		}
+
+		uint32_t readAt(size_t bitPos, int bits) const
+		{
+			uint32_t result = 0;
+			for (int i = 0; i < bits; ++i) {
+				result |= uint32_t((src[(bitPos + i) >> 3] >> ((bitPos + i) & 7)) & 1) << i;
+			}
+			return result;
+		}
+
+	private:
+		const uint8_t* src;
+		size_t pos = 0;
+	};
+
+	uint64_t readBigEndian64(const uint8_t* src)
+	{
+		uint64_t result = 0;
+		for (int i = 0; i < 8; ++i) {
+			result = (result << 8) | src[i];
+		}
+		return result;
+	}
+
+	void writeBigEndian64(uint64_t value, uint8_t* dst)
+	{
+		for (int i = 0; i < 8; ++i) {
+			dst[i] = uint8_t(value >> (56 - 8 * i));
+		}
+	}
+
+	// Endpoints at the extremes of the principal axis of the masked texels
+	template <int N>
+	void fitEndpoints(const Block& block, const Mask& mask, Endpoint<N>& e0, Endpoint<N>& e1)
+	{
+		Endpoint<N> mean{};
+		int count = 0;
+		for (int i = 0; i < 16; ++i) {
+			if (mask[i]) {
+				for (int c = 0; c < N; ++c) {
+					mean[c] += block[i][c];
+				}
+				++count;
+			}
+		}
+		if (count == 0) {
+			e0.fill(0);
+			e1.fill(0);
+			return;
+		}
+		for (auto& m: mean) {
+			m /= float(count);
+		}
+
+		float cov[N][N] = {};
+		for (int i = 0; i < 16; ++i) {
+			if (mask[i]) {
+				for (int a = 0; a < N; ++a) {
+					for (int b = 0; b < N; ++b) {
+						cov[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+					}
+				}
+			}
+		}
+
+		// Power iteration, starting from the channel with the most variance
+		int start = 0;
+		for (int c = 1; c < N; ++c) {
+			if (cov[c][c] > cov[start][start]) {
+				start = c;
+			}
+		}
+		Endpoint<N> axis;
+		for (int c = 0; c < N; ++c) {
+			axis[c] = cov[start][c];
+		}
+		for (int iter = 0; iter < 8; ++iter) {
+			Endpoint<N> next{};
+			float len = 0;
+			for (int a = 0; a < N; ++a) {
+				for (int b = 0; b < N; ++b) {
+					next[a] += cov[a][b] * axis[b];
+				}
+				len = std::max(len, std::abs(next[a]));
+			}
+			if (len < 1e-6f) {
+				break;
+			}
+			for (int c = 0; c < N; ++c) {
+				axis[c] = next[c] / len;
+			}
+		}
+
+		float axisLen2 = 0;
+		for (const auto a: axis) {
+			axisLen2 += a * a;
+		}
+		if (axisLen2 < 1e-6f) {
+			e0 = mean;
+			e1 = mean;
+			return;
+		}
+
+		float tMin = std::numeric_limits<float>::max();
+		float tMax = std::numeric_limits<float>::lowest();
+		for (int i = 0; i < 16; ++i) {
+			if (mask[i]) {
+				float t = 0;
+				for (int c = 0; c < N; ++c) {
+					t += (block[i][c] - mean[c]) * axis[c];
+				}
+				t /= axisLen2;
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+		}
+		for (int c = 0; c < N; ++c) {
+			e0[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+		}
+	}
+
+	// Least squares endpoints for a fixed interpolation weight per texel
+	template <int N>
+	bool solveEndpoints(const Block& block, const Mask& mask, const Weights& weights, Endpoint<N>& e0, Endpoint<N>& e1)
+	{
+		float aa = 0;
+		float ab = 0;
+		float bb = 0;
+		Endpoint<N> ax{};
+		Endpoint<N> bx{};
+		for (int i = 0; i < 16; ++i) {
+			if (mask[i]) {
+				const float b = weights[i];
+				const float a = 1.0f - b;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < N; ++c) {
+					ax[c] += a * block[i][c];
+					bx[c] += b * block[i][c];
+				}
+			}
+		}
+
+		const float det = aa * bb - ab * ab;
+		if (std::abs(det) < 1e-6f) {
+			return false;
+		}
+		for (int c = 0; c < N; ++c) {
+			e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+			e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	// Fits endpoints, then refines them against the indices chosen for them while that keeps improving the error
+	template <int N, typename Candidate, typename Evaluate, typename GetWeights>
+	Candidate fitAndRefine(const Block& block, const Mask& mask, Evaluate evaluate, GetWeights getWeights)
+	{
+		Endpoint<N> e0;
+		Endpoint<N> e1;
+		fitEndpoints<N>(block, mask, e0, e1);
+		Candidate best = evaluate(e0, e1);
+
+		for (int iter = 0; iter < 2 && best.error > 0; ++iter) {
+			if (!solveEndpoints<N>(block, mask, getWeights(best), e0, e1)) {
+				break;
+			}
+			auto candidate = evaluate(e0, e1);
+			if (candidate.error >= best.error) {
+				break;
+			}
+			best = candidate;
+		}
+		return best;
+	}
+
+
+	// BC1 / BC3
+
+	uint16_t packRGB565(const Endpoint<3>& c)
+	{
+		return uint16_t((quantize(c[0], 31) << 11) | (quantize(c[1], 63) << 5) | quantize(c[2], 31));
+	}
+
+	Texel unpackRGB565(uint16_t c)
+	{
+		const int r = (c >> 11) & 31;
+		const int g = (c >> 5) & 63;
+		const int b = c & 31;
+		return Texel{ uint8_t((r << 3) | (r >> 2)), uint8_t((g << 2) | (g >> 4)), uint8_t((b << 3) | (b >> 2)), 255 };
+	}
+
+	std::array<Texel, 4> makeBC1Palette(uint16_t c0, uint16_t c1, bool fourColour)
+	{
+		const auto a = unpackRGB565(c0);
+		const auto b = unpackRGB565(c1);
+		std::array<Texel, 4> palette = { a, b, a, a };
+		for (int c = 0; c < 3; ++c) {
+			if (fourColour) {
+				palette[2][c] = uint8_t((2 * a[c] + b[c]) / 3);
+				palette[3][c] = uint8_t((a[c] + 2 * b[c]) / 3);
+			} else {
+				palette[2][c] = uint8_t((a[c] + b[c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		palette[3][3] = fourColour ? 255 : 0;
+		return palette;
+	}
+
+	struct BC1Candidate {
+		uint16_t c0 = 0;
+		uint16_t c1 = 0;
+		uint32_t indices = 0;
+		int error = maxError;
+	};
+
+	BC1Candidate evaluateBC1(const Block& block, const Mask& opaque, bool hasTransparency, const Endpoint<3>& e0, const Endpoint<3>& e1)
+	{
+		BC1Candidate result;
+		result.c0 = packRGB565(e0);
+		result.c1 = packRGB565(e1);
+
+		// c0 > c1 selects four colours, c0 <= c1 three colours plus transparent black
+		if (hasTransparency ? result.c0 > result.c1 : result.c0 < result.c1) {
+			std::swap(result.c0, result.c1);
+		}
+		const bool fourColour = result.c0 > result.c1;
+		const auto palette = makeBC1Palette(result.c0, result.c1, fourColour);
+
+		result.error = 0;
+		for (int i = 0; i < 16; ++i) {
+			int best = 3;
+			if (opaque[i]) {
+				int bestDist = maxError;
+				for (int k = 0; k < (fourColour ? 4 : 3); ++k) {
+					const int d = distance<3>(block[i], palette[k]);
+					if (d < bestDist) {
+						bestDist = d;
+						best = k;
+					}
+				}
+				result.error += bestDist;
+			}
+			result.indices |= uint32_t(best) << (2 * i);
+		}
+		return result;
+	}
+
+	void encodeBC1Colour(const Block& block, bool allowTransparency, uint8_t* dst)
+	{
+		Mask opaque;
+		bool hasTransparency = false;
+		bool hasOpaque = false;
+		for (int i = 0; i < 16; ++i) {
+			opaque[i] = !allowTransparency || block[i][3] >= 128;
+			hasTransparency |= !opaque[i];
+			hasOpaque |= opaque[i];
+		}
+
+		BC1Candidate best;
+		if (hasOpaque) {
+			best = fitAndRefine<3, BC1Candidate>(block, opaque, [&] (const Endpoint<3>& e0, const Endpoint<3>& e1)
+			{
+				return evaluateBC1(block, opaque, hasTransparency, e0, e1);
+			}, [] (const BC1Candidate& candidate)
+			{
+				constexpr float fourColourWeights[] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+				constexpr float threeColourWeights[] = { 0.0f, 1.0f, 0.5f, 0.0f };
+				const auto* weights = candidate.c0 > candidate.c1 ? fourColourWeights : threeColourWeights;
+				Weights result;
+				for (int i = 0; i < 16; ++i) {
+					result[i] = weights[(candidate.indices >> (2 * i)) & 3];
+				}
+				return result;
+			});
+		} else {
+			best.indices = 0xFFFFFFFF;
+		}
+
+		dst[0] = uint8_t(best.c0 & 0xFF);
+		dst[1] = uint8_t(best.c0 >> 8);
+		dst[2] = uint8_t(best.c1 & 0xFF);
+		dst[3] = uint8_t(best.c1 >> 8);
+		for (int i = 0; i < 4; ++i) {
+			dst[4 + i] = uint8_t(best.indices >> (8 * i));
+		}
+	}
+
+	void decodeBC1Colour(const uint8_t* src, bool forceFourColour, Block& block)
+	{
+		const auto c0 = uint16_t(src[0] | (src[1] << 8));
+		const auto c1 = uint16_t(src[2] | (src[3] << 8));
+		const auto palette = makeBC1Palette(c0, c1, forceFourColour || c0 > c1);
+		const uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | (uint32_t(src[7]) << 24);
+		for (int i = 0; i < 16; ++i) {
+			block[i] = palette[(indices >> (2 * i)) & 3];
+		}
+	}
+
+	std::array<int, 8> makeBC3AlphaPalette(int a0, int a1)
+	{
+		std::array<int, 8> palette;
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1) {
+			for (int i = 2; i < 8; ++i) {
+				palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+			}
+		} else {
+			for (int i = 2; i < 6; ++i) {
+				palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+		return palette;
+	}
+
+	int assignBC3Alpha(const Block& block, int a0, int a1, uint64_t& indices)
+	{
+		const auto palette = makeBC3AlphaPalette(a0, a1);
+		indices = 0;
+		int error = 0;
+		for (int i = 0; i < 16; ++i) {
+			int best = 0;
+			int bestDist = maxError;
+			for (int k = 0; k < 8; ++k) {
+				const int d = std::abs(palette[k] - block[i][3]);
+				if (d < bestDist) {
+					bestDist = d;
+					best = k;
+				}
+			}
+			error += bestDist * bestDist;
+			indices |= uint64_t(best) << (3 * i);
+		}
+		return error;
+	}
+
+	void encodeBC3Alpha(const Block& block, uint8_t* dst)
+	{
+		int minA = 255;
+		int maxA = 0;
+		int minInner = 255;
+		int maxInner = 0;
+		for (const auto& texel: block) {
+			const int a = texel[3];
+			minA = std::min(minA, a);
+			maxA = std::max(maxA, a);
+			if (a > 0 && a < 255) {
+				minInner = std::min(minInner, a);
+				maxInner = std::max(maxInner, a);
+			}
+		}
+
+		int a0 = maxA;
+		int a1 = minA;
+		uint64_t indices;
+		const int error = assignBC3Alpha(block, a0, a1, indices);
+
+		// Six interpolated values plus exact 0 and 255 suit blocks that mix fully transparent and opaque texels
+		if (error > 0) {
+			const int b0 = minInner <= maxInner ? minInner : 0;
+			const int b1 = minInner <= maxInner ? maxInner : 0;
+			uint64_t altIndices;
+			if (assignBC3Alpha(block, b0, b1, altIndices) < error) {
+				a0 = b0;
+				a1 = b1;
+				indices = altIndices;
+			}
+		}
+
+		dst[0] = uint8_t(a0);
+		dst[1] = uint8_t(a1);
+		for (int i = 0; i < 6; ++i) {
+			dst[2 + i] = uint8_t(indices >> (8 * i));
+		}
+	}
+
+	void decodeBC3Alpha(const uint8_t* src, Block& block)
+	{
+		const auto palette = makeBC3AlphaPalette(src[0], src[1]);
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i) {
+			indices |= uint64_t(src[2 + i]) << (8 * i);
+		}
+		for (int i = 0; i < 16; ++i) {
+			block[i][3] = uint8_t(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+
+	// BC7, mode 6 only: a single RGBA subset with 7 bit endpoints plus a p-bit each and 4 bit indices
+
+	constexpr std::array<int, 16> bc7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Endpoint {
+		std::array<int, 4> q = {};
+		int p = 0;
+
+		int getValue(int c) const { return (q[c] << 1) | p; }
+	};
+
+	BC7Endpoint quantizeBC7(const Endpoint<4>& e)
+	{
+		BC7Endpoint best;
+		float bestError = std::numeric_limits<float>::max();
+		for (int p = 0; p < 2; ++p) {
+			BC7Endpoint candidate;
+			candidate.p = p;
+			float error = 0;
+			for (int c = 0; c < 4; ++c) {
+				candidate.q[c] = std::clamp(static_cast<int>(std::lround((e[c] - float(p)) * 0.5f)), 0, 127);
+				const float d = float(candidate.getValue(c)) - e[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	std::array<Texel, 16> makeBC7Palette(const BC7Endpoint& e0, const BC7Endpoint& e1)
+	{
+		std::array<Texel, 16> palette;
+		for (int k = 0; k < 16; ++k) {
+			for (int c = 0; c < 4; ++c) {
+				palette[k][c] = uint8_t(((64 - bc7Weights[k]) * e0.getValue(c) + bc7Weights[k] * e1.getValue(c) + 32) >> 6);
+			}
+		}
+		return palette;
+	}
+
+	struct BC7Candidate {
+		BC7Endpoint e0;
+		BC7Endpoint e1;
+		std::array<uint8_t, 16> indices = {};
+		int error = maxError;
+	};
+
+	BC7Candidate evaluateBC7(const Block& block, const Endpoint<4>& e0, const Endpoint<4>& e1)
+	{
+		BC7Candidate result;
+		result.e0 = quantizeBC7(e0);
+		result.e1 = quantizeBC7(e1);
+		const auto palette = makeBC7Palette(result.e0, result.e1);
+
+		result.error = 0;
+		for (int i = 0; i < 16; ++i) {
+			int bestDist = maxError;
+			for (int k = 0; k < 16; ++k) {
+				const int d = distance<4>(block[i], palette[k]);
+				if (d < bestDist) {
+					bestDist = d;
+					result.indices[i] = uint8_t(k);
+				}
+			}
+			result.error += bestDist;
+		}
+		return result;
+	}
+
+	void encodeBC7(const Block& block, uint8_t* dst)
+	{
+		auto best = fitAndRefine<4, BC7Candidate>(block, makeFullMask(), [&] (const Endpoint<4>& e0, const Endpoint<4>& e1)
+		{
+			return evaluateBC7(block, e0, e1);
+		}, [] (const BC7Candidate& candidate)
+		{
+			Weights result;
+			for (int i = 0; i < 16; ++i) {
+				result[i] = float(bc7Weights[candidate.indices[i]]) / 64.0f;
+			}
+			return result;
+		});
+
+		// The first texel's index is stored with an implicit 0 as its top bit
+		if (best.indices[0] >= 8) {
+			std::swap(best.e0, best.e1);
+			for (auto& index: best.indices) {
+				index = uint8_t(15 - index);
+			}
+		}
+
+		BitWriter bits(dst, 16);
+		bits.write(1 << 6, 7);
+		for (int c = 0; c < 4; ++c) {
+			bits.write(best.e0.q[c], 7);
+			bits.write(best.e1.q[c], 7);
+		}
+		bits.write(best.e0.p, 1);
+		bits.write(best.e1.p, 1);
+		for (int i = 0; i < 16; ++i) {
+			bits.write(best.indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	void decodeBC7(const uint8_t* src, Block& block)
+	{
+		BitReader bits(src);
+		if (bits.read(7) != (1 << 6)) {
+			throw Exception("Only BC7 mode 6 blocks can be decoded", HalleyExceptions::Graphics);
+		}
+		BC7Endpoint e0;
+		BC7Endpoint e1;
+		for (int c = 0; c < 4; ++c) {
+			e0.q[c] = int(bits.read(7));
+			e1.q[c] = int(bits.read(7));
+		}
+		e0.p = int(bits.read(1));
+		e1.p = int(bits.read(1));
+
+		const auto palette = makeBC7Palette(e0, e1);
+		for (int i = 0; i < 16; ++i) {
+			block[i] = palette[bits.read(i == 0 ? 3 : 4)];
+		}
+	}
+
+
+	// ETC2, using the individual and differential modes shared with ETC1. The alpha channel of ETC2 RGBA is EAC.
+
+	constexpr int etcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+	int applyEtcModifier(int base, int table, int index)
+	{
+		const int modifier = etcModifiers[table][index & 1];
+		return std::clamp(base + ((index & 2) ? -modifier : modifier), 0, 255);
+	}
+
+	int getEtcPixelIndex(int texel)
+	{
+		// Texels are stored column by column
+		return (texel % 4) * 4 + texel / 4;
+	}
+
+	using EtcSubblock = std::array<int, 8>;
+	using EtcColour = std::array<int, 3>;
+
+	int fitEtcSubblock(const Block& block, const EtcSubblock& texels, const EtcColour& base, int& table, std::array<uint8_t, 16>& indices)
+	{
+		int bestError = maxError;
+		for (int t = 0; t < 8; ++t) {
+			int error = 0;
+			std::array<uint8_t, 8> chosen;
+			for (int j = 0; j < 8; ++j) {
+				const auto& texel = block[texels[j]];
+				int bestDist = maxError;
+				for (int k = 0; k < 4; ++k) {
+					int d = 0;
+					for (int c = 0; c < 3; ++c) {
+						const int diff = applyEtcModifier(base[c], t, k) - texel[c];
+						d += diff * diff;
+					}
+					if (d < bestDist) {
+						bestDist = d;
+						chosen[j] = uint8_t(k);
+					}
+				}
+				error += bestDist;
+			}
+			if (error < bestError) {
+				bestError = error;
+				table = t;
+				for (int j = 0; j < 8; ++j) {
+					indices[texels[j]] = chosen[j];
+				}
+			}
+		}
+		return bestError;
+	}
+
+	std::array<EtcSubblock, 2> getEtcSubblocks(bool flip)
+	{
+		std::array<EtcSubblock, 2> result;
+		std::array<int, 2> count = { 0, 0 };
+		for (int i = 0; i < 16; ++i) {
+			const int s = flip ? (i / 4 >= 2 ? 1 : 0) : (i % 4 >= 2 ? 1 : 0);
+			result[s][count[s]++] = i;
+		}
+		return result;
+	}
+
+	void encodeETC2RGB(const Block& block, uint8_t* dst)
+	{
+		uint64_t best = 0;
+		int bestError = maxError;
+
+		for (int flip = 0; flip < 2; ++flip) {
+			const auto subblocks = getEtcSubblocks(flip != 0);
+			std::array<Endpoint<3>, 2> average = {};
+			for (int s = 0; s < 2; ++s) {
+				for (const int i: subblocks[s]) {
+					for (int c = 0; c < 3; ++c) {
+						average[s][c] += block[i][c] / 8.0f;
+					}
+				}
+			}
+
+			for (int differential = 0; differential < 2; ++differential) {
+				// Differential mode stores 5 bit base colours, the second as a 3 bit signed delta. Individual mode stores two 4 bit colours.
+				const int maxValue = differential ? 31 : 15;
+				std::array<EtcColour, 2> q;
+				std::array<EtcColour, 2> base;
+				bool fits = true;
+				for (int c = 0; c < 3; ++c) {
+					for (int s = 0; s < 2; ++s) {
+						q[s][c] = quantize(average[s][c], maxValue);
+						base[s][c] = differential ? ((q[s][c] << 3) | (q[s][c] >> 2)) : ((q[s][c] << 4) | q[s][c]);
+					}
+					const int delta = q[1][c] - q[0][c];
+					fits &= !differential || (delta >= -4 && delta <= 3);
+				}
+				if (!fits) {
+					continue;
+				}
+
+				std::array<int, 2> tables;
+				std::array<uint8_t, 16> indices;
+				const int error = fitEtcSubblock(block, subblocks[0], base[0], tables[0], indices) + fitEtcSubblock(block, subblocks[1], base[1], tables[1], indices);
+				if (error >= bestError) {
+					continue;
+				}
+
+				bestError = error;
+				uint64_t bits = 0;
+				for (int c = 0; c < 3; ++c) {
+					if (differential) {
+						bits |= uint64_t(q[0][c]) << (59 - 8 * c);
+						bits |= uint64_t((q[1][c] - q[0][c]) & 7) << (56 - 8 * c);
+					} else {
+						bits |= uint64_t(q[0][c]) << (60 - 8 * c);
+						bits |= uint64_t(q[1][c]) << (56 - 8 * c);
+					}
+				}
+				bits |= uint64_t(tables[0]) << 37;
+				bits |= uint64_t(tables[1]) << 34;
+				bits |= uint64_t(differential) << 33;
+				bits |= uint64_t(flip) << 32;
+				for (int i = 0; i < 16; ++i) {
+					const int p = getEtcPixelIndex(i);
+					bits |= uint64_t(indices[i] >> 1) << (16 + p);
+					bits |= uint64_t(indices[i] & 1) << p;
+				}
+				best = bits;
+			}
+		}
+
+		writeBigEndian64(best, dst);
+	}
+
+	void decodeETC2RGB(const uint8_t* src, Block& block)
+	{
+		const uint64_t bits = readBigEndian64(src);
+		const bool differential = (bits >> 33) & 1;
+		const bool flip = (bits >> 32) & 1;
+
+		std::array<EtcColour, 2> base;
+		for (int c = 0; c < 3; ++c) {
+			if (differential) {
+				const int c0 = int((bits >> (59 - 8 * c)) & 31);
+				const int delta = int((bits >> (56 - 8 * c)) & 7);
+				const int c1 = c0 + (delta >= 4 ? delta - 8 : delta);
+				if (c1 < 0 || c1 > 31) {
+					throw Exception("ETC2 T, H and planar blocks can't be decoded", HalleyExceptions::Graphics);
+				}
+				base[0][c] = (c0 << 3) | (c0 >> 2);
+				base[1][c] = (c1 << 3) | (c1 >> 2);
+			} else {
+				const int c0 = int((bits >> (60 - 8 * c)) & 15);
+				const int c1 = int((bits >> (56 - 8 * c)) & 15);
+				base[0][c] = (c0 << 4) | c0;
+				base[1][c] = (c1 << 4) | c1;
+			}
+		}
+		const std::array<int, 2> tables = { int((bits >> 37) & 7), int((bits >> 34) & 7) };
+
+		const auto subblocks = getEtcSubblocks(flip);
+		for (int s = 0; s < 2; ++s) {
+			for (const int i: subblocks[s]) {
+				const int p = getEtcPixelIndex(i);
+				const int index = int(((bits >> (16 + p)) & 1) << 1 | ((bits >> p) & 1));
+				for (int c = 0; c < 3; ++c) {
+					block[i][c] = uint8_t(applyEtcModifier(base[s][c], tables[s], index));
+				}
+				block[i][3] = 255;
+			}
+		}
+	}
+
+	constexpr int eacModifiers[16][8] = {
+		{ -3, -6, -9, -15, 2, 5, 8, 14 },
+		{ -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 },
+		{ -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 },
+		{ -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 },
+		{ -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 },
+		{ -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 },
+		{ -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 },
+		{ -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 },
+		{ -3, -5, -7, -9, 2, 4, 6, 8 }
+	};
+
+	void encodeEACAlpha(const Block& block, uint8_t* dst)
+	{
+		int minA = 255;
+		int maxA = 0;
+		for (const auto& texel: block) {
+			minA = std::min(minA, int(texel[3]));
+			maxA = std::max(maxA, int(texel[3]));
+		}
+
+		uint64_t best = 0;
+		int bestError = maxError;
+		for (int t = 0; t < 16 && bestError > 0; ++t) {
+			// Pick the multiplier so the table's range spans the block's, then centre the base on it
+			const int lo = eacModifiers[t][3];
+			const int hi = eacModifiers[t][7];
+			const int span = hi - lo;
+			const int m0 = std::max((maxA - minA + span - 1) / span, 1);
+
+			for (int m = std::max(m0 - 1, 1); m <= std::min(m0 + 1, 15); ++m) {
+				const int base = std::clamp(static_cast<int>(std::lround((minA + maxA) * 0.5f - float((lo + hi) * m) * 0.5f)), 0, 255);
+
+				int error = 0;
+				uint64_t bits = (uint64_t(base) << 56) | (uint64_t(m) << 52) | (uint64_t(t) << 48);
+				for (int i = 0; i < 16; ++i) {
+					int bestIndex = 0;
+					int bestDist = maxError;
+					for (int k = 0; k < 8; ++k) {
+						const int d = std::abs(std::clamp(base + eacModifiers[t][k] * m, 0, 255) - block[i][3]);
+						if (d < bestDist) {
+							bestDist = d;
+							bestIndex = k;
+						}
+					}
+					error += bestDist * bestDist;
+					bits |= uint64_t(bestIndex) << (45 - 3 * getEtcPixelIndex(i));
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					best = bits;
+				}
+			}
+		}
+
+		writeBigEndian64(best, dst);
+	}
+
+	void decodeEACAlpha(const uint8_t* src, Block& block)
+	{
+		const uint64_t bits = readBigEndian64(src);
+		const int base = int(bits >> 56);
+		const int multiplier = int((bits >> 52) & 15);
+		const int table = int((bits >> 48) & 15);
+		for (int i = 0; i < 16; ++i) {
+			const int index = int((bits >> (45 - 3 * getEtcPixelIndex(i))) & 7);
+			block[i][3] = uint8_t(std::clamp(base + eacModifiers[table][index] * multiplier, 0, 255));
+		}
+	}
+
+
+	// ASTC 4x4, as a single partition with direct LDR endpoints at 8 bits and a 4x4 weight grid.
+	// Opaque blocks use RGB endpoints with 3 bit weights, translucent ones RGBA endpoints with 2 bit weights (the most that fits with 8 bit endpoints).
+	// Both are plain bit ranges, so no trit or quint packing is needed.
+
+	constexpr std::array<int, 4> astcWeights2 = { 0, 21, 43, 64 };
+	constexpr std::array<int, 8> astcWeights3 = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	constexpr uint32_t astcBlockMode2 = 0x042; // 4x4 weights, range 0..3
+	constexpr uint32_t astcBlockMode3 = 0x053; // 4x4 weights, range 0..7
+	constexpr uint32_t astcModeRGB = 8;
+	constexpr uint32_t astcModeRGBA = 12;
+
+	struct ASTCCandidate {
+		std::array<int, 4> e0 = {};
+		std::array<int, 4> e1 = {};
+		std::array<uint8_t, 16> indices = {};
+		int error = maxError;
+	};
+
+	int interpolateASTC(int e0, int e1, int weight)
+	{
+		// LDR endpoints are expanded to 16 bits, interpolated, and the top 8 bits are returned
+		return (((e0 * 257) * (64 - weight) + (e1 * 257) * weight + 32) >> 6) >> 8;
+	}
+
+	ASTCCandidate evaluateASTC(const Block& block, bool hasAlpha, const Endpoint<4>& e0, const Endpoint<4>& e1)
+	{
+		const auto* weights = hasAlpha ? astcWeights2.data() : astcWeights3.data();
+		const int nWeights = hasAlpha ? 4 : 8;
+
+		ASTCCandidate result;
+		for (int c = 0; c < 4; ++c) {
+			result.e0[c] = hasAlpha || c < 3 ? quantize(e0[c], 255) : 255;
+			result.e1[c] = hasAlpha || c < 3 ? quantize(e1[c], 255) : 255;
+		}
+
+		std::array<Texel, 8> palette;
+		for (int k = 0; k < nWeights; ++k) {
+			for (int c = 0; c < 4; ++c) {
+				palette[k][c] = uint8_t(interpolateASTC(result.e0[c], result.e1[c], weights[k]));
+			}
+		}
+
+		result.error = 0;
+		for (int i = 0; i < 16; ++i) {
+			int bestDist = maxError;
+			for (int k = 0; k < nWeights; ++k) {
+				const int d = distance<4>(block[i], palette[k]);
+				if (d < bestDist) {
+					bestDist = d;
+					result.indices[i] = uint8_t(k);
+				}
+			}
+			result.error += bestDist;
+		}
+		return result;
+	}
+
+	void encodeASTC(const Block& block, uint8_t* dst)
+	{
+		bool hasAlpha = false;
+		for (const auto& texel: block) {
+			hasAlpha |= texel[3] < 255;
+		}
+		const int weightBits = hasAlpha ? 2 : 3;
+		const auto* weights = hasAlpha ? astcWeights2.data() : astcWeights3.data();
+
+		auto best = fitAndRefine<4, ASTCCandidate>(block, makeFullMask(), [&] (const Endpoint<4>& e0, const Endpoint<4>& e1)
+		{
+			return evaluateASTC(block, hasAlpha, e0, e1);
+		}, [&] (const ASTCCandidate& candidate)
+		{
+			Weights result;
+			for (int i = 0; i < 16; ++i) {
+				result[i] = float(weights[candidate.indices[i]]) / 64.0f;
+			}
+			return result;
+		});
+
+		// Endpoints are only used as given if the second has the larger RGB sum, otherwise the decoder applies blue contraction
+		if (best.e1[0] + best.e1[1] + best.e1[2] < best.e0[0] + best.e0[1] + best.e0[2]) {
+			std::swap(best.e0, best.e1);
+			for (auto& index: best.indices) {
+				index = uint8_t((1 << weightBits) - 1 - index);
+			}
+		}
+
+		BitWriter bits(dst, 16);
+		bits.write(hasAlpha ? astcBlockMode2 : astcBlockMode3, 11);
+		bits.write(0, 2); // One partition
+		bits.write(hasAlpha ? astcModeRGBA : astcModeRGB, 4);
+		for (int c = 0; c < (hasAlpha ? 4 : 3); ++c) {
+			bits.write(best.e0[c], 8);
+			bits.write(best.e1[c], 8);
+		}
+
+		// Weights are stored bit-reversed from the top of the block
+		for (int i = 0; i < 16; ++i) {
+			for (int b = 0; b < weightBits; ++b) {
+				bits.writeAt(127 - (i * weightBits + b), (best.indices[i] >> b) & 1, 1);
+			}
+		}
+	}
+
+	void decodeASTC(const uint8_t* src, Block& block)
+	{
+		BitReader bits(src);
+		const auto blockMode = bits.read(11);
+		const auto partitions = bits.read(2);
+		const auto colourMode = bits.read(4);
+		const bool hasAlpha = blockMode == astcBlockMode2 && colourMode == astcModeRGBA;
+		if (partitions != 0 || !(hasAlpha || (blockMode == astcBlockMode3 && colourMode == astcModeRGB))) {
+			throw Exception("Unsupported ASTC block mode", HalleyExceptions::Graphics);
+		}
+
+		std::array<int, 4> e0 = { 0, 0, 0, 255 };
+		std::array<int, 4> e1 = { 0, 0, 0, 255 };
+		for (int c = 0; c < (hasAlpha ? 4 : 3); ++c) {
+			e0[c] = int(bits.read(8));
+			e1[c] = int(bits.read(8));
+		}
+
+		const int weightBits = hasAlpha ? 2 : 3;
+		const auto* weights = hasAlpha ? astcWeights2.data() : astcWeights3.data();
+		for (int i = 0; i < 16; ++i) {
+			int index = 0;
+			for (int b = 0; b < weightBits; ++b) {
+				index |= int(bits.readAt(127 - (i * weightBits + b), 1)) << b;
+			}
+			for (int c = 0; c < 4; ++c) {
+				block[i][c] = uint8_t(interpolateASTC(e0[c], e1[c], weights[index]));
+			}
+		}
+	}
+
+
+	void encodeBlock(const Block& block, TextureFormat format, uint8_t* dst)
+	{
+		switch (format) {
+		case TextureFormat::BC1:
+			encodeBC1Colour(block, true, dst);
+			break;
+		case TextureFormat::BC3:
+			encodeBC3Alpha(block, dst);
+			encodeBC1Colour(block, false, dst + 8);
+			break;
+		case TextureFormat::BC7:
+			encodeBC7(block, dst);
+			break;
+		case TextureFormat::ETC2RGB:
+			encodeETC2RGB(block, dst);
+			break;
+		case TextureFormat::ETC2RGBA:
+			encodeEACAlpha(block, dst);
+			encodeETC2RGB(block, dst + 8);
+			break;
+		case TextureFormat::ASTC4x4:
+			encodeASTC(block, dst);
+			break;
+		default:
+			throw Exception("Texture format is not block-compressed: " + toString(format), HalleyExceptions::Graphics);
+		}
+	}
+
+	void decodeBlock(const uint8_t* src, TextureFormat format, Block& block)
+	{
+		switch (format) {
+		case TextureFormat::BC1:
+			decodeBC1Colour(src, false, block);
+			break;
+		case TextureFormat::BC3:
+			decodeBC1Colour(src + 8, true, block);
+			decodeBC3Alpha(src, block);
+			break;
+		case TextureFormat::BC7:
+			decodeBC7(src, block);
+			break;
+		case TextureFormat::ETC2RGB:
+			decodeETC2RGB(src, block);
+			break;
+		case TextureFormat::ETC2RGBA:
+			decodeETC2RGB(src + 8, block);
+			decodeEACAlpha(src, block);
+			break;
+		case TextureFormat::ASTC4x4:
+			decodeASTC(src, block);
+			break;
+		default:
+			throw Exception("Texture format is not block-compressed: " + toString(format), HalleyExceptions::Graphics);
+		}
+	}
+}
+
+Bytes BlockCompression::encode(const Image& image, TextureFormat format, int mipLevels)
+{
+	if (!TextureDescriptor::isBlockCompressed(format)) {
+		throw Exception("Texture format is not block-compressed: " + toString(format), HalleyExceptions::Graphics);
+	}
+	const auto imgFormat = image.getFormat();
+	if (imgFormat != Image::Format::RGB && imgFormat != Image::Format::RGBA && imgFormat != Image::Format::RGBAPremultiplied) {
+		throw Exception("Only RGB and RGBA images can be block-compressed", HalleyExceptions::Graphics);
+	}
+
+	size_t totalSize = 0;
+	for (int level = 0; level < mipLevels; ++level) {
+		totalSize += TextureDescriptor::getByteSize(format, TextureDescriptor::getMipSize(image.getSize(), level));
+	}
+	Bytes result(totalSize);
+
+	const size_t blockBytes = TextureDescriptor::getBytesPerBlock(format);
+	std::unique_ptr<Image> mip;
+	const Image* levelImage = &image;
+	auto* dst = result.data();
+	for (int level = 0; level < mipLevels; ++level) {
+		if (level > 0) {
+			mip = makeMip(*levelImage);
+			levelImage = mip.get();
+		}
+
+		const int blocksX = (int(levelImage->getWidth()) + 3) / 4;
+		const int blocksY = (int(levelImage->getHeight()) + 3) / 4;
+		for (int by = 0; by < blocksY; ++by) {
+			for (int bx = 0; bx < blocksX; ++bx) {
+				encodeBlock(readBlock(*levelImage, bx, by), format, dst);
+				dst += blockBytes;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::unique_ptr<Image> BlockCompression::decode(gsl::span<const gsl::byte> data, Vector2i size, TextureFormat format)
+{
+	if (size_t(data.size()) < TextureDescriptor::getByteSize(format, size)) {
+		throw Exception("Not enough data to decode " + toString(format) + " texture", HalleyExceptions::Graphics);
+	}
+
+	auto result = std::make_unique<Image>(Image::Format::RGBA, size, false);
+	const size_t blockBytes = TextureDescriptor::getBytesPerBlock(format);
+	const auto* src = reinterpret_cast<const uint8_t*>(data.data());
+	const int blocksX = (size.x + 3) / 4;
+	const int blocksY = (size.y + 3) / 4;
+
+	Block block;
+	for (int by = 0; by < blocksY; ++by) {
+		for (int bx = 0; bx < blocksX; ++bx) {
+			decodeBlock(src, format, block);
+			writeBlock(*result, bx, by, block);
+			src += blockBytes;
+		}
+	}
+	return result;
+}
+
+std::unique_ptr<Image> BlockCompression::makeMip(const Image& image)
+{
+	const int bpp = image.getBytesPerPixel();
+	if (bpp != 3 && bpp != 4) {
+		throw Exception("Only RGB and RGBA images can be downsampled", HalleyExceptions::Graphics);
+	}
+
+	const bool premultiplied = image.getFormat() == Image::Format::RGBAPremultiplied;
+	const auto srcSize = image.getSize();
+	const auto size = Vector2i(std::max(srcSize.x / 2, 1), std::max(srcSize.y / 2, 1));
+	auto result = std::make_unique<Image>(premultiplied ? Image::Format::RGBAPremultiplied : Image::Format::RGBA, size, false);
+
+	const auto src = image.getPixelBytes();
+	const auto dst = result->getPixelBytes();
+	for (int y = 0; y < size.y; ++y) {
+		for (int x = 0; x < size.x; ++x) {
+			std::array<int, 3> colour = {};
+			std::array<int, 3> weightedColour = {};
+			int alpha = 0;
+			for (int i = 0; i < 4; ++i) {
+				const int sx = std::min(x * 2 + (i & 1), srcSize.x - 1);
+				const int sy = std::min(y * 2 + (i >> 1), srcSize.y - 1);
+				const auto* px = src.data() + (size_t(sy) * size_t(srcSize.x) + size_t(sx)) * size_t(bpp);
+				const int a = bpp == 4 ? px[3] : 255;
+				for (int c = 0; c < 3; ++c) {
+					colour[c] += px[c];
+					weightedColour[c] += px[c] * a;
+				}
+				alpha += a;
+			}
+
+			// With straight alpha, weight colours by their alpha so that transparent texels don't bleed into visible ones
+			auto* out = dst.data() + (size_t(y) * size_t(size.x) + size_t(x)) * 4;
+			for (int c = 0; c < 3; ++c) {
+				out[c] = uint8_t(!premultiplied && alpha > 0 ? (weightedColour[c] + alpha / 2) / alpha : (colour[c] + 2) / 4);
+			}
+			out[3] = uint8_t((alpha + 2) / 4);
+		}
+	}
+
+	return result;
+}
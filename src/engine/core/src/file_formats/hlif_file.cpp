@@ -1,15 +1,76 @@
 #include "halley/file_formats/hlif_file.h"
 
 #include "halley/bytes/compression.h"
+#include "halley/concurrency/concurrent.h"
+#include "halley/maths/simd.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 using namespace Halley;
 
+namespace {
+	// Bands are sized so that each one is a reasonable unit of work for a thread
+	constexpr size_t targetBandBytes = 128 * 1024;
+
+	size_t getWorkerCount(size_t nBands)
+	{
+		return Executors::hasInstance() ? Concurrent::getChunkWorkerCount(Executors::getCPUAux(), nBands) : 1;
+	}
+
+	// Importers already run on CPUAux, but that's fine: foreachChunk has the calling thread claim bands too,
+	// and only waits on bands that a worker actually picked up, so it can't block on its own queue
+	template <typename F>
+	void forEachBand(size_t nBands, F f)
+	{
+		if (Executors::hasInstance()) {
+			Concurrent::foreachChunk(Executors::getCPUAux(), nBands, 1, [&] (size_t band, size_t, size_t, size_t worker)
+			{
+				f(band, worker);
+			});
+		} else {
+			for (size_t band = 0; band < nBands; ++band) {
+				f(band, 0);
+			}
+		}
+	}
+
+	void applyPaletteRun(const uint8_t* src, const int* entries, int* dst, size_t n)
+	{
+		size_t i = 0;
+#if defined(__AVX2__)
+		for (; i + 8 <= n; i += 8) {
+			const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_i32gather_epi32(entries, idx, 4));
+		}
+#elif defined(HAS_SSE)
+		// No gather before AVX2, but building full vectors still beats scalar stores
+		for (; i + 4 <= n; i += 4) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_setr_epi32(entries[src[i]], entries[src[i + 1]], entries[src[i + 2]], entries[src[i + 3]]));
+		}
+#endif
+		for (; i < n; ++i) {
+			dst[i] = entries[src[i]];
+		}
+	}
+}
+
 void HLIFFile::decode(Image& dst, gsl::span<const gsl::byte> bytes)
 {
 	if (!isHLIF(bytes)) {
 		throw Exception("Not an HLIF file.", HalleyExceptions::Utils);
 	}
 
+	if (memcmp(bytes.data(), hlifIdV2, 8) == 0) {
+		decodeV2(dst, bytes);
+	} else {
+		decodeV1(dst, bytes);
+	}
+}
+
+void HLIFFile::decodeV1(Image& dst, gsl::span<const gsl::byte> bytes)
+{
 	Header header;
 	if (bytes.size() < sizeof(header)) {
 		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
@@ -33,9 +94,7 @@ void HLIFFile::decode(Image& dst, gsl::span<const gsl::byte> bytes)
 	const auto paletteData = dataSpan.subspan(0, header.numPalettes * sizeof(Palette));
 	const auto lineData = dataSpan.subspan(paletteData.size(), header.height);
 	const auto pixelData = dataSpan.subspan(paletteData.size() + lineData.size());
-	const auto imgFormat = header.format == Format::RGBA ?
-		((header.flags & static_cast<uint8_t>(Flags::Premultiplied)) ? Image::Format::RGBAPremultiplied : Image::Format::RGBA) :
-		(header.format == Format::SingleChannel ? Image::Format::SingleChannel : Image::Format::Indexed);
+	const auto imgFormat = getImageFormat(header.format, header.flags);
 	const auto imgSize = Vector2i(header.width, header.height);
 
 	decodeLines(imgSize, lineData, pixelData, bpp);
@@ -51,11 +110,100 @@ void HLIFFile::decode(Image& dst, gsl::span<const gsl::byte> bytes)
 	}
 }
 
+void HLIFFile::decodeV2(Image& dst, gsl::span<const gsl::byte> bytes)
+{
+	HeaderV2 header;
+	if (bytes.size() < sizeof(header)) {
+		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
+	}
+	memcpy(&header, bytes.data(), sizeof(header));
+
+	const bool paletted = header.numPalettes > 0;
+	const int bpp = paletted ? 1 : getBPP(header.format);
+	const size_t width = header.width;
+	const size_t height = header.height;
+	const size_t bandHeight = header.bandHeight;
+	const size_t numBands = header.numBands;
+	const size_t paletteBytes = header.numPalettes * sizeof(Palette);
+	if (bandHeight == 0 ? height != 0 : numBands != (height + bandHeight - 1) / bandHeight) {
+		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+	}
+	if (header.metaUncompressedSize != paletteBytes + height) {
+		throw Exception("Invalid HLIF file encoding.", HalleyExceptions::Utils);
+	}
+
+	// Band table
+	const size_t tablePos = sizeof(header);
+	const size_t metaPos = tablePos + numBands * sizeof(uint32_t);
+	if (bytes.size() < metaPos + header.metaCompressedSize) {
+		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
+	}
+	Vector<size_t> bandOffsets(numBands + 1);
+	bandOffsets[0] = metaPos + header.metaCompressedSize;
+	for (size_t i = 0; i < numBands; ++i) {
+		uint32_t bandSize;
+		memcpy(&bandSize, bytes.data() + tablePos + i * sizeof(uint32_t), sizeof(bandSize));
+		bandOffsets[i + 1] = bandOffsets[i] + bandSize;
+	}
+	if (bytes.size() < bandOffsets.back()) {
+		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
+	}
+
+	// Palettes and line encodings
+	Bytes meta;
+	meta.resize_no_init(header.metaUncompressedSize);
+	const auto metaSize = Compression::lz4Decompress(bytes.subspan(metaPos, header.metaCompressedSize), meta.byte_span());
+	if (metaSize != header.metaUncompressedSize) {
+		throw Exception("Error decoding HLIF file.", HalleyExceptions::Utils);
+	}
+	const auto lineData = gsl::span<const Byte>(meta).subspan(paletteBytes, height);
+
+	Vector<Palette> palettes(header.numPalettes);
+	if (paletted) {
+		memcpy(palettes.data(), meta.data(), paletteBytes);
+		deltaDecodePalettes(palettes);
+	}
+
+	// Bands go straight into the image, except for paletted ones, which go through a per-worker buffer of indices first
+	const auto imgSize = Vector2i(header.width, header.height);
+	dst = Image(getImageFormat(header.format, header.flags), imgSize, false);
+	const auto dstBytes = dst.getPixelBytes();
+	const auto dstPixels = paletted ? dst.getPixels4BPP() : gsl::span<int>();
+	const size_t stride = width * bpp;
+	Vector<Bytes> scratch(paletted ? getWorkerCount(numBands) : 0);
+
+	forEachBand(numBands, [&] (size_t band, size_t worker)
+	{
+		const size_t y0 = band * bandHeight;
+		const size_t rows = std::min(bandHeight, height - y0);
+		const size_t bandBytes = rows * stride;
+
+		gsl::span<Byte> bandData;
+		if (paletted) {
+			auto& buffer = scratch[worker];
+			buffer.resize_no_init(bandBytes);
+			bandData = gsl::span<Byte>(buffer);
+		} else {
+			bandData = dstBytes.subspan(y0 * stride, bandBytes);
+		}
+
+		const auto src = bytes.subspan(bandOffsets[band], bandOffsets[band + 1] - bandOffsets[band]);
+		if (Compression::lz4Decompress(src, gsl::as_writable_bytes(bandData)) != bandBytes) {
+			throw Exception("Error decoding HLIF file.", HalleyExceptions::Utils);
+		}
+		decodeLines(Vector2i(static_cast<int>(width), static_cast<int>(rows)), lineData.subspan(y0, rows), bandData, bpp);
+
+		if (paletted) {
+			applyPalettes(bandData, palettes, dstPixels.subspan(y0 * width, rows * width), y0 * width);
+		}
+	});
+}
+
 Bytes HLIFFile::encode(const Image& image, std::string_view name, bool lz4hc)
 {
 	// Fill header
-	Header header;
-	memcpy(header.id, hlifId, 8);
+	HeaderV2 header;
+	memcpy(header.id, hlifIdV2, 8);
 	switch (image.getFormat()) {
 	case Image::Format::RGBA:
 		header.format = Format::RGBA;
@@ -89,46 +237,74 @@ Bytes HLIFFile::encode(const Image& image, std::string_view name, bool lz4hc)
 		}
 	}
 
-	// Figure out full size
 	const int bpp = palettedImage.empty() ? getBPP(header.format) : 1;
-	header.uncompressedSize = header.width * header.height * bpp + header.height + static_cast<uint32_t>(palettes.size() * sizeof(Palette));
-
-	// Prepare uncompressed data
-	Bytes uncompressed;
-	uncompressed.resize_no_init(header.uncompressedSize);
-	const auto dataSpan = gsl::span<Byte>(uncompressed);
-	const auto paletteSpan = dataSpan.subspan(0, palettes.size() * sizeof(Palette));
-	const auto lineSpan = dataSpan.subspan(paletteSpan.size(), header.height);
-	const auto pixelSpan = dataSpan.subspan(paletteSpan.size() + lineSpan.size());
-	if (palettes.empty()) {
-		memcpy(pixelSpan.data(), image.getPixelBytes().data(), pixelSpan.size());
-	} else {
-		memcpy(paletteSpan.data(), palettes.data(), paletteSpan.size());
-		memcpy(pixelSpan.data(), palettedImage.data(), pixelSpan.size());
+	const size_t width = header.width;
+	const size_t height = header.height;
+	const size_t stride = width * bpp;
+	const auto pixels = palettedImage.empty() ? image.getPixelBytes() : gsl::span<const Byte>(palettedImage);
+	header.bandHeight = static_cast<uint16_t>(getBandHeight(image.getSize(), bpp));
+	header.numBands = static_cast<uint16_t>(header.bandHeight > 0 ? (height + header.bandHeight - 1) / header.bandHeight : 0);
+
+	// Palettes followed by line encodings
+	const size_t paletteBytes = palettes.size() * sizeof(Palette);
+	Bytes meta(paletteBytes + height, 0);
+	if (!palettes.empty()) {
+		memcpy(meta.data(), palettes.data(), paletteBytes);
 	}
-	memset(lineSpan.data(), 0, lineSpan.size_bytes());
+	const auto lineSpan = gsl::span<Byte>(meta).subspan(paletteBytes, height);
 
-	// Try compressing with no filters first
 	Compression::LZ4Options options;
 	options.mode = lz4hc ? Compression::LZ4Mode::HC : Compression::LZ4Mode::Normal;
-	//options.level = 12;
-	auto compressedUnfiltered = Compression::lz4Compress(gsl::as_bytes(dataSpan), options);
-
-	// Filter and compress again
-	encodeLines(image.getSize(), lineSpan, pixelSpan, bpp);
-	auto compressedFiltered = Compression::lz4Compress(gsl::as_bytes(dataSpan), options);
-	uncompressed = {};
-
-	// Take the best of the two
-	const auto compressed = compressedUnfiltered.size() < compressedFiltered.size() ? std::move(compressedUnfiltered) : std::move(compressedFiltered);
-	compressedFiltered = {};
-	compressedUnfiltered = {};
-
-	// Finish header and generate final bytes
-	header.compressedSize = static_cast<uint32_t>(compressed.size());
-	Bytes finalData(sizeof(header) + compressed.size());
-	memcpy(finalData.data(), &header, sizeof(header));
-	memcpy(finalData.data() + sizeof(header), compressed.data(), compressed.size());
+
+	// Compress each band both unfiltered and filtered, and keep the best of the two
+	Vector<Bytes> bands(header.numBands);
+	forEachBand(bands.size(), [&] (size_t band, size_t)
+	{
+		const size_t y0 = band * header.bandHeight;
+		const size_t rows = std::min(static_cast<size_t>(header.bandHeight), height - y0);
+		const auto src = pixels.subspan(y0 * stride, rows * stride);
+
+		auto compressedUnfiltered = Compression::lz4Compress(gsl::as_bytes(src), options);
+
+		Bytes filtered(src.begin(), src.end());
+		const auto bandLines = lineSpan.subspan(y0, rows);
+		encodeLines(Vector2i(static_cast<int>(width), static_cast<int>(rows)), bandLines, filtered, bpp);
+		auto compressedFiltered = Compression::lz4Compress(filtered.byte_span(), options);
+
+		if (compressedUnfiltered.size() <= compressedFiltered.size()) {
+			std::fill(bandLines.begin(), bandLines.end(), Byte(0));
+			bands[band] = std::move(compressedUnfiltered);
+		} else {
+			bands[band] = std::move(compressedFiltered);
+		}
+	});
+
+	const auto compressedMeta = Compression::lz4Compress(meta.byte_span(), options);
+	header.metaCompressedSize = static_cast<uint32_t>(compressedMeta.size());
+	header.metaUncompressedSize = static_cast<uint32_t>(meta.size());
+
+	// Generate final bytes
+	size_t totalSize = sizeof(header) + bands.size() * sizeof(uint32_t) + compressedMeta.size();
+	for (const auto& band: bands) {
+		totalSize += band.size();
+	}
+	Bytes finalData(totalSize);
+	size_t pos = 0;
+	auto write = [&] (const void* data, size_t size)
+	{
+		memcpy(finalData.data() + pos, data, size);
+		pos += size;
+	};
+	write(&header, sizeof(header));
+	for (const auto& band: bands) {
+		const auto bandSize = static_cast<uint32_t>(band.size());
+		write(&bandSize, sizeof(bandSize));
+	}
+	write(compressedMeta.data(), compressedMeta.size());
+	for (const auto& band: bands) {
+		write(band.data(), band.size());
+	}
+	assert(pos == totalSize);
 	return finalData;
 }
 
@@ -138,6 +314,15 @@ HLIFFile::Info HLIFFile::getInfo(gsl::span<const gsl::byte> bytes)
 		throw Exception("Not an HLIF file.", HalleyExceptions::Utils);
 	}
 
+	if (memcmp(bytes.data(), hlifIdV2, 8) == 0) {
+		HeaderV2 header;
+		if (bytes.size() < sizeof(header)) {
+			throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
+		}
+		memcpy(&header, bytes.data(), sizeof(header));
+		return Info{ Vector2i(header.width, header.height), getImageFormat(header.format, header.flags) };
+	}
+
 	Header header;
 	if (bytes.size() < sizeof(header)) {
 		throw Exception("Invalid HLIF file.", HalleyExceptions::Utils);
@@ -152,7 +337,28 @@ HLIFFile::Info HLIFFile::getInfo(gsl::span<const gsl::byte> bytes)
 
 bool HLIFFile::isHLIF(gsl::span<const gsl::byte> bytes)
 {
-	return bytes.size() >= 8 && memcmp(bytes.data(), hlifId, 8) == 0;
+	return bytes.size() >= 8 && (memcmp(bytes.data(), hlifIdV2, 8) == 0 || memcmp(bytes.data(), hlifId, 8) == 0);
+}
+
+Image::Format HLIFFile::getImageFormat(Format format, uint8_t flags)
+{
+	switch (format) {
+	case Format::RGBA:
+		return (flags & static_cast<uint8_t>(Flags::Premultiplied)) ? Image::Format::RGBAPremultiplied : Image::Format::RGBA;
+	case Format::SingleChannel:
+		return Image::Format::SingleChannel;
+	default:
+		return Image::Format::Indexed;
+	}
+}
+
+int HLIFFile::getBandHeight(Vector2i size, int bpp)
+{
+	if (size.y <= 0) {
+		return 0;
+	}
+	const size_t stride = std::max(static_cast<size_t>(size.x) * bpp, static_cast<size_t>(1));
+	return static_cast<int>(std::clamp(targetBandBytes / stride, static_cast<size_t>(1), static_cast<size_t>(size.y)));
 }
 
 void HLIFFile::decodeLines(Vector2i size, gsl::span<const uint8_t> lineData, gsl::span<uint8_t> pixelData, int bpp)
@@ -177,7 +383,7 @@ void HLIFFile::encodeLines(Vector2i size, gsl::span<uint8_t> lineData, gsl::span
 
 	Bytes blankLine(stride, 0);
 	
-	for (int y = size.y - 1; --y >= 0;) {
+	for (int y = size.y; --y >= 0;) {
 		const auto curLine = pixelData.subspan(y * stride, stride);
 		const auto prevLine = y > 0 ? pixelData.subspan((y - 1) * stride, stride) : gsl::span<const uint8_t>(blankLine);
 		const auto encoding = findBestLineEncoding(curLine, prevLine, bpp);
@@ -418,17 +624,23 @@ void HLIFFile::optimizePalettes(gsl::span<Palette> palettes, gsl::span<uint8_t>
 	}
 }
 
-void HLIFFile::applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst)
+void HLIFFile::applyPalettes(gsl::span<const uint8_t> palettedImage, gsl::span<const Palette> palettes, gsl::span<int> dst, size_t firstPixel)
 {
 	assert(palettedImage.size() == dst.size());
 
+	// Only expands the pixels in [firstPixel, firstPixel + dst.size()), so bands of the image can be done independently
+	const size_t endPixel = firstPixel + dst.size();
 	size_t startPos = 0;
 	for (const auto& palette: palettes) {
-		const size_t endPos = palette.endPixel;
-		for (size_t i = startPos; i < endPos; ++i) {
-			dst[i] = palette.entries[palettedImage[i]];
+		const size_t from = std::max(startPos, firstPixel);
+		const size_t to = std::min(static_cast<size_t>(palette.endPixel), endPixel);
+		if (from < to) {
+			applyPaletteRun(palettedImage.data() + (from - firstPixel), palette.entries.data(), dst.data() + (from - firstPixel), to - from);
+		}
+		startPos = palette.endPixel;
+		if (startPos >= endPixel) {
+			break;
 		}
-		startPos = endPos;
 	}
 }
 
@@ -14,6 +14,7 @@
 #include <halley/support/debug.h>
 #include <halley/support/console.h>
 #include <halley/concurrency/concurrent.h>
+#include <halley/data_structures/frame_arena.h>
 #include <fstream>
 #include <chrono>
 #include <ctime>
@@ -435,6 +436,7 @@ void Core::tickFrame(Time time)
 	}
 
 	BaseFrameData::setThreadFrameData(nullptr);
+	FrameArena::endFrame();
 
 	curStageFrames++;
 }
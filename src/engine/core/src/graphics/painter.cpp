@@ -12,6 +12,7 @@
 
 
 #include "halley/api/video_api.h"
+#include "halley/data_structures/frame_arena.h"
 #include "halley/graphics/render_snapshot.h"
 #include "halley/maths/bezier.h"
 #include "halley/maths/polygon.h"
@@ -180,10 +181,23 @@ void Painter::drawSprites(const std::shared_ptr<const Material>& material, size_
 {
 	Expects(vertexData != nullptr);
 
+	const size_t srcStride = material->getDefinition().getVertexStride();
+	const size_t vertexSize = material->getDefinition().getVertexSize();
+	drawSprites(material, totalNumSprites, [&] (size_t firstSprite, size_t numSprites, char* dst, size_t dstStride)
+	{
+		const char* const src = reinterpret_cast<const char*>(vertexData) + firstSprite * srcStride;
+		for (size_t i = 0; i < numSprites; i++) {
+			memcpy(dst + i * dstStride, src + i * srcStride, vertexSize);
+		}
+	});
+}
+
+void Painter::drawSprites(const std::shared_ptr<const Material>& material, size_t totalNumSprites, const SpriteVertexWriter& writer)
+{
 	const size_t verticesPerSprite = 4;
 	const size_t maxSpritesPerCall = (static_cast<size_t>(std::numeric_limits<IndexType>::max()) + 1) / verticesPerSprite;
 	size_t numSpritesLeft = totalNumSprites;
-	size_t offset = 0;
+	size_t firstSprite = 0;
 
 	while (numSpritesLeft > 0) {
 		const size_t numSprites = std::min(numSpritesLeft, maxSpritesPerCall);
@@ -193,13 +207,17 @@ void Painter::drawSprites(const std::shared_ptr<const Material>& material, size_
 
 		const auto result = addDrawData(material, numVertices, numSprites * 6, true);
 
-		const char* const src = reinterpret_cast<const char*>(vertexData) + offset;
+		// Fill in the first vertex of each sprite, then replicate it to the other three
+		const size_t spriteStride = verticesPerSprite * result.vertexStride;
+		writer(firstSprite, numSprites, result.dstVertex, spriteStride);
 
 		for (size_t i = 0; i < numSprites; i++) {
+			char* const spriteVertices = result.dstVertex + i * spriteStride;
 			for (size_t j = 0; j < verticesPerSprite; j++) {
-				const size_t srcOffset = i * result.vertexStride;
-				const size_t dstOffset = (i * verticesPerSprite + j) * result.vertexStride;
-				memcpy(result.dstVertex + dstOffset, src + srcOffset, result.vertexSize);
+				const size_t dstOffset = j * result.vertexStride;
+				if (j > 0) {
+					memcpy(spriteVertices + dstOffset, spriteVertices, result.vertexSize);
+				}
 
 				// j -> vertPos
 				// 0 -> 0, 0
@@ -208,14 +226,14 @@ void Painter::drawSprites(const std::shared_ptr<const Material>& material, size_
 				// 3 -> 0, 1
 				const float x = ((j & 1) ^ ((j & 2) >> 1)) * 1.0f;
 				const float y = ((j & 2) >> 1) * 1.0f;
-				getVertPos(result.dstVertex + dstOffset, vertPosOffset) = Vector4f(x, y, x, y);
+				getVertPos(spriteVertices + dstOffset, vertPosOffset) = Vector4f(x, y, x, y);
 			}
 		}
 
 		generateQuadIndices(result.firstIndex, numSprites, result.dstIndex);
 
 		numSpritesLeft -= numSprites;
-		offset += numSprites * material->getDefinition().getVertexStride();
+		firstSprite += numSprites;
 	}
 }
 
@@ -286,7 +304,7 @@ void Painter::drawLine(gsl::span<const Vector2f> points, float width, Colour4f c
 
 	const size_t nPoints = points.size();
 	const size_t nSegments = (loop ? nPoints : (nPoints - 1));
-	Vector<LineVertex> vertices(nSegments * 4);
+	FrameVector<LineVertex> vertices(nSegments * 4);
 
 	auto segmentNormal = [&] (size_t i) -> std::optional<Vector2f>
 	{
@@ -385,7 +403,7 @@ static size_t getSegmentsForArc(float radius, float arcLen)
 void Painter::drawCircle(Vector2f centre, float radius, float width, Colour4f colour, std::shared_ptr<const Material> material, LineDashPattern pattern)
 {
 	const size_t n = getSegmentsForArc(radius, 2 * float(pi()));
-	Vector<Vector2f> points;
+	FrameVector<Vector2f> points;
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(radius, 0).rotate(Angle1f::fromRadians(i * 2.0f * float(pi()) / n)));
 	}
@@ -401,7 +419,7 @@ void Painter::drawCircleArc(Vector2f centre, float radius, float width, Angle1f
 {
 	const float arcLen = (to - from).getRadians() + (from.turnSide(to) > 0 ? 0.0f : 0 * float(pi()));
 	const size_t n = getSegmentsForArc(radius, arcLen);
-	Vector<Vector2f> points;
+	FrameVector<Vector2f> points;
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(radius, 0).rotate(from + Angle1f::fromRadians(i * arcLen / (n - 1))));
 	}
@@ -416,7 +434,7 @@ void Painter::drawCircleArc(Circle circle, float width, Angle1f from, Angle1f to
 void Painter::drawEllipse(Vector2f centre, Vector2f radius, float width, Colour4f colour, std::shared_ptr<const Material> material, LineDashPattern pattern)
 {
 	const size_t n = getSegmentsForArc(std::max(radius.x, radius.y), 2 * float(pi()));
-	Vector<Vector2f> points;
+	FrameVector<Vector2f> points;
 	for (size_t i = 0; i < n; ++i) {
 		points.push_back(centre + Vector2f(1.0f, 0).rotate(Angle1f::fromRadians(i * 2.0f * float(pi()) / n)) * radius);
 	}
@@ -425,7 +443,7 @@ void Painter::drawEllipse(Vector2f centre, Vector2f radius, float width, Colour4
 
 void Painter::drawRect(Rect4f rect, float width, Colour4f colour, std::shared_ptr<const Material> material, LineDashPattern pattern)
 {
-	Vector<Vector2f> points;
+	FrameVector<Vector2f> points;
 	points.push_back(rect.getTopLeft());
 	points.push_back(rect.getTopRight());
 	points.push_back(rect.getBottomRight());
@@ -454,14 +472,15 @@ void Painter::drawPolygon(const Polygon& polygon, Colour4f colour, std::shared_p
 	
 	const auto& vs = polygon.getVertices();
 	const auto n = vs.size();
-	Vector<LineVertex> vertices(n);
+	FrameVector<LineVertex> vertices(n);
 	for (size_t i = 0; i < n; ++i) {
 		vertices[i].position = vs[i];
 		vertices[i].colour = col;
 		vertices[i].normal = Vector2f();
 		vertices[i].width = Vector2f();
 	}
-	Vector<IndexType> indices((n - 2) * 3);
+	FrameVector<IndexType> indices;
+	indices.reserve((n - 2) * 3);
 	for (size_t i = 0; i < n - 2; ++i) {
 		indices.push_back(0);
 		indices.push_back(static_cast<IndexType>(i) + 1);
@@ -573,7 +592,7 @@ void Painter::onTimestamp(ITimestampRecorder* snapshot, TimestampType type, size
 		frameEnd = value;
 
 		auto& profiler = ProfilerCapture::get();
-		const auto profilerEventId = profiler.recordEventStart(ProfilerEventType::GPU, "", frameStartCPUTime);
+		const auto profilerEventId = profiler.recordEventStart(ProfilerEventType::GPU, 0, frameStartCPUTime);
 		profiler.recordEventEnd(profilerEventId, frameStartCPUTime + std::chrono::nanoseconds(frameEnd - frameStart));
 	}
 
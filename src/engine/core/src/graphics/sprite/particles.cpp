@@ -1,18 +1,52 @@
 #include "halley/graphics/sprite/particles.h"
 
-#include "halley/maths/random.h"
+#include <atomic>
+#include "halley/graphics/painter.h"
+#include "halley/graphics/material/material.h"
+#include "halley/graphics/material/material_definition.h"
+#include "halley/maths/simd.h"
 #include "halley/support/logger.h"
 
 using namespace Halley;
 
+namespace {
+	uint32_t makeSeed()
+	{
+		static std::atomic<uint32_t> nextSeed = 0;
+		return nextSeed.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B9u;
+	}
+
+	constexpr size_t simdWidth = 4;
+	constexpr uint32_t rngModulus = 2147483647u;
+}
+
+size_t Particles::ParticleData::size() const
+{
+	return time.size();
+}
+
+void Particles::ParticleData::resize(size_t size)
+{
+	for (auto* v: { &posX, &posY, &posZ, &velX, &velY, &velZ, &time, &ttl, &scale, &angle }) {
+		v->resize(size, 0.0f);
+	}
+}
+
+void Particles::ParticleData::move(size_t from, size_t to)
+{
+	for (auto* v: { &posX, &posY, &posZ, &velX, &velY, &velZ, &time, &ttl, &scale, &angle }) {
+		(*v)[to] = (*v)[from];
+	}
+}
+
 Particles::Particles()
-	: rng(&Random::getGlobal())
 {
+	setSeed(makeSeed());
 }
 
 Particles::Particles(const ConfigNode& node, Resources& resources)
-	: rng(&Random::getGlobal())
 {
+	setSeed(makeSeed());
 	load(node, resources);
 }
 
@@ -122,6 +156,11 @@ void Particles::burstParticles(float n)
 	pendingSpawn += n;
 }
 
+void Particles::setSeed(uint32_t seed)
+{
+	rngState = seed % (rngModulus - 1) + 1;
+}
+
 void Particles::reset()
 {
 	firstUpdate = true;
@@ -288,28 +327,14 @@ void Particles::update(Time t)
 	updateParticles(static_cast<float>(t));
 
 	// Remove dead particles
-	for (size_t i = 0; i < nParticlesAlive; ) {
-		if (!particles[i].alive) {
-			if (i != nParticlesAlive - 1) {
-				// Swap with last particle that's alive
-				std::swap(particles[i], particles[nParticlesAlive - 1]);
-				std::swap(sprites[i], sprites[nParticlesAlive - 1]);
-				if (isAnimated()) {
-					std::swap(animationPlayers[i], animationPlayers[nParticlesAlive - 1]);
-				}
-			}
-			--nParticlesAlive;
-			// Don't increment i here, since i is now a new particle that's still alive
-		} else {
-			++i;
-		}
-	}
+	removeDeadParticles();
 
 	// Update visibility
 	nParticlesVisible = nParticlesAlive;
 	if (nParticlesVisible > 0 && !sprites[0].hasMaterial()) {
 		nParticlesVisible = 0;
 	}
+	spritesDirty = true;
 }
 
 void Particles::setSprites(Vector<Sprite> sprites)
@@ -332,14 +357,116 @@ bool Particles::isAlive() const
 	return nParticlesAlive > 0 || !destroyWhenDone;
 }
 
+size_t Particles::getNumParticles() const
+{
+	return nParticlesAlive;
+}
+
 gsl::span<Sprite> Particles::getSprites()
 {
+	updateSprites();
 	return gsl::span<Sprite>(sprites).subspan(0, nParticlesVisible);
 }
 
-gsl::span<const Sprite> Particles::getSprites() const
+void Particles::draw(Painter& painter) const
 {
-	return gsl::span<const Sprite>(sprites).subspan(0, nParticlesVisible);
+	// Emit one batch per run of particles sharing a material.
+	// Hidden particles are skipped, and clipped ones are drawn on their own through Sprite, which knows how to apply the clip.
+	auto canBatch = [&] (size_t idx)
+	{
+		return sprites[idx].isVisible() && !sprites[idx].getClip();
+	};
+
+	size_t runStart = 0;
+	while (runStart < nParticlesVisible) {
+		const auto& sprite = sprites[runStart];
+		if (!canBatch(runStart)) {
+			if (sprite.isVisible()) {
+				Sprite clipped = sprite;
+				updateSprite(runStart, clipped);
+				clipped.draw(painter);
+			}
+			++runStart;
+			continue;
+		}
+
+		const auto& material = sprite.getMaterialPtr();
+		size_t runEnd = runStart + 1;
+		while (runEnd < nParticlesVisible && sprites[runEnd].getMaterialPtr() == material && canBatch(runEnd)) {
+			++runEnd;
+		}
+
+		if (material) {
+			Expects(material->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib) + sizeof(Vector4f));
+
+			painter.drawSprites(material, runEnd - runStart, [&] (size_t firstSprite, size_t numSprites, char* dst, size_t dstStride)
+			{
+				SpriteVertexAttrib vertex;
+				for (size_t i = 0; i < numSprites; ++i) {
+					writeVertex(runStart + firstSprite + i, vertex);
+					memcpy(dst + i * dstStride + sizeof(Vector4f), &vertex, sizeof(vertex));
+				}
+			});
+		}
+
+		runStart = runEnd;
+	}
+}
+
+void Particles::writeVertex(size_t index, SpriteVertexAttrib& dst) const
+{
+	const auto& p = particles;
+	const float t = p.time[index] / p.ttl[index];
+	const float scale = scaleCurve.evaluate(t) * p.scale[index];
+
+	dst = sprites[index].getVertexAttributes();
+	dst.pos = Vector2f(p.posX[index], p.posY[index] - p.posZ[index]);
+	dst.rotation = p.angle[index];
+	dst.scale = Vector2f(scale, scale);
+	dst.colour = colourGradient.evaluate(t);
+	dst.custom1 = Vector4f(p.posX[index], p.posY[index], 0, 0);
+}
+
+void Particles::updateSprite(size_t index, Sprite& sprite) const
+{
+	const auto& p = particles;
+	const float t = p.time[index] / p.ttl[index];
+	sprite
+		.setPosition(Vector2f(p.posX[index], p.posY[index] - p.posZ[index]))
+		.setRotation(Angle1f::fromRadians(p.angle[index], false))
+		.setScale(scaleCurve.evaluate(t) * p.scale[index])
+		.setColour(colourGradient.evaluate(t))
+		.setCustom1(Vector4f(p.posX[index], p.posY[index], 0, 0));
+}
+
+void Particles::updateSprites()
+{
+	if (!spritesDirty) {
+		return;
+	}
+	spritesDirty = false;
+
+	for (size_t i = 0; i < nParticlesAlive; ++i) {
+		updateSprite(i, sprites[i]);
+	}
+}
+
+uint32_t Particles::getRandomInt()
+{
+	// Park-Miller "minimal standard" generator, small enough to keep one per emitter. Returns [1, rngModulus - 1].
+	rngState = uint32_t(uint64_t(rngState) * 48271u % rngModulus);
+	return rngState;
+}
+
+float Particles::getRandomFloat(float min, float max)
+{
+	const auto t = float(double(getRandomInt() - 1) / double(rngModulus - 1));
+	return min + (max - min) * t;
+}
+
+float Particles::getRandomFloat(Range<float> range)
+{
+	return getRandomFloat(range.start, range.end);
 }
 
 void Particles::spawn(size_t n, float time)
@@ -367,90 +494,165 @@ void Particles::spawn(size_t n, float time)
 
 void Particles::initializeParticle(size_t index, float time)
 {
-	const auto startAzimuth = Angle1f::fromDegrees(rng->getFloat(azimuth));
-	const auto startElevation = Angle1f::fromDegrees(rng->getFloat(altitude));
+	const auto startAzimuth = Angle1f::fromDegrees(getRandomFloat(azimuth));
+	const auto startElevation = Angle1f::fromDegrees(getRandomFloat(altitude));
 	
-	auto& particle = particles[index];
-	particle.alive = true;
-	particle.time = time;
-	particle.ttl = rng->getFloat(ttl);
-	particle.angle = rotateTowardsMovement ? startAzimuth : Angle1f();
-	particle.scale = rng->getFloat(initialScale);
-
-	particle.vel = Vector3f(rng->getFloat(speed), startAzimuth, startElevation);
-	const bool stopped = stopTime > 0.00001f && particle.time + stopTime >= particle.ttl;
+	auto& p = particles;
+	p.time[index] = time;
+	p.ttl[index] = getRandomFloat(ttl);
+	p.angle[index] = rotateTowardsMovement ? startAzimuth.getRadians() : 0.0f;
+	p.scale[index] = getRandomFloat(initialScale);
+
+	const auto vel = Vector3f(getRandomFloat(speed), startAzimuth, startElevation);
+	const bool stopped = stopTime > 0.00001f && time + stopTime >= p.ttl[index];
 	const auto a = stopped ? Vector3f() : acceleration;
-	particle.pos = getSpawnPosition() + (particle.vel * time + a * (0.5f * time * time)) * velScale;
+	const auto pos = getSpawnPosition() + (vel * time + a * (0.5f * time * time)) * velScale;
+	p.posX[index] = pos.x;
+	p.posY[index] = pos.y;
+	p.posZ[index] = pos.z;
+	p.velX[index] = vel.x;
+	p.velY[index] = vel.y;
+	p.velZ[index] = vel.z;
 
 	auto& sprite = sprites[index];
 	if (isAnimated()) {
 		auto& anim = animationPlayers[index];
 		anim.update(0, sprite);
 	} else if (!baseSprites.empty()) {
-		sprite = rng->getRandomElement(baseSprites);
+		sprite = baseSprites[getRandomInt() % baseSprites.size()];
 	}
 }
 
 void Particles::updateParticles(float time)
 {
-	const bool hasAnim = isAnimated();
-	
-	for (size_t i = 0; i < nParticlesAlive; ++i) {
-		if (hasAnim) {
+	if (isAnimated()) {
+		for (size_t i = 0; i < nParticlesAlive; ++i) {
 			animationPlayers[i].update(time, sprites[i]);
 		}
-		
-		auto& particle = particles[i];
+	}
 
-		particle.time += time;
-		if (particle.time >= particle.ttl) {
-			particle.alive = false;
-		} else {
-			const bool stopped = stopTime > 0.00001f && particle.time + stopTime >= particle.ttl;
-			const auto a = stopped ? Vector3f() : acceleration;
-			particle.pos += (particle.vel * time + a * (0.5f * time * time)) * velScale;
-			particle.vel += a * time;
+	integrateParticles(time);
 
-			if (minHeight && particle.pos.z < minHeight) {
-				particle.alive = false;
-			}
-			
-			if (stopped) {
-				particle.vel = damp(particle.vel, Vector3f(), 10.0f, time);
-			}
-			
-			if (speedDamp > 0.0001f) {
-				particle.vel = damp(particle.vel, Vector3f(), speedDamp, time);
-			}
+	auto& p = particles;
+	if (directionScatter > 0.00001f) {
+		for (size_t i = 0; i < nParticlesAlive; ++i) {
+			const auto vel = Vector2f(p.velX[i], p.velY[i]).rotate(Angle1f::fromDegrees(getRandomFloat(-directionScatter * time, directionScatter * time)));
+			p.velX[i] = vel.x;
+			p.velY[i] = vel.y;
+		}
+	}
 
-			if (directionScatter > 0.00001f) {
-				particle.vel = Vector3f(particle.vel.xy().rotate(Angle1f::fromDegrees(rng->getFloat(-directionScatter * time, directionScatter * time))), particle.vel.z);
+	if (rotateTowardsMovement) {
+		for (size_t i = 0; i < nParticlesAlive; ++i) {
+			const auto vel = Vector3f(p.velX[i], p.velY[i], p.velZ[i]);
+			if (vel.squaredLength() > 0.001f) {
+				p.angle[i] = vel.xy().angle().getRadians();
 			}
+		}
+	}
+}
 
-			if (rotateTowardsMovement && particle.vel.squaredLength() > 0.001f) {
-				particle.angle = particle.vel.xy().angle();
-			}
+void Particles::integrateParticles(float dt)
+{
+	// Steps time, position and velocity of every particle. Particles that expire during this step are still integrated,
+	// removeDeadParticles() discards them afterwards.
+	auto& p = particles;
+	const size_t n = alignUp(nParticlesAlive, simdWidth);
+	Expects(n <= p.size());
+
+	const bool hasStopTime = stopTime > 0.00001f;
+	const float halfDt2 = 0.5f * dt * dt;
+	const float stopDamp = std::exp(-10.0f * dt);
+	const float speedDampFactor = speedDamp > 0.0001f ? std::exp(-speedDamp * dt) : 1.0f;
+
+	size_t i = 0;
+#ifdef HAS_SSE
+	const auto vDt = _mm_set1_ps(dt);
+	const auto vHalfDt2 = _mm_set1_ps(halfDt2);
+	const auto vStopTime = _mm_set1_ps(stopTime);
+	const auto vStopDamp = _mm_set1_ps(stopDamp);
+	const auto vSpeedDamp = _mm_set1_ps(speedDampFactor);
+	const auto vAccX = _mm_set1_ps(acceleration.x);
+	const auto vAccY = _mm_set1_ps(acceleration.y);
+	const auto vAccZ = _mm_set1_ps(acceleration.z);
+	const auto vScaleX = _mm_set1_ps(velScale.x);
+	const auto vScaleY = _mm_set1_ps(velScale.y);
+	const auto vScaleZ = _mm_set1_ps(velScale.z);
+	const auto vOne = _mm_set1_ps(1.0f);
+
+	for (; i < n; i += simdWidth) {
+		const auto t = _mm_add_ps(_mm_loadu_ps(p.time.data() + i), vDt);
+		_mm_storeu_ps(p.time.data() + i, t);
+
+		// Stopped particles have no acceleration and get their velocity damped
+		const auto stopped = hasStopTime ? _mm_cmpge_ps(_mm_add_ps(t, vStopTime), _mm_loadu_ps(p.ttl.data() + i)) : _mm_setzero_ps();
+		const auto damp = _mm_mul_ps(_mm_or_ps(_mm_and_ps(stopped, vStopDamp), _mm_andnot_ps(stopped, vOne)), vSpeedDamp);
+
+		const auto step = [&] (float* pos, float* vel, __m128 acc, __m128 scale)
+		{
+			const auto a = _mm_andnot_ps(stopped, acc);
+			const auto v = _mm_loadu_ps(vel + i);
+			const auto delta = _mm_add_ps(_mm_mul_ps(v, vDt), _mm_mul_ps(a, vHalfDt2));
+			_mm_storeu_ps(pos + i, _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(delta, scale)));
+			_mm_storeu_ps(vel + i, _mm_mul_ps(_mm_add_ps(v, _mm_mul_ps(a, vDt)), damp));
+		};
+		step(p.posX.data(), p.velX.data(), vAccX, vScaleX);
+		step(p.posY.data(), p.velY.data(), vAccY, vScaleY);
+		step(p.posZ.data(), p.velZ.data(), vAccZ, vScaleZ);
+	}
+#endif
+
+	for (; i < n; ++i) {
+		const float t = p.time[i] + dt;
+		p.time[i] = t;
+
+		const bool stopped = hasStopTime && t + stopTime >= p.ttl[i];
+		const auto a = stopped ? Vector3f() : acceleration;
+		const float damp = (stopped ? stopDamp : 1.0f) * speedDampFactor;
+
+		p.posX[i] += (p.velX[i] * dt + a.x * halfDt2) * velScale.x;
+		p.posY[i] += (p.velY[i] * dt + a.y * halfDt2) * velScale.y;
+		p.posZ[i] += (p.velZ[i] * dt + a.z * halfDt2) * velScale.z;
+		p.velX[i] = (p.velX[i] + a.x * dt) * damp;
+		p.velY[i] = (p.velY[i] + a.y * dt) * damp;
+		p.velZ[i] = (p.velZ[i] + a.z * dt) * damp;
+	}
+}
 
-			const float t = particle.time / particle.ttl;
+void Particles::removeDeadParticles()
+{
+	auto& p = particles;
+	const bool hasMinHeight = minHeight.has_value();
+	const float minZ = minHeight.value_or(0.0f);
 
-			sprites[i]
-				.setPosition(particle.pos.xy() + Vector2f(0, -particle.pos.z))
-				.setRotation(particle.angle)
-				.setScale(scaleCurve.evaluate(t) * particle.scale)
-				.setColour(colourGradient.evaluate(t))
-				.setCustom1(Vector4f(particle.pos.xy(), 0, 0));
+	for (size_t i = 0; i < nParticlesAlive; ) {
+		const bool alive = p.time[i] < p.ttl[i] && !(hasMinHeight && p.posZ[i] < minZ);
+		if (!alive) {
+			const size_t last = nParticlesAlive - 1;
+			if (i != last) {
+				// Move the last particle that's alive into this slot
+				p.move(last, i);
+				std::swap(sprites[i], sprites[last]);
+				if (isAnimated()) {
+					std::swap(animationPlayers[i], animationPlayers[last]);
+				}
+			}
+			--nParticlesAlive;
+			// Don't increment i here, since i is now a new particle that's still alive
+		} else {
+			++i;
 		}
 	}
 }
 
-Vector3f Particles::getSpawnPosition() const
+Vector3f Particles::getSpawnPosition()
 {
 	Vector2f pos;
 	if (spawnAreaShape == ParticleSpawnAreaShape::Rectangle) {
-		pos = Vector2f(rng->getFloat(-1, 1), rng->getFloat(-1, 1)) * spawnArea * 0.5f;
+		pos = Vector2f(getRandomFloat(-1, 1), getRandomFloat(-1, 1)) * spawnArea * 0.5f;
 	} else if (spawnAreaShape == ParticleSpawnAreaShape::Ellipse) {
-		const float radius = std::sqrt(rng->getFloat(0, 1));
-		const float angle = rng->getFloat(0.0f, 2.0f * pif());
+		const float radius = std::sqrt(getRandomFloat(0, 1));
+		const float angle = getRandomFloat(0.0f, 2.0f * pif());
 		pos = Vector2f(radius, 0).rotate(Angle1f::fromRadians(angle)) * spawnArea * 0.5f;
 	}
 	return position + Vector3f(pos, startHeight);
@@ -1,11 +1,15 @@
 #include "halley/graphics/sprite/sprite_painter.h"
 #include "halley/graphics/sprite/sprite.h"
+#include "halley/graphics/sprite/particles.h"
 #include "halley/graphics/painter.h"
 #include <gsl/gsl>
+#include <array>
+#include <cstring>
 
 #include "halley/graphics/material/material.h"
 #include "halley/graphics/text/text_renderer.h"
 #include "halley/utils/algorithm.h"
+#include "halley/maths/simd.h"
 
 using namespace Halley;
 
@@ -32,6 +36,18 @@ SpritePainterEntry::SpritePainterEntry(gsl::span<const TextRenderer> texts, int
 {
 }
 
+SpritePainterEntry::SpritePainterEntry(const Particles& particles, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip)
+	: ptr(&particles)
+	, count(1)
+	, type(SpritePainterEntryType::ParticlesRef)
+	, layer(layer)
+	, mask(mask)
+	, tieBreaker(tieBreaker)
+	, insertOrder(insertOrder)
+	, clip(clip)
+{
+}
+
 SpritePainterEntry::SpritePainterEntry(SpritePainterEntryType type, size_t spriteIdx, size_t count, int mask, int layer, float tieBreaker, size_t insertOrder, std::optional<Rect4f> clip)
 	: count(uint32_t(count))
 	, index(static_cast<int>(spriteIdx))
@@ -54,6 +70,19 @@ bool SpritePainterEntry::operator<(const SpritePainterEntry& o) const
 	}
 }
 
+uint64_t SpritePainterEntry::getSortKey() const
+{
+	// Maps (layer, tieBreaker) to an unsigned integer with the same ordering; insertion order is kept by sorting stably
+	const uint32_t layerBits = static_cast<uint32_t>(layer) ^ 0x80000000u;
+
+	const float tie = tieBreaker == 0.0f ? 0.0f : tieBreaker; // Treat -0 as 0
+	uint32_t tieBits;
+	memcpy(&tieBits, &tie, sizeof(tieBits));
+	tieBits = (tieBits & 0x80000000u) != 0 ? ~tieBits : (tieBits | 0x80000000u);
+
+	return (static_cast<uint64_t>(layerBits) << 32) | tieBits;
+}
+
 SpritePainterEntryType SpritePainterEntry::getType() const
 {
 	return type;
@@ -73,6 +102,13 @@ gsl::span<const TextRenderer> SpritePainterEntry::getTexts() const
 	return gsl::span<const TextRenderer>(static_cast<const TextRenderer*>(ptr), count);
 }
 
+const Particles& SpritePainterEntry::getParticles() const
+{
+	Expects(ptr != nullptr);
+	Expects(type == SpritePainterEntryType::ParticlesRef);
+	return *static_cast<const Particles*>(ptr);
+}
+
 uint32_t SpritePainterEntry::getIndex() const
 {
 	Expects(ptr == nullptr);
@@ -182,6 +218,19 @@ void SpritePainter::addCopy(const TextRenderer& text, int mask, int layer, float
 	dirty = true;
 }
 
+void SpritePainter::add(const Particles& particles, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip)
+{
+	// Particles are written straight into the vertex stream by Particles::draw(), rather than being expanded into sprites here.
+	// They aren't culled per particle.
+	if (forceCopy) {
+		add([copy = std::make_shared<const Particles>(particles)] (Painter& painter) { copy->draw(painter); }, mask, layer, tieBreaker, std::move(clip));
+	} else {
+		Expects(mask >= 0);
+		sprites.push_back(SpritePainterEntry(particles, mask, layer, tieBreaker, sprites.size(), std::move(clip)));
+		dirty = true;
+	}
+}
+
 void SpritePainter::add(SpritePainterEntry::Callback callback, int mask, int layer, float tieBreaker, std::optional<Rect4f> clip)
 {
 	Expects(mask >= 0);
@@ -193,31 +242,48 @@ void SpritePainter::add(SpritePainterEntry::Callback callback, int mask, int lay
 void SpritePainter::draw(int mask, Painter& painter)
 {
 	if (dirty) {
-		// TODO: implement hierarchical bucketing.
-		// - one bucket per layer
-		// - for each layer, one bucket per vertical band of the screen (32px or so)
-		// - sort each leaf bucket
-		std::sort(sprites.begin(), sprites.end()); // lol
+		sortEntries();
 		dirty = false;
 	}
 
 	// View
 	const auto& cam = painter.getCurrentCamera();
-	Rect4f view = cam.getClippingRectangle();
+	const Rect4f view = cam.getClippingRectangle();
+
+	// Cull every sprite up front, in draw order
+	cullList.clear();
+	for (auto& s : sprites) {
+		if ((s.getMask() & mask) != 0) {
+			const auto type = s.getType();
+			if (type == SpritePainterEntryType::SpriteRef) {
+				for (const auto& sprite: s.getSprites()) {
+					cullList.push_back(&sprite);
+				}
+			} else if (type == SpritePainterEntryType::SpriteCached) {
+				for (const auto& sprite: gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount())) {
+					cullList.push_back(&sprite);
+				}
+			}
+		}
+	}
+	cullSprites(view);
 
 	// Draw!
+	size_t cullIdx = 0;
 	for (auto& s : sprites) {
 		if ((s.getMask() & mask) != 0) {
 			const auto type = s.getType();
 			
 			if (type == SpritePainterEntryType::SpriteRef) {
-				draw(s.getSprites(), painter, view, s.getClip());
+				draw(s.getSprites(), cullIdx, painter, s.getClip());
 			} else if (type == SpritePainterEntryType::SpriteCached) {
-				draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+				draw(gsl::span<const Sprite>(cachedSprites.data() + s.getIndex(), s.getCount()), cullIdx, painter, s.getClip());
 			} else if (type == SpritePainterEntryType::TextRef) {
 				draw(s.getTexts(), painter, view, s.getClip());
 			} else if (type == SpritePainterEntryType::TextCached) {
 				draw(gsl::span<const TextRenderer>(cachedText.data() + s.getIndex(), s.getCount()), painter, view, s.getClip());
+			} else if (type == SpritePainterEntryType::ParticlesRef) {
+				draw(s.getParticles(), painter, s.getClip());
 			} else if (type == SpritePainterEntryType::Callback) {
 				draw(callbacks.at(s.getIndex()), painter, s.getClip());
 			}
@@ -239,10 +305,81 @@ std::optional<Rect4f> SpritePainter::getBounds() const
 	return result;
 }
 
-void SpritePainter::draw(gsl::span<const Sprite> sprites, Painter& painter, Rect4f view, const std::optional<Rect4f>& clip) const
+void SpritePainter::sortEntries()
+{
+	const size_t n = sprites.size();
+	if (n < 64) {
+		std::stable_sort(sprites.begin(), sprites.end());
+		return;
+	}
+
+	sortKeys.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		sortKeys[i] = sprites[i].getSortKey();
+	}
+	radixSortStable(sprites, sortKeys, sortScratch, sortKeysScratch);
+}
+
+void SpritePainter::cullSprites(Rect4f view)
+{
+	const size_t n = cullList.size();
+	cullMinX.resize(n);
+	cullMinY.resize(n);
+	cullMaxX.resize(n);
+	cullMaxY.resize(n);
+	cullVisible.resize(n);
+
+	for (size_t i = 0; i < n; ++i) {
+		const auto& sprite = *cullList[i];
+		if (sprite.isVisible()) {
+			const auto aabb = sprite.getAABB();
+			const auto p1 = aabb.getTopLeft();
+			const auto p2 = aabb.getBottomRight();
+			cullMinX[i] = p1.x;
+			cullMinY[i] = p1.y;
+			cullMaxX[i] = p2.x;
+			cullMaxY[i] = p2.y;
+		} else {
+			// An inverted box never overlaps anything
+			cullMinX[i] = std::numeric_limits<float>::infinity();
+			cullMinY[i] = std::numeric_limits<float>::infinity();
+			cullMaxX[i] = -std::numeric_limits<float>::infinity();
+			cullMaxY[i] = -std::numeric_limits<float>::infinity();
+		}
+	}
+
+	// Same test as Rect4f::overlaps
+	const float viewMinX = view.getTopLeft().x;
+	const float viewMinY = view.getTopLeft().y;
+	const float viewMaxX = view.getBottomRight().x;
+	const float viewMaxY = view.getBottomRight().y;
+	size_t i = 0;
+
+#ifdef HAS_SSE
+	const auto vMinX = _mm_set1_ps(viewMinX);
+	const auto vMinY = _mm_set1_ps(viewMinY);
+	const auto vMaxX = _mm_set1_ps(viewMaxX);
+	const auto vMaxY = _mm_set1_ps(viewMaxY);
+	for (; i + 4 <= n; i += 4) {
+		const auto overlapX = _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(cullMaxX.data() + i), vMinX), _mm_cmpgt_ps(vMaxX, _mm_loadu_ps(cullMinX.data() + i)));
+		const auto overlapY = _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(cullMaxY.data() + i), vMinY), _mm_cmpgt_ps(vMaxY, _mm_loadu_ps(cullMinY.data() + i)));
+		const int bits = _mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+		cullVisible[i] = uint8_t(bits & 1);
+		cullVisible[i + 1] = uint8_t((bits >> 1) & 1);
+		cullVisible[i + 2] = uint8_t((bits >> 2) & 1);
+		cullVisible[i + 3] = uint8_t((bits >> 3) & 1);
+	}
+#endif
+
+	for (; i < n; ++i) {
+		cullVisible[i] = uint8_t((cullMaxX[i] > viewMinX) & (viewMaxX > cullMinX[i]) & (cullMaxY[i] > viewMinY) & (viewMaxY > cullMinY[i]));
+	}
+}
+
+void SpritePainter::draw(gsl::span<const Sprite> sprites, size_t& cullIdx, Painter& painter, const std::optional<Rect4f>& clip) const
 {
 	for (const auto& sprite: sprites) {
-		if (sprite.isInView(view)) {
+		if (cullVisible[cullIdx++] != 0) {
 			sprite.draw(painter, clip);
 		}
 	}
@@ -255,6 +392,17 @@ void SpritePainter::draw(gsl::span<const TextRenderer> texts, Painter& painter,
 	}
 }
 
+void SpritePainter::draw(const Particles& particles, Painter& painter, const std::optional<Rect4f>& clip) const
+{
+	if (clip) {
+		painter.setRelativeClip(clip.value());
+	}
+	particles.draw(painter);
+	if (clip) {
+		painter.setClip();
+	}
+}
+
 void SpritePainter::draw(const SpritePainterEntry::Callback& callback, Painter& painter, const std::optional<Rect4f>& clip) const
 {
 	if (clip) {
@@ -2,6 +2,7 @@
 #include "halley/graphics/text/font.h"
 #include "halley/graphics/painter.h"
 #include "halley/graphics/material/material.h"
+#include "halley/graphics/material/material_definition.h"
 #include "halley/graphics/material/material_parameter.h"
 #include <gsl/gsl_assert>
 
@@ -37,6 +38,7 @@ TextRenderer& TextRenderer::setFont(std::shared_ptr<const Font> v)
 {
 	if (font != v) {
 		font = v;
+		glyphsDirty = true;
 
 		if (font->isDistanceField()) {
 			materialDirty = true;
@@ -240,6 +242,70 @@ void TextRenderer::generateSprites(Vector<Sprite>& sprites) const
 		return;
 	}
 
+	updateLayout();
+
+	sprites.resize(nLayoutGlyphs);
+	for (const auto& run: glyphRuns) {
+		for (const auto& glyph: run.glyphs) {
+			sprites[glyph.index] = Sprite()
+				.setMaterial(run.material)
+				.setSize(glyph.size)
+				.setTexRect(glyph.texRect)
+				.setColour(glyph.colour)
+				.setPivot(glyph.pivot)
+				.setScale(glyph.scale)
+				.setPos(layoutOrigin + glyph.pos);
+		}
+	}
+}
+
+void TextRenderer::draw(Painter& painter, const std::optional<Rect4f>& extClip) const
+{
+	if (!font) {
+		return;
+	}
+
+	updateLayout();
+
+	const std::optional<Rect4f> myClip = clip ? clip.value() + position : std::optional<Rect4f>();
+	const auto finalClip = Rect4f::optionalIntersect(myClip, extClip);
+	if (finalClip) {
+		painter.setRelativeClip(finalClip.value());
+	}
+
+	if (spriteFilter) {
+		// We don't know what the user will do with glyphs, so they need to go through full sprites
+		generateSprites(spritesCache);
+		spriteFilter(gsl::span<Sprite>(spritesCache.data(), spritesCache.size()));
+		Sprite::drawMixedMaterials(spritesCache.data(), spritesCache.size(), painter);
+	} else {
+		for (const auto& run: glyphRuns) {
+			Expects(run.material->getDefinition().getVertexStride() == sizeof(SpriteVertexAttrib) + sizeof(Vector4f));
+
+			painter.drawSprites(run.material, run.glyphs.size(), [&] (size_t firstSprite, size_t numSprites, char* dst, size_t dstStride)
+			{
+				SpriteVertexAttrib vertex;
+				for (size_t i = 0; i < numSprites; ++i) {
+					const auto& glyph = run.glyphs[firstSprite + i];
+					vertex.pos = layoutOrigin + glyph.pos;
+					vertex.pivot = glyph.pivot;
+					vertex.size = glyph.size;
+					vertex.scale = Vector2f(glyph.scale, glyph.scale);
+					vertex.colour = glyph.colour;
+					vertex.texRect0 = glyph.texRect;
+					memcpy(dst + i * dstStride + sizeof(Vector4f), &vertex, sizeof(vertex));
+				}
+			});
+		}
+	}
+
+	if (finalClip) {
+		painter.setClip();
+	}
+}
+
+void TextRenderer::updateLayout() const
+{
 	bool floorEnabled = font->shouldFloorGlyphPosition();
 	auto floorAlign = [floorEnabled] (Vector2f a) -> Vector2f
 	{
@@ -256,49 +322,50 @@ void TextRenderer::generateSprites(Vector<Sprite>& sprites) const
 		materialDirty = false;
 	}
 
-	if (glyphsDirty || positionDirty) {
-		float mainScale = getScale(*font);
-		Vector2f p = floorAlign(position + Vector2f(0, font->getAscenderDistance() * mainScale));
-		if (offset != Vector2f(0, 0)) {
-			p -= floorAlign(getExtents() * offset);
+	if (glyphsDirty) {
+		// Glyphs are laid out relative to the pen's starting point, so moving the text doesn't require doing this again
+		for (auto& run: glyphRuns) {
+			run.glyphs.clear();
 		}
+		nLayoutGlyphs = 0;
 
-		size_t startPos = 0;
-		size_t spritesInserted = 0;
+		Vector2f p;
 		Vector2f lineOffset;
+		Vector<std::pair<uint32_t, uint32_t>> lineGlyphs; // Run and glyph index of each glyph in the current line
 
 		auto flush = [&] ()
 		{
 			// Line break, update previous characters!
 			if (align != 0) {
 				Vector2f off = floorAlign(-lineOffset * align);
-				for (size_t j = startPos; j < spritesInserted; j++) {
-					auto& sprite = sprites[j];
-					sprite.setPos(sprite.getPosition() + off);
+				for (const auto& [run, idx]: lineGlyphs) {
+					glyphRuns[run].glyphs[idx].pos += off;
 				}
 			}
+			lineGlyphs.clear();
 
 			// Move pen
 			p.y += getLineHeight();
 
 			// Reset
-			startPos = spritesInserted;
 			lineOffset.x = 0;
 		};
 
+		auto getRun = [&] (const std::shared_ptr<const Material>& material) -> uint32_t
+		{
+			for (size_t i = 0; i < glyphRuns.size(); ++i) {
+				if (glyphRuns[i].material == material) {
+					return static_cast<uint32_t>(i);
+				}
+			}
+			glyphRuns.push_back(GlyphRun{ material, {} });
+			return static_cast<uint32_t>(glyphRuns.size() - 1);
+		};
+
 		auto curCol = colour;
 		size_t curOverride = 0;
 
 		const size_t n = text.size();
-
-		size_t nGlyphs = 0;
-		for (size_t i = 0; i < n; i++) {
-			if (text[i] != '\n') {
-				++nGlyphs;
-			}
-		}
-		sprites.resize(nGlyphs);
-
 		for (size_t i = 0; i < n; i++) {
 			int c = text[i];
 
@@ -315,16 +382,18 @@ void TextRenderer::generateSprites(Vector<Sprite>& sprites) const
 				const float scale = getScale(fontForGlyph);
 				const auto fontAdjustment = floorAlign(Vector2f(0, fontForGlyph.getAscenderDistance() - font->getAscenderDistance()) * scale);
 
-				std::shared_ptr<Material> materialToUse = hasMaterialOverride ? getMaterial(fontForGlyph) : fontForGlyph.getMaterial();
+				const auto runIdx = getRun(hasMaterialOverride ? getMaterial(fontForGlyph) : fontForGlyph.getMaterial());
+				auto& run = glyphRuns[runIdx];
+				lineGlyphs.emplace_back(runIdx, static_cast<uint32_t>(run.glyphs.size()));
 
-				sprites[spritesInserted++] = Sprite()
-					.setMaterial(std::move(materialToUse))
-					.setSize(glyph.size)
-					.setTexRect(glyph.area)
-					.setColour(curCol)
-					.setPivot(glyph.horizontalBearing / glyph.size * Vector2f(-1, 1))
-					.setScale(scale)
-					.setPos(p + lineOffset + pixelOffset + fontAdjustment);
+				auto& dst = run.glyphs.emplace_back();
+				dst.pos = p + lineOffset + pixelOffset + fontAdjustment;
+				dst.pivot = glyph.horizontalBearing / glyph.size * Vector2f(-1, 1);
+				dst.size = glyph.size;
+				dst.texRect = glyph.area;
+				dst.colour = curCol;
+				dst.scale = scale;
+				dst.index = static_cast<uint32_t>(nLayoutGlyphs++);
 
 				lineOffset.x += glyph.advance.x * scale;
 
@@ -334,32 +403,18 @@ void TextRenderer::generateSprites(Vector<Sprite>& sprites) const
 			}
 		}
 
-		glyphsDirty = false;
-		positionDirty = false;
-	}
-}
+		// Drop materials that are no longer used
+		glyphRuns.erase(std::remove_if(glyphRuns.begin(), glyphRuns.end(), [] (const GlyphRun& run) { return run.glyphs.empty(); }), glyphRuns.end());
 
-void TextRenderer::draw(Painter& painter, const std::optional<Rect4f>& extClip) const
-{
-	generateSprites(spritesCache);
-
-	if (spriteFilter) {
-		// We don't know what the user will do with glyphs, so mark them as dirty
-		spriteFilter(gsl::span<Sprite>(spritesCache.data(), spritesCache.size()));
-		glyphsDirty = true;
+		layoutExtents = offset != Vector2f(0, 0) ? getExtents() : Vector2f();
+		glyphsDirty = false;
 		positionDirty = true;
 	}
 
-	const std::optional<Rect4f> myClip = clip ? clip.value() + position : std::optional<Rect4f>();
-	const auto finalClip = Rect4f::optionalIntersect(myClip, extClip);
-	if (finalClip) {
-		painter.setRelativeClip(finalClip.value());
-	}
-	
-	Sprite::drawMixedMaterials(spritesCache.data(), spritesCache.size(), painter);
-
-	if (finalClip) {
-		painter.setClip();
+	if (positionDirty) {
+		const float mainScale = getScale(*font);
+		layoutOrigin = floorAlign(position + Vector2f(0, font->getAscenderDistance() * mainScale)) - floorAlign(layoutExtents * offset);
+		positionDirty = false;
 	}
 }
 
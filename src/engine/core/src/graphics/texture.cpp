@@ -177,27 +177,33 @@ std::shared_ptr<Texture> Texture::loadResource(ResourceLoader& loader)
 	{
 		auto& meta = texture->getMeta();
 
-		const auto imgFormat = fromString<Image::Format>(meta.getString("format", "rgba"));
+		const auto& compression = meta.getString("compression");
+		const bool blockCompressed = compression == "block";
+
 		TextureFormat format = TextureFormat::RGBA;
-		switch (imgFormat) {
-		case Image::Format::Indexed:
-			format = TextureFormat::Indexed;
-			break;
-		case Image::Format::RGB:
-			format = TextureFormat::RGB;
-			break;
-		case Image::Format::RGBA:
-		case Image::Format::RGBAPremultiplied:
-			format = TextureFormat::RGBA;
-			break;
-		case Image::Format::SingleChannel:
-			format = TextureFormat::Red;
-			break;
-		case Image::Format::Undefined:
-			format = TextureFormat::RGBA; // Hmm
+		if (blockCompressed) {
+			format = fromString<TextureFormat>(meta.getString("textureFormat"));
+		} else {
+			const auto imgFormat = fromString<Image::Format>(meta.getString("format", "rgba"));
+			switch (imgFormat) {
+			case Image::Format::Indexed:
+				format = TextureFormat::Indexed;
+				break;
+			case Image::Format::RGB:
+				format = TextureFormat::RGB;
+				break;
+			case Image::Format::RGBA:
+			case Image::Format::RGBAPremultiplied:
+				format = TextureFormat::RGBA;
+				break;
+			case Image::Format::SingleChannel:
+				format = TextureFormat::Red;
+				break;
+			case Image::Format::Undefined:
+				format = TextureFormat::RGBA; // Hmm
+			}
 		}
 
-		const auto& compression = meta.getString("compression");
 		Vector2i size(meta.getInt("width"), meta.getInt("height"));
 		
 		TextureDescriptor descriptor(size);
@@ -207,7 +213,8 @@ std::shared_ptr<Texture> Texture::loadResource(ResourceLoader& loader)
 		descriptor.format = format;
 		descriptor.pixelData = std::move(img);
 		descriptor.pixelFormat = compression == "png" || compression == "qoi" || compression == "hlif" ? PixelDataFormat::Image : PixelDataFormat::Precompiled;
-		descriptor.retainPixelData = retain;
+		descriptor.retainPixelData = retain; // Block-compressed textures keep their encoded blocks, there's no image to sample them from
+		descriptor.mipLevels = blockCompressed ? meta.getInt("mipLevels", 1) : 1;
 		texture->load(std::move(descriptor));
 	});
 
@@ -146,6 +146,7 @@ TextureDescriptor& TextureDescriptor::operator=(TextureDescriptor&& other) noexc
 	isDepthStencil = other.isDepthStencil;
 	retainPixelData = other.retainPixelData;
 	canBeReadOnCPU = other.canBeReadOnCPU;
+	mipLevels = other.mipLevels;
 	return *this;
 }
 
@@ -167,10 +168,61 @@ int TextureDescriptor::getBytesPerPixel(TextureFormat format)
 		return 1;
 	case TextureFormat::RGBAFloat16:
 		return 8;
+	case TextureFormat::BC1:
+	case TextureFormat::BC3:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC2RGB:
+	case TextureFormat::ETC2RGBA:
+	case TextureFormat::ASTC4x4:
+		// Sampled as RGBA, see getByteSize for their storage size
+		return 4;
 	}
 	throw Exception("Unknown image format: " + toString(format), HalleyExceptions::Graphics);
 }
 
+bool TextureDescriptor::isBlockCompressed(TextureFormat format)
+{
+	return getBytesPerBlock(format) > 0;
+}
+
+size_t TextureDescriptor::getBytesPerBlock(TextureFormat format)
+{
+	switch (format) {
+	case TextureFormat::BC1:
+	case TextureFormat::ETC2RGB:
+		return 8;
+	case TextureFormat::BC3:
+	case TextureFormat::BC7:
+	case TextureFormat::ETC2RGBA:
+	case TextureFormat::ASTC4x4:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t TextureDescriptor::getByteSize(TextureFormat format, Vector2i size)
+{
+	if (const auto blockBytes = getBytesPerBlock(format); blockBytes > 0) {
+		return size_t((size.x + 3) / 4) * size_t((size.y + 3) / 4) * blockBytes;
+	}
+	return size_t(size.x) * size_t(size.y) * size_t(getBytesPerPixel(format));
+}
+
+int TextureDescriptor::getMaxMipLevels(Vector2i size)
+{
+	int levels = 1;
+	for (int s = std::max(size.x, size.y); s > 1; s /= 2) {
+		++levels;
+	}
+	return levels;
+}
+
+Vector2i TextureDescriptor::getMipSize(Vector2i size, int level)
+{
+	return Vector2i(std::max(size.x >> level, 1), std::max(size.y >> level, 1));
+}
+
 size_t TextureDescriptor::getMemoryUsage() const
 {
 	return pixelData.getMemoryUsage();
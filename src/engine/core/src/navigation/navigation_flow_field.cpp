@@ -0,0 +1,153 @@
+#include "halley/navigation/navigation_flow_field.h"
+
+#include "halley/navigation/navmesh_set.h"
+using namespace Halley;
+
+NavigationFlowField::NavigationFlowField(const NavmeshSet& navmeshSet, WorldPosition goal)
+	: goal(goal)
+{
+	const auto idx = navmeshSet.getNavMeshIdxAt(goal);
+	if (idx == std::numeric_limits<size_t>::max()) {
+		return;
+	}
+
+	const auto navmeshes = navmeshSet.getNavmeshes();
+	regionId = static_cast<uint16_t>(idx);
+	auto& goalField = regions[regionId];
+	navmeshes[idx].computeCostsToGoal(goal.pos, goalField.costs, goalField.nextHops);
+
+	// Every other region heads for whichever of its portals is cheapest from there
+	const auto portalCosts = navmeshSet.getPortalCostsToGoal(regionId, navmeshes[idx].getPortalCostsToGoal(goalField.costs));
+	for (size_t i = 0; i < portalCosts.size(); ++i) {
+		const bool reachable = std::any_of(portalCosts[i].begin(), portalCosts[i].end(), [] (float cost) { return std::isfinite(cost); });
+		if (i != idx && reachable) {
+			auto& field = regions[static_cast<uint16_t>(i)];
+			navmeshes[i].computeCostsToExits(portalCosts[i], field.costs, field.nextHops);
+		}
+	}
+}
+
+bool NavigationFlowField::isValid() const
+{
+	const auto iter = regions.find(regionId);
+	return iter != regions.end() && !iter->second.costs.empty();
+}
+
+bool NavigationFlowField::contains(const NavmeshSet& navmeshSet, WorldPosition pos) const
+{
+	return getRegionAt(navmeshSet, pos).has_value();
+}
+
+std::optional<uint16_t> NavigationFlowField::getRegionAt(const NavmeshSet& navmeshSet, WorldPosition pos) const
+{
+	const auto idx = navmeshSet.getNavMeshIdxAt(pos);
+	if (idx == std::numeric_limits<size_t>::max() || !getNodeAt(navmeshSet, pos, static_cast<uint16_t>(idx))) {
+		return {};
+	}
+	return static_cast<uint16_t>(idx);
+}
+
+std::optional<Vector2f> NavigationFlowField::getNextPosition(const NavmeshSet& navmeshSet, WorldPosition pos) const
+{
+	const auto idx = navmeshSet.getNavMeshIdxAt(pos);
+	if (idx == std::numeric_limits<size_t>::max()) {
+		return {};
+	}
+	return getNextPosition(navmeshSet, pos, static_cast<uint16_t>(idx));
+}
+
+std::optional<Vector2f> NavigationFlowField::getNextPosition(const NavmeshSet& navmeshSet, WorldPosition pos, uint16_t region) const
+{
+	const auto node = getNodeAt(navmeshSet, pos, region);
+	if (!node) {
+		return {};
+	}
+
+	const auto& navmesh = navmeshSet.getNavmeshes()[region];
+	const auto next = getRegionField(navmeshSet, region)->nextHops[*node];
+	if (next.node == Navmesh::NodeAndConn().node) {
+		if (next.connectionIdx == Navmesh::NodeAndConn().connectionIdx) {
+			// Already in the goal's polygon
+			return goal.pos;
+		}
+
+		// Leaving the region, aim slightly past the portal so the agent ends up in the next region instead of stopping on the border
+		constexpr float portalNudge = 0.1f;
+		const auto& portal = navmesh.getPortals()[next.connectionIdx];
+		const auto dir = portal.pos - navmesh.getNodes()[*node].pos;
+		return dir.squaredLength() > 0 ? portal.pos + dir.normalized() * portalNudge : portal.pos;
+	}
+
+	// Head for the closest point on the edge into the next polygon, keeping away from its ends so agents don't cut corners
+	const auto edge = navmesh.getPolygon(*node).getEdge(next.connectionIdx);
+	constexpr float cornerMargin = 0.1f;
+	const auto target = LineSegment(lerp(edge.a, edge.b, cornerMargin), lerp(edge.a, edge.b, 1.0f - cornerMargin));
+	return target.getClosestPoint(pos.pos);
+}
+
+std::optional<float> NavigationFlowField::getCost(const NavmeshSet& navmeshSet, WorldPosition pos) const
+{
+	const auto idx = navmeshSet.getNavMeshIdxAt(pos);
+	if (idx == std::numeric_limits<size_t>::max()) {
+		return {};
+	}
+
+	const auto region = static_cast<uint16_t>(idx);
+	const auto node = getNodeAt(navmeshSet, pos, region);
+	if (!node) {
+		return {};
+	}
+	return getRegionField(navmeshSet, region)->costs[*node];
+}
+
+const NavigationFlowField::RegionField* NavigationFlowField::getRegionField(const NavmeshSet& navmeshSet, uint16_t region) const
+{
+	const auto iter = regions.find(region);
+	if (iter == regions.end() || region >= navmeshSet.getNavmeshes().size() || navmeshSet.getNavmeshes()[region].getNumNodes() != iter->second.costs.size()) {
+		return nullptr;
+	}
+	return &iter->second;
+}
+
+std::optional<Navmesh::NodeId> NavigationFlowField::getNodeAt(const NavmeshSet& navmeshSet, WorldPosition pos, uint16_t region) const
+{
+	const auto* field = getRegionField(navmeshSet, region);
+	if (!field) {
+		return {};
+	}
+
+	const auto& navmesh = navmeshSet.getNavmeshes()[region];
+	if (navmesh.getSubWorld() != pos.subWorld) {
+		return {};
+	}
+
+	const auto node = navmesh.getNodeAt(pos.pos);
+	if (!node || !std::isfinite(field->costs[*node])) {
+		return {};
+	}
+	return node;
+}
+
+NavigationFlowFieldCache::NavigationFlowFieldCache(float goalMoveThreshold)
+	: goalMoveThreshold(goalMoveThreshold)
+{
+}
+
+std::shared_ptr<const NavigationFlowField> NavigationFlowFieldCache::getFlowField(const NavmeshSet& navmeshSet, WorldPosition goal)
+{
+	const auto idx = navmeshSet.getNavMeshIdxAt(goal);
+	if (idx == std::numeric_limits<size_t>::max()) {
+		return {};
+	}
+
+	auto& field = fields[static_cast<uint16_t>(idx)];
+	if (!field || field->getGoal().subWorld != goal.subWorld || (field->getGoal().pos - goal.pos).length() > goalMoveThreshold) {
+		field = std::make_shared<NavigationFlowField>(navmeshSet, goal);
+	}
+	return field;
+}
+
+void NavigationFlowFieldCache::clear()
+{
+	fields.clear();
+}
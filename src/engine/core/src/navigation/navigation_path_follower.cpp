@@ -1,5 +1,6 @@
 #include "halley/navigation/navigation_path_follower.h"
 
+#include "halley/navigation/navigation_flow_field.h"
 #include "halley/navigation/navmesh_set.h"
 #include "halley/support/debug.h"
 #include "halley/support/logger.h"
@@ -42,6 +43,8 @@ ConfigNode NavigationPathFollower::toConfigNode() const
 
 void NavigationPathFollower::setPath(std::optional<NavigationPath> p, ConfigNode params)
 {
+	flowField.reset();
+	flowFieldTarget.reset();
 	doSetPath(std::move(p));
 	this->params = std::move(params);
 	this->params.ensureType(ConfigNodeType::Map);
@@ -72,10 +75,73 @@ gsl::span<const Vector2f> NavigationPathFollower::getNextPathPoints() const
 	return path->path.span().subspan(nextPathIdx);
 }
 
+void NavigationPathFollower::setFlowField(std::shared_ptr<const NavigationFlowField> field, ConfigNode params)
+{
+	this->params = std::move(params);
+	this->params.ensureType(ConfigNodeType::Map);
+
+	if (field == flowField) {
+		return;
+	}
+
+	flowField = field && field->isValid() ? std::move(field) : nullptr;
+	flowFieldTarget.reset();
+	doSetPath({});
+}
+
+const std::shared_ptr<const NavigationFlowField>& NavigationPathFollower::getFlowField() const
+{
+	return flowField;
+}
+
 void NavigationPathFollower::update(WorldPosition curPos, const NavmeshSet& navmeshSet, float threshold)
 {
 	this->curPos = curPos;
 
+	if (flowField) {
+		updateFlowField(navmeshSet, threshold);
+	} else {
+		updatePath(navmeshSet, threshold);
+	}
+}
+
+void NavigationPathFollower::updateFlowField(const NavmeshSet& navmeshSet, float threshold)
+{
+	if (const auto region = flowField->getRegionAt(navmeshSet, curPos)) {
+		if (path) {
+			doSetPath({});
+		}
+		navmeshSubWorld = curPos.subWorld;
+		flowFieldRegionId = *region;
+
+		if ((flowField->getGoal().pos - curPos.pos).length() < threshold) {
+			flowField.reset();
+			flowFieldTarget.reset();
+			return;
+		}
+
+		flowFieldTarget = flowField->getNextPosition(navmeshSet, curPos, *region);
+		if (!flowFieldTarget) {
+			// Goal can't be reached from here
+			flowField.reset();
+		}
+		return;
+	}
+
+	// Not on the field (e.g. pushed slightly off the navmesh), so path back to the goal like any other agent
+	flowFieldTarget.reset();
+	if (!path) {
+		doSetPath(navmeshSet.pathfind(NavigationQuery(curPos, flowField->getGoal(), NavigationQuery::PostProcessingType::Aggressive)));
+		if (!path) {
+			flowField.reset();
+			return;
+		}
+	}
+	updatePath(navmeshSet, threshold);
+}
+
+void NavigationPathFollower::updatePath(const NavmeshSet& navmeshSet, float threshold)
+{
 	if (!path) {
 		return;
 	}
@@ -161,6 +227,9 @@ void NavigationPathFollower::reEvaluatePath(const NavmeshSet& navmeshSet)
 
 Vector2f NavigationPathFollower::getNextPosition() const
 {
+	if (flowFieldTarget) {
+		return *flowFieldTarget;
+	}
 	return path->path.size() > nextPathIdx ? path->path[nextPathIdx] : curPos.pos;
 }
 
@@ -171,6 +240,9 @@ size_t NavigationPathFollower::getNextPathIdx() const
 
 uint16_t NavigationPathFollower::getCurrentRegionId() const
 {
+	if (flowFieldTarget) {
+		return flowFieldRegionId;
+	}
 	if (!path) {
 		return std::numeric_limits<uint16_t>::max();
 	}
@@ -185,7 +257,7 @@ uint16_t NavigationPathFollower::getCurrentRegionId() const
 
 bool NavigationPathFollower::isDone() const
 {
-	return !path;
+	return !path && !flowField;
 }
 
 int NavigationPathFollower::getNavmeshSubWorld() const
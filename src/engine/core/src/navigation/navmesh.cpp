@@ -61,6 +61,7 @@ Navmesh::Navmesh(Vector<PolygonData> polys, const NavmeshBounds& bounds, int sub
 	// Generate edges
 	postProcessPortals();
 	generateOpenEdges();
+	addEdgesToGrid();
 }
 
 Navmesh::Navmesh(const ConfigNode& nodeData)
@@ -76,6 +77,7 @@ Navmesh::Navmesh(const ConfigNode& nodeData)
 
 	processPolygons();
 	generateOpenEdges();
+	addEdgesToGrid();
 }
 
 ConfigNode Navmesh::toConfigNode() const
@@ -96,6 +98,7 @@ ConfigNode Navmesh::toConfigNode() const
 
 void Navmesh::serialize(Serializer& s) const
 {
+	s << version;
 	s << scaleFactor;
 	s << origin;
 	s << normalisedCoordinatesBase;
@@ -104,10 +107,20 @@ void Navmesh::serialize(Serializer& s) const
 	s << portals;
 	s << subWorld;
 	s << weights;
+	s << edgeGrid;
 }
 
 void Navmesh::deserialize(Deserializer& s)
 {
+	// Old versions didn't have a version header, they start with scaleFactor, which never reads as a small int
+	int v;
+	s.peek(v);
+	if (v >= 0 && v <= 255) {
+		s >> v;
+	} else {
+		v = 0;
+	}
+
 	s >> scaleFactor;
 	s >> origin;
 	s >> normalisedCoordinatesBase;
@@ -116,9 +129,17 @@ void Navmesh::deserialize(Deserializer& s)
 	s >> portals;
 	s >> subWorld;
 	s >> weights;
+	if (v >= 1) {
+		s >> edgeGrid;
+	}
 
 	processPolygons();
 	generateOpenEdges();
+
+	// Older data, or data saved with a different grid resolution, needs the edge grid built again
+	if (edgeGrid.size() != static_cast<size_t>(gridSize.x * gridSize.y)) {
+		addEdgesToGrid();
+	}
 }
 
 const Polygon& Navmesh::getPolygon(int id) const
@@ -155,20 +176,9 @@ std::optional<Navmesh::NodeId> Navmesh::getNodeAt(Vector2f position) const
 		}
 	}
 
-	// If we don't find it even in this cell, then look on the open edges
-	{
-		float bestDist = std::numeric_limits<float>::infinity();
-		int bestNode = -1;
-		for (const auto& edge: openEdges) {
-			const float distSquared = (position - edge.second.getClosestPoint(position)).squaredLength();
-			if (distSquared < bestDist && std::sqrt(distSquared) < maxDistanceToPolygon) {
-				bestDist = distSquared;
-				bestNode = edge.first;
-			}
-		}
-		if (bestNode != -1) {
-			return gsl::narrow<NodeId>(bestNode);
-		}
+	// If we don't find it even in this cell, then look on the open edges around it
+	if (const auto edge = findClosestOpenEdge(position, 1.0f, maxDistanceToPolygon)) {
+		return edge->first;
 	}
 
 	// Give up
@@ -194,23 +204,11 @@ std::optional<Vector2f> Navmesh::getClosestPointTo(Vector2f pos, float anisotrop
 		return pos;
 	}
 
-	float bestDist = std::numeric_limits<float>::infinity();
-	std::optional<Vector2f> bestPoint;
-
-	for (const auto& poly: polygons) {
-		// Coarse test vs circle first
-		const auto distToCircle = poly.getBoundingCircle().getDistanceTo(pos);
-		if (distToCircle <= bestDist) {
-			const auto p = poly.getClosestPoint(pos, anisotropy);
-			const float dist = (p - pos).length();
-			if (dist < bestDist) {
-				bestPoint = p;
-				bestDist = dist;
-			}
-		}
+	// Outside of the navmesh, so the closest point must be on one of its open edges
+	if (const auto edge = findClosestOpenEdge(pos, anisotropy, std::numeric_limits<float>::infinity())) {
+		return edge->second;
 	}
-
-	return bestPoint;
+	return {};
 }
 
 NavmeshBounds::NavmeshBounds(Vector2f origin, Vector2f side0, Vector2f side1, size_t side0Divisions, size_t side1Divisions, Vector2f scaleFactor)
@@ -373,7 +371,7 @@ std::optional<NavigationPath> Navmesh::pathfind(const NavigationQuery& query) co
 	return makePath(query, nodePath.value());
 }
 
-Vector<Navmesh::NodeAndConn> Navmesh::makeResult(const Vector<State>& state, int startId, int endId) const
+Vector<Navmesh::NodeAndConn> Navmesh::makeResult(SearchStateArray<State>& state, int startId, int endId) const
 {
 	Vector<NodeAndConn> result;
 	for (NodeAndConn curNode(endId); true; curNode = state[curNode.node].cameFrom) {
@@ -394,13 +392,12 @@ std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, int to
 		return {};
 	}
 
-	// State map. Using vector for perf, trading space for CPU.
-	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
-	Vector<State> state(nodes.size(), State{});
-
-	// Open set
-	auto openSet = PriorityQueue<NodeId, NodeComparator>(NodeComparator(state));
-	openSet.reserve(std::min(static_cast<size_t>(100), nodes.size()));
+	// State map, reused between queries on this thread so we don't allocate or clear one per query
+	auto& context = getSearchContext();
+	auto& state = context.state;
+	auto& openSet = context.openSet;
+	state.startSearch(nodes.size());
+	openSet.clear();
 
 	// Define heuristic function
 	const Vector2f endPos = nodes[toId].pos;
@@ -460,6 +457,260 @@ std::optional<Vector<Navmesh::NodeAndConn>> Navmesh::pathfind(int fromId, int to
 	return {};
 }
 
+Navmesh::SearchContext& Navmesh::getSearchContext()
+{
+	static thread_local SearchContext context;
+	return context;
+}
+
+void Navmesh::computePortalCosts()
+{
+	const size_t n = portals.size();
+	portalCosts.resize(n * n);
+
+	Vector<std::pair<NodeId, float>> sources;
+	Vector<NodeId> portalNodes;
+	for (size_t i = 0; i < n; ++i) {
+		const auto& portal = portals[i];
+		getPortalNodes(portal, portalNodes);
+		sources.clear();
+		for (const auto node: portalNodes) {
+			sources.emplace_back(node, ((nodes[node].pos - portal.pos) * scaleFactor).length());
+		}
+		computeCostsToPortals(sources, gsl::span<float>(portalCosts).subspan(i * n, n));
+	}
+}
+
+bool Navmesh::hasPortalCosts() const
+{
+	return portalCosts.size() == portals.size() * portals.size();
+}
+
+float Navmesh::getPortalCost(size_t fromPortal, size_t toPortal) const
+{
+	Expects(hasPortalCosts());
+	return portalCosts[fromPortal * portals.size() + toPortal];
+}
+
+Vector<float> Navmesh::getPortalCostsFrom(Vector2f pos) const
+{
+	Vector<float> result(portals.size(), std::numeric_limits<float>::infinity());
+	if (const auto node = getNodeAt(pos)) {
+		const std::pair<NodeId, float> source(*node, ((nodes[*node].pos - pos) * scaleFactor).length());
+		computeCostsToPortals(gsl::span<const std::pair<NodeId, float>>(&source, 1), result);
+	}
+	return result;
+}
+
+void Navmesh::computeCostsToPortals(gsl::span<const std::pair<NodeId, float>> sources, gsl::span<float> dst) const
+{
+	// Dijkstra from all the sources, until every node touching a portal has been settled
+	Vector<NodeId> targets;
+	{
+		Vector<NodeId> portalNodes;
+		for (const auto& portal: portals) {
+			getPortalNodes(portal, portalNodes);
+			targets.insert(targets.end(), portalNodes.begin(), portalNodes.end());
+		}
+		std::sort(targets.begin(), targets.end());
+		targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+	}
+	size_t targetsLeft = targets.size();
+
+	auto& context = getSearchContext();
+	auto& state = context.state;
+	auto& openSet = context.openSet;
+	state.startSearch(nodes.size());
+	openSet.clear();
+
+	for (const auto& [nodeId, cost]: sources) {
+		auto& nodeState = state[nodeId];
+		if (cost < nodeState.gScore) {
+			nodeState.gScore = cost;
+			nodeState.fScore = cost;
+			if (!nodeState.inOpenSet) {
+				nodeState.inOpenSet = true;
+				openSet.push(nodeId);
+			} else {
+				openSet.update(nodeId);
+			}
+		}
+	}
+
+	while (!openSet.empty() && targetsLeft > 0) {
+		const auto curId = openSet.top();
+		openSet.pop();
+		state[curId].inOpenSet = false;
+		state[curId].inClosedSet = true;
+		if (std::binary_search(targets.begin(), targets.end(), curId)) {
+			--targetsLeft;
+		}
+
+		const float gScore = state[curId].gScore;
+		const auto& curNode = nodes[curId];
+		for (size_t i = 0; i < curNode.nConnections; ++i) {
+			if (curNode.connections[i]) {
+				const auto nodeId = curNode.connections[i].value();
+				auto& neighState = state[nodeId];
+				const float neighScore = gScore + curNode.costs[i];
+				if (!neighState.inClosedSet && neighScore < neighState.gScore) {
+					neighState.gScore = neighScore;
+					neighState.fScore = neighScore;
+					if (!neighState.inOpenSet) {
+						neighState.inOpenSet = true;
+						openSet.push(nodeId);
+					} else {
+						openSet.update(nodeId);
+					}
+				}
+			}
+		}
+	}
+
+	Vector<NodeId> portalNodes;
+	for (size_t i = 0; i < portals.size(); ++i) {
+		getPortalNodes(portals[i], portalNodes);
+		float best = std::numeric_limits<float>::infinity();
+		for (const auto node: portalNodes) {
+			best = std::min(best, state[node].gScore + ((portals[i].pos - nodes[node].pos) * scaleFactor).length());
+		}
+		dst[i] = best;
+	}
+}
+
+void Navmesh::computeCostsToGoal(Vector2f goal, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const
+{
+	const auto goalId = getNodeAt(goal);
+	if (!goalId) {
+		computeCostsFromSeeds({}, costs, nextHops);
+		return;
+	}
+
+	const CostSeed seed = { *goalId, NodeAndConn(), ((nodes[*goalId].pos - goal) * scaleFactor).length() };
+	computeCostsFromSeeds(gsl::span<const CostSeed>(&seed, 1), costs, nextHops);
+}
+
+Vector<float> Navmesh::getPortalCostsToGoal(gsl::span<const float> nodeCosts) const
+{
+	Expects(nodeCosts.size() == nodes.size());
+
+	Vector<float> result(portals.size(), std::numeric_limits<float>::infinity());
+	Vector<NodeId> portalNodes;
+	for (size_t i = 0; i < portals.size(); ++i) {
+		getPortalNodes(portals[i], portalNodes);
+		for (const auto node: portalNodes) {
+			result[i] = std::min(result[i], nodeCosts[node] + ((portals[i].pos - nodes[node].pos) * scaleFactor).length());
+		}
+	}
+	return result;
+}
+
+void Navmesh::computeCostsToExits(gsl::span<const float> portalCosts, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const
+{
+	Expects(portalCosts.size() == portals.size());
+
+	Vector<CostSeed> seeds;
+	Vector<NodeId> portalNodes;
+	for (size_t i = 0; i < portals.size(); ++i) {
+		if (std::isfinite(portalCosts[i])) {
+			getPortalNodes(portals[i], portalNodes);
+			for (const auto node: portalNodes) {
+				const float cost = portalCosts[i] + ((portals[i].pos - nodes[node].pos) * scaleFactor).length();
+				seeds.push_back(CostSeed{ node, NodeAndConn(std::numeric_limits<NodeId>::max(), static_cast<uint16_t>(i)), cost });
+			}
+		}
+	}
+	computeCostsFromSeeds(seeds, costs, nextHops);
+}
+
+void Navmesh::computeCostsFromSeeds(gsl::span<const CostSeed> seeds, Vector<float>& costs, Vector<NodeAndConn>& nextHops) const
+{
+	costs.clear();
+	costs.resize(nodes.size(), std::numeric_limits<float>::infinity());
+	nextHops.clear();
+	nextHops.resize(nodes.size(), NodeAndConn());
+
+	// Dijkstra outwards from the seeds. Connections are walked backwards, so the cost used is that of the neighbour moving into the current node.
+	auto& context = getSearchContext();
+	auto& state = context.state;
+	auto& openSet = context.openSet;
+	state.startSearch(nodes.size());
+	openSet.clear();
+
+	for (const auto& seed: seeds) {
+		auto& seedState = state[seed.node];
+		if (seed.cost < seedState.gScore) {
+			seedState.cameFrom = seed.nextHop;
+			seedState.gScore = seed.cost;
+			seedState.fScore = seed.cost;
+			if (!seedState.inOpenSet) {
+				seedState.inOpenSet = true;
+				openSet.push(seed.node);
+			} else {
+				openSet.update(seed.node);
+			}
+		}
+	}
+
+	while (!openSet.empty()) {
+		const auto curId = openSet.top();
+		openSet.pop();
+		state[curId].inOpenSet = false;
+		state[curId].inClosedSet = true;
+
+		const float gScore = state[curId].gScore;
+		costs[curId] = gScore;
+		nextHops[curId] = state[curId].cameFrom;
+
+		const auto& curNode = nodes[curId];
+		for (size_t i = 0; i < curNode.nConnections; ++i) {
+			if (!curNode.connections[i]) {
+				continue;
+			}
+			const auto nodeId = curNode.connections[i].value();
+			auto& neighState = state[nodeId];
+			if (neighState.inClosedSet) {
+				continue;
+			}
+
+			// Find the connection back to us
+			const auto& neighNode = nodes[nodeId];
+			for (size_t j = 0; j < neighNode.nConnections; ++j) {
+				if (neighNode.connections[j] && neighNode.connections[j].value() == curId) {
+					const float neighScore = gScore + neighNode.costs[j];
+					if (neighScore < neighState.gScore) {
+						neighState.cameFrom = NodeAndConn(curId, static_cast<uint16_t>(j));
+						neighState.gScore = neighScore;
+						neighState.fScore = neighScore;
+						if (!neighState.inOpenSet) {
+							neighState.inOpenSet = true;
+							openSet.push(nodeId);
+						} else {
+							openSet.update(nodeId);
+						}
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+void Navmesh::getPortalNodes(const Portal& portal, Vector<NodeId>& dst) const
+{
+	dst.clear();
+	for (const auto& conn: portal.connections) {
+		dst.push_back(conn.node);
+	}
+
+	// Processed portals don't keep their connections, so find the polygon they sit on
+	if (dst.empty()) {
+		if (const auto node = getNodeAt(portal.pos)) {
+			dst.push_back(*node);
+		}
+	}
+}
+
 std::optional<NavigationPath> Navmesh::makePath(const NavigationQuery& query, const Vector<NodeAndConn>& nodePath) const
 {
 	Vector<Vector2f> points;
@@ -681,6 +932,7 @@ void Navmesh::setWorldPosition(Vector2f newOffset, Vector2i gridPos)
 		edge.second.b += delta;
 	}
 	origin += delta;
+	boundingBox = boundingBox + delta;
 }
 
 void Navmesh::markPortalConnected(size_t idx)
@@ -703,12 +955,25 @@ void Navmesh::processPolygons()
 
 void Navmesh::addPolygonsToGrid()
 {
+	// Aim for roughly one polygon per cell on large navmeshes
+	const int side = clamp(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(polygons.size())))), 20, 128);
+	gridSize = Vector2i(side, side);
+
+	// Cells are parallelograms, so take the distance between the closest pair of opposite sides
+	const auto cellU = normalisedCoordinatesBase.transform(Vector2f(1.0f / gridSize.x, 0.0f));
+	const auto cellV = normalisedCoordinatesBase.transform(Vector2f(0.0f, 1.0f / gridSize.y));
+	const float cellArea = std::abs(cellU.cross(cellV));
+	minCellExtent = std::min(cellArea / std::max(cellU.length(), 0.0001f), cellArea / std::max(cellV.length(), 0.0001f));
+
 	polyGrid.resize(gridSize.x * gridSize.y);
 	for (auto& c: polyGrid) {
 		c.clear();
 	}
+	gridCoversMesh = true;
+	boundingBox = Rect4f();
 	for (size_t i = 0; i < polygons.size(); ++i) {
 		addPolygonToGrid(polygons[i], gsl::narrow<NodeId>(i));
+		boundingBox = i == 0 ? polygons[i].getAABB() : boundingBox.merge(polygons[i].getAABB());
 	}
 }
 
@@ -720,7 +985,12 @@ void Navmesh::addPolygonToGrid(const Polygon& poly, NodeId idx)
 	int maxY = 0;
 
 	for (const auto& v: poly.getVertices()) {
-		const auto p = Vector2i(normalisedCoordinatesBase.inverseTransform(v - origin) * Vector2f(gridSize)).floor();
+		const auto gridPos = normalisedCoordinatesBase.inverseTransform(v - origin) * Vector2f(gridSize);
+		const auto p = Vector2i(gridPos).floor();
+		constexpr float epsilon = 0.001f;
+		if (gridPos.x < -epsilon || gridPos.y < -epsilon || gridPos.x > gridSize.x + epsilon || gridPos.y > gridSize.y + epsilon) {
+			gridCoversMesh = false;
+		}
 		minX = std::min(minX, std::max(0, p.x));
 		maxX = std::max(maxX, std::min(gridSize.x - 1, p.x));
 		minY = std::min(minY, std::max(0, p.y));
@@ -747,6 +1017,113 @@ gsl::span<const Navmesh::NodeId> Navmesh::getPolygonsAt(Vector2f pos, bool allow
 	return polyGrid[x + y * gridSize.x];
 }
 
+Vector2i Navmesh::getGridCoordinates(Vector2f pos) const
+{
+	// Clamp before converting, as positions can be arbitrarily far away from the navmesh
+	constexpr float maxCoord = 1'000'000.0f;
+	const auto p = normalisedCoordinatesBase.inverseTransform(pos - origin) * Vector2f(gridSize);
+	return Vector2i(Vector2f(clamp(p.x, -maxCoord, maxCoord), clamp(p.y, -maxCoord, maxCoord)).floor());
+}
+
+void Navmesh::addEdgesToGrid()
+{
+	edgeGrid.resize(gridSize.x * gridSize.y);
+	for (auto& c: edgeGrid) {
+		c.clear();
+	}
+
+	for (size_t i = 0; i < openEdges.size(); ++i) {
+		const auto a = getGridCoordinates(openEdges[i].second.a);
+		const auto b = getGridCoordinates(openEdges[i].second.b);
+		const int minX = clamp(std::min(a.x, b.x), 0, gridSize.x - 1);
+		const int maxX = clamp(std::max(a.x, b.x), 0, gridSize.x - 1);
+		const int minY = clamp(std::min(a.y, b.y), 0, gridSize.y - 1);
+		const int maxY = clamp(std::max(a.y, b.y), 0, gridSize.y - 1);
+
+		for (int y = minY; y <= maxY; ++y) {
+			for (int x = minX; x <= maxX; ++x) {
+				edgeGrid[x + y * gridSize.x].push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+}
+
+std::optional<std::pair<Navmesh::NodeId, Vector2f>> Navmesh::findClosestOpenEdge(Vector2f pos, float anisotropy, float maxDistance) const
+{
+	if (openEdges.empty()) {
+		return {};
+	}
+
+	// Same metric as Polygon::getClosestPoint
+	const auto scale = Vector2f(1.0f, 1.0f / anisotropy);
+	const auto scaledPos = pos * scale;
+	const float minScale = std::min(1.0f, 1.0f / anisotropy);
+
+	float bestDist2 = maxDistance * maxDistance;
+	std::optional<std::pair<NodeId, Vector2f>> best;
+
+	auto visitEdge = [&] (const std::pair<uint16_t, LineSegment>& openEdge)
+	{
+		const auto& [node, edge] = openEdge;
+		const auto p = LineSegment(edge.a * scale, edge.b * scale).getClosestPoint(scaledPos);
+		const float dist2 = (p - scaledPos).squaredLength();
+		if (dist2 < bestDist2) {
+			bestDist2 = dist2;
+			best = { node, p / scale };
+		}
+	};
+
+	auto visitCell = [&] (int x, int y)
+	{
+		for (const auto edgeIdx: edgeGrid[x + y * gridSize.x]) {
+			visitEdge(openEdges[edgeIdx]);
+		}
+	};
+
+	if (!gridCoversMesh) {
+		// Edges outside of the grid were clamped into its border cells, so ring distances aren't a lower bound
+		for (const auto& openEdge: openEdges) {
+			visitEdge(openEdge);
+		}
+		return best;
+	}
+
+	// Search in rings of cells around pos, until the ring is further away than the best edge so far
+	// Positions off the grid start from the closest cell; that cell is no further from any other cell than pos is, so the bound still holds
+	const auto gridPos = getGridCoordinates(pos);
+	const auto c = Vector2i(clamp(gridPos.x, 0, gridSize.x - 1), clamp(gridPos.y, 0, gridSize.y - 1));
+	const int lastRing = std::max({ c.x, gridSize.x - 1 - c.x, c.y, gridSize.y - 1 - c.y });
+	for (int r = 0; r <= lastRing; ++r) {
+		if (r > 0) {
+			const float ringDist = static_cast<float>(r - 1) * minCellExtent * minScale;
+			if (ringDist * ringDist >= bestDist2) {
+				break;
+			}
+		}
+
+		const int y0 = std::max(c.y - r, 0);
+		const int y1 = std::min(c.y + r, gridSize.y - 1);
+		const int x0 = std::max(c.x - r, 0);
+		const int x1 = std::min(c.x + r, gridSize.x - 1);
+		for (int y = y0; y <= y1; ++y) {
+			if (y == c.y - r || y == c.y + r) {
+				for (int x = x0; x <= x1; ++x) {
+					visitCell(x, y);
+				}
+			} else {
+				if (c.x - r >= 0 && c.x - r < gridSize.x) {
+					visitCell(c.x - r, y);
+				}
+				if (c.x + r >= 0 && c.x + r < gridSize.x) {
+					visitCell(c.x + r, y);
+				}
+			}
+		}
+	}
+
+	return best;
+}
+
 float Navmesh::getArea() const
 {
 	return totalArea;
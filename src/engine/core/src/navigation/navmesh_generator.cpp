@@ -1,7 +1,9 @@
 #include "halley/navigation/navmesh_generator.h"
 
 #include <cassert>
+#include <numeric>
 
+#include "halley/concurrency/concurrent.h"
 #include "halley/navigation/navmesh_set.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
@@ -9,25 +11,90 @@ using namespace Halley;
 
 NavmeshSet NavmeshGenerator::generate(const Params& params)
 {
-	auto obstacles = preProcessObstacles(params.obstacles, params.agentSize);
+	CellCache cache;
+	return generate(params, cache);
+}
+
+NavmeshSet NavmeshGenerator::generate(const Params& params, CellCache& cache)
+{
+	const auto obstacles = preProcessObstacles(params.obstacles, params.agentSize);
+
+	cache.reset(params.bounds, params.agentSize);
+	Vector<size_t> cellIdxs(cache.cells.size());
+	std::iota(cellIdxs.begin(), cellIdxs.end(), size_t(0));
+	generateCells(params.bounds, obstacles, cache, cellIdxs);
 
+	return generateFromCells(params, cache);
+}
+
+NavmeshSet NavmeshGenerator::regenerate(const Params& params, CellCache& cache, gsl::span<const Polygon> changedObstacles)
+{
+	if (!cache.matches(params.bounds, params.agentSize)) {
+		return generate(params, cache);
+	}
+
+	const auto obstacles = preProcessObstacles(params.obstacles, params.agentSize);
+	const auto changed = preProcessObstacles(changedObstacles, params.agentSize);
+
+	// Same overlap test as generateByPolygonSubtraction, so any cell left alone can't have been affected
 	const auto& bounds = params.bounds;
 	const auto u = bounds.side0 / bounds.side0Divisions;
 	const auto v = bounds.side1 / bounds.side1Divisions;
-	const float maxSize = (u - v).length() * 0.6f;
-
-	Vector<NavmeshNode> polygons;
-	
+	Vector<size_t> cellIdxs;
 	for (size_t i = 0; i < bounds.side0Divisions; ++i) {
 		for (size_t j = 0; j < bounds.side1Divisions; ++j) {
-			const auto cell = makeCell(Vector2i(static_cast<int>(i), static_cast<int>(j)), bounds.origin, u, v);
-			auto cellPolygons = toNavmeshNode(generateByPolygonSubtraction(gsl::span<const Polygon>(&cell, 1), obstacles, cell.getBoundingCircle()));
-			generateConnectivity(cellPolygons);
-			postProcessPolygons(cellPolygons, maxSize, false, params.bounds);
-			insertPolygons(cellPolygons, polygons);
+			const auto cellBounds = makeCell(Vector2i(static_cast<int>(i), static_cast<int>(j)), bounds.origin, u, v).getBoundingCircle();
+			const bool touched = std::any_of(changed.begin(), changed.end(), [&] (const Polygon& o) { return o.getBoundingCircle().overlaps(cellBounds); });
+			if (touched) {
+				cellIdxs.push_back(i * bounds.side1Divisions + j);
+			}
 		}
 	}
 
+	generateCells(bounds, obstacles, cache, cellIdxs);
+
+	return generateFromCells(params, cache);
+}
+
+void NavmeshGenerator::generateCells(const NavmeshBounds& bounds, gsl::span<const Polygon> obstacles, CellCache& cache, gsl::span<const size_t> cellIdxs)
+{
+	const auto u = bounds.side0 / bounds.side0Divisions;
+	const auto v = bounds.side1 / bounds.side1Divisions;
+	const float maxSize = (u - v).length() * 0.6f;
+
+	auto generateCell = [&] (size_t cellIdx)
+	{
+		const auto coord = Vector2i(static_cast<int>(cellIdx / bounds.side1Divisions), static_cast<int>(cellIdx % bounds.side1Divisions));
+		const auto cell = makeCell(coord, bounds.origin, u, v);
+		auto cellPolygons = toNavmeshNode(generateByPolygonSubtraction(gsl::span<const Polygon>(&cell, 1), obstacles, cell.getBoundingCircle()));
+		generateConnectivity(cellPolygons);
+		postProcessPolygons(cellPolygons, maxSize, false, bounds);
+		cache.cells[cellIdx] = std::move(cellPolygons);
+	};
+
+	// Cells don't depend on each other, so they can be generated in parallel.
+	// This is safe even when already running on CPUAux, as foreachChunk has the caller take cells too and never waits on helpers that didn't start.
+	cache.numCellsGenerated = cellIdxs.size();
+	if (Executors::hasInstance()) {
+		Concurrent::foreachChunk(Executors::getCPUAux(), cellIdxs.size(), 1, [&] (size_t, size_t start, size_t, size_t)
+		{
+			generateCell(cellIdxs[start]);
+		});
+	} else {
+		for (const auto cellIdx: cellIdxs) {
+			generateCell(cellIdx);
+		}
+	}
+}
+
+NavmeshSet NavmeshGenerator::generateFromCells(const Params& params, const CellCache& cache)
+{
+	Vector<NavmeshNode> polygons;
+	for (const auto& cell: cache.cells) {
+		auto cellPolygons = cell;
+		insertPolygons(cellPolygons, polygons);
+	}
+
 	splitByPortals(polygons, params.subworldPortals);
 	splitByRegions(polygons, params.regions);
 	generateConnectivity(polygons);
@@ -40,11 +107,32 @@ NavmeshSet NavmeshGenerator::generate(const Params& params)
 
 	NavmeshSet result;
 	for (int region = 0; region < nRegions; ++region) {
-		result.add(makeNavmesh(polygons, bounds, params.subworldPortals, region, params.subWorld, params.getPolygonWeightCallback));
+		result.add(makeNavmesh(polygons, params.bounds, params.subworldPortals, region, params.subWorld, params.getPolygonWeightCallback));
 	}
 	return result;
 }
 
+bool NavmeshGenerator::CellCache::matches(const NavmeshBounds& bounds, float agentSize) const
+{
+	return !cells.empty()
+		&& origin == bounds.origin && side0 == bounds.side0 && side1 == bounds.side1
+		&& side0Divisions == bounds.side0Divisions && side1Divisions == bounds.side1Divisions
+		&& this->agentSize == agentSize;
+}
+
+void NavmeshGenerator::CellCache::reset(const NavmeshBounds& bounds, float agentSize)
+{
+	origin = bounds.origin;
+	side0 = bounds.side0;
+	side1 = bounds.side1;
+	side0Divisions = bounds.side0Divisions;
+	side1Divisions = bounds.side1Divisions;
+	this->agentSize = agentSize;
+
+	cells.clear();
+	cells.resize(side0Divisions * side1Divisions);
+}
+
 Vector<Polygon> NavmeshGenerator::generateByPolygonSubtraction(gsl::span<const Polygon> inputPolygons, gsl::span<const Polygon> obstacles, Circle bounds)
 {
 	// Start with the given input polygons
@@ -178,14 +266,42 @@ Vector<NavmeshGenerator::NavmeshNode> NavmeshGenerator::toNavmeshNode(Vector<Pol
 
 void NavmeshGenerator::generateConnectivity(gsl::span<NavmeshNode> polygons)
 {
-	for (size_t polyAIdx = 0; polyAIdx < polygons.size(); ++polyAIdx) {
-		NavmeshNode& a = polygons[polyAIdx];
+	// Only polygons with overlapping bounding boxes can share an edge, so find those pairs first by sweeping along x
+	constexpr float epsilon = 0.1f;
+	Vector<size_t> order(polygons.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::sort(order.begin(), order.end(), [&] (size_t a, size_t b) { return polygons[a].polygon.getAABB().getLeft() < polygons[b].polygon.getAABB().getLeft(); });
+
+	Vector<std::pair<size_t, size_t>> candidates;
+	for (size_t i = 0; i < order.size(); ++i) {
+		const auto& boxA = polygons[order[i]].polygon.getAABB();
+		for (size_t j = i + 1; j < order.size(); ++j) {
+			const auto& boxB = polygons[order[j]].polygon.getAABB();
+			if (boxB.getLeft() > boxA.getRight() + epsilon) {
+				break;
+			}
+			if (boxB.getTop() <= boxA.getBottom() + epsilon && boxA.getTop() <= boxB.getBottom() + epsilon) {
+				candidates.emplace_back(std::min(order[i], order[j]), std::max(order[i], order[j]));
+			}
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
 
+	// Visit the pairs in the same order as testing every polygon against every later one would
+	for (size_t start = 0; start < candidates.size();) {
+		const size_t polyAIdx = candidates[start].first;
+		size_t end = start;
+		while (end < candidates.size() && candidates[end].first == polyAIdx) {
+			++end;
+		}
+
+		NavmeshNode& a = polygons[polyAIdx];
 		for (size_t edgeAIdx = 0; edgeAIdx < a.connections.size(); ++edgeAIdx) {
 			if (a.connections[edgeAIdx] < 0) {
 				const auto edgeA = a.polygon.getEdge(edgeAIdx);
-				
-				for (size_t polyBIdx = polyAIdx + 1; polyBIdx < polygons.size(); ++polyBIdx) {
+
+				for (size_t k = start; k < end; ++k) {
+					const size_t polyBIdx = candidates[k].second;
 					NavmeshNode& b = polygons[polyBIdx];
 
 					const auto edgeBIdx = b.polygon.findEdge(edgeA, 0.01f);
@@ -199,6 +315,8 @@ void NavmeshGenerator::generateConnectivity(gsl::span<NavmeshNode> polygons)
 				}
 			}
 		}
+
+		start = end;
 	}
 }
 
@@ -190,6 +190,13 @@ std::optional<WorldPosition> NavmeshSet::getClosestPointTo(WorldPosition pos, fl
 
 	for (const auto& navmesh: navmeshes) {
 		if (navmesh.getSubWorld() == pos.subWorld) {
+			// Skip navmeshes which can't possibly be closer than the best one so far
+			const auto& box = navmesh.getBoundingBox();
+			const auto closestInBox = Vector2f(clamp(pos.pos.x, box.getLeft(), box.getRight()), clamp(pos.pos.y, box.getTop(), box.getBottom()));
+			if ((closestInBox - pos.pos).length() >= bestDist) {
+				continue;
+			}
+
 			const auto curPoint = navmesh.getClosestPointTo(pos.pos, anisotropy);
 			if (curPoint) {
 				const float dist = (*curPoint - pos.pos).length();
@@ -234,9 +241,23 @@ void NavmeshSet::linkNavmeshes()
 	regionNodes.resize(navmeshes.size());
 	portalNodes.clear();
 
+	// Paths also cross unweighted stretches (e.g. into portals), so weights above 1 can't be relied on
+	Vector2f minScale(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
+	float minWeight = 1.0f;
 	for (auto& navmesh: navmeshes) {
 		navmesh.markPortalsDisconnected();
+		if (!navmesh.hasPortalCosts()) {
+			// Only navmeshes added since the last link need this, the others keep their costs
+			navmesh.computePortalCosts();
+		}
+
+		const auto scale = navmesh.getScaleFactor().abs();
+		minScale = Vector2f(std::min(minScale.x, scale.x), std::min(minScale.y, scale.y));
+		for (const auto weight: navmesh.getWeights()) {
+			minWeight = std::min(minWeight, weight);
+		}
 	}
+	heuristicScale = navmeshes.empty() ? Vector2f(1, 1) : minScale * std::max(minWeight, 0.0f);
 
 	// Link meshes
 	const uint16_t nMeshes = static_cast<uint16_t>(navmeshes.size());
@@ -250,16 +271,20 @@ void NavmeshSet::linkNavmeshes()
 	for (size_t curPortalId = 0; curPortalId < portalNodes.size(); ++curPortalId) {
 		auto& portalNode = portalNodes[curPortalId];
 		
-		// Insert all edges that can be reached by these two regions as neighbours of this edge
+		// Insert all edges that can be reached from here through the destination region as neighbours of this edge, with the actual cost of crossing it
 		const auto& dstRegion = regionNodes[portalNode.toRegion];
-		const auto curPos = portalNode.pos;
+		const auto& dstNavmesh = navmeshes[portalNode.toRegion];
+		const auto reversePortalId = curPortalId ^ 1; // Portal nodes are created in pairs
 		
 		portalNode.connections.reserve(dstRegion.portals.size() - 1);
 		for (size_t i = 0; i < dstRegion.portals.size(); ++i) {
-			if (curPortalId != portalNode.toPortal) {
-				const auto dstPortalId = dstRegion.portals[i];
+			const auto dstPortalId = dstRegion.portals[i];
+			if (dstPortalId != reversePortalId) {
 				const auto& other = portalNodes[dstPortalId];
-				portalNode.connections.emplace_back(dstPortalId, portalNode.toRegion, (other.pos - curPos).length());
+				const float cost = dstNavmesh.getPortalCost(portalNode.toPortal, other.fromPortal);
+				if (std::isfinite(cost)) {
+					portalNode.connections.emplace_back(dstPortalId, portalNode.toRegion, cost);
+				}
 			}
 		}
 	}
@@ -358,55 +383,49 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 		return {};
 	}
 
-	// State map. Using vector for perf, trading space for CPU.
-	// TODO: measure this vs unordered_map or some other hashtable, it's not impossible that it'd perform better (compact memory)
-	Vector<State> state(portalNodes.size(), State{});
-
-	// Open set
-	auto openSet = PriorityQueue<NodeId, NodeComparator>(NodeComparator(state));
-	openSet.reserve(std::min(static_cast<size_t>(100), portalNodes.size()));
+	// State map, reused between queries on this thread so we don't allocate or clear one per query
+	static thread_local SearchContext context;
+	auto& state = context.state;
+	auto& openSet = context.openSet;
+	state.startSearch(portalNodes.size());
+	openSet.clear();
 
-	// Define heuristic function
+	// Define heuristic function, scaled like the costs so it stays a lower bound and the early exit below remains optimal
 	auto h = [&] (Vector2f pos) -> float
 	{
-		return (pos - endPos).length();
+		return ((pos - endPos) * heuristicScale).length();
 	};
 
+	// Costs to get from the start position into each of its region's portals, and out of the end region's portals to the end position
+	const auto startCosts = navmeshes[fromRegionId].getPortalCostsFrom(startPos);
+	const auto endCosts = navmeshes[toRegionId].getPortalCostsFrom(endPos);
+
 	// Initialize the query
 	{
 		const auto& startRegion = regionNodes[fromRegionId];
 		for (const auto portalId : startRegion.portals) {
+			const float cost = startCosts[portalNodes[portalId].fromPortal];
+			if (!std::isfinite(cost)) {
+				continue;
+			}
 			auto& nodeState = state[portalId];
 			const auto pos = portalNodes[portalId].pos;
 			nodeState.cameFrom = std::numeric_limits<uint16_t>::max();
-			nodeState.gScore = (pos - startPos).length();
-			nodeState.fScore = h(pos);
+			nodeState.gScore = cost;
+			nodeState.fScore = cost + h(pos);
 			nodeState.inOpenSet = true;
 			openSet.push(portalId);
 		}
 	}
 
 	// Run A*
+	// Reaching the end region doesn't finish the search, as the total cost still depends on which portal we enter it through
+	float bestCost = std::numeric_limits<float>::infinity();
+	std::optional<NodeId> bestEnd;
 	while (!openSet.empty()) {
 		const auto curId = openSet.top();
-		const auto& curNode = portalNodes[curId];
-		if (curNode.toRegion == toRegionId) {
-			// A* is done! Generate result and return it
-			Vector<NodeAndConn> result;
-			uint16_t portal = std::numeric_limits<uint16_t>::max();
-			for (uint16_t i = curId; true;) {
-				const auto& nodeData = portalNodes[i];
-				result.push_back(NodeAndConn(nodeData.toRegion, portal));
-				portal = nodeData.fromPortal;
-				
-				i = state[i].cameFrom;
-				if (i == std::numeric_limits<uint16_t>::max()) {
-					result.push_back(NodeAndConn(fromRegionId, portal));
-					break;
-				}
-			}
-			std::reverse(result.begin(), result.end());
-			return result;
+		if (state[curId].fScore >= bestCost) {
+			break;
 		}
 
 		// Process current node
@@ -414,8 +433,17 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 		state[curId].inClosedSet = true;
 		openSet.pop();
 
-		// Process neighbours
+		const auto& curNode = portalNodes[curId];
 		const float gScore = state[curId].gScore;
+		if (curNode.toRegion == toRegionId) {
+			const float totalCost = gScore + endCosts[curNode.toPortal];
+			if (totalCost < bestCost) {
+				bestCost = totalCost;
+				bestEnd = curId;
+			}
+		}
+
+		// Process neighbours
 		for (size_t i = 0; i < curNode.connections.size(); ++i) {
 			const auto nodeId = curNode.connections[i].portalId;
 			if (!state[nodeId].inClosedSet) {
@@ -437,8 +465,95 @@ Vector<NavmeshSet::NodeAndConn> NavmeshSet::findRegionPath(Vector2f startPos, Ve
 			}
 		}
 	}
-	
-	return {};
+
+	if (!bestEnd) {
+		return {};
+	}
+
+	// Generate result
+	Vector<NodeAndConn> result;
+	uint16_t portal = std::numeric_limits<uint16_t>::max();
+	for (uint16_t i = *bestEnd; true;) {
+		const auto& nodeData = portalNodes[i];
+		result.push_back(NodeAndConn(nodeData.toRegion, portal));
+		portal = nodeData.fromPortal;
+		
+		i = state[i].cameFrom;
+		if (i == std::numeric_limits<uint16_t>::max()) {
+			result.push_back(NodeAndConn(fromRegionId, portal));
+			break;
+		}
+	}
+	std::reverse(result.begin(), result.end());
+	return result;
+}
+
+Vector<Vector<float>> NavmeshSet::getPortalCostsToGoal(uint16_t goalRegion, gsl::span<const float> goalPortalCosts) const
+{
+	Vector<Vector<float>> result(navmeshes.size());
+	for (size_t i = 0; i < navmeshes.size(); ++i) {
+		result[i].resize(navmeshes[i].getPortals().size(), std::numeric_limits<float>::infinity());
+	}
+	if (goalRegion >= regionNodes.size()) {
+		return result;
+	}
+
+	// Dijkstra backwards over the portal graph, where a portal node's cost is that of reaching the goal once it's been crossed
+	Vector<Vector<std::pair<NodeId, float>>> incoming(portalNodes.size());
+	for (size_t i = 0; i < portalNodes.size(); ++i) {
+		for (const auto& conn: portalNodes[i].connections) {
+			incoming[conn.portalId].emplace_back(static_cast<NodeId>(i), conn.cost);
+		}
+	}
+
+	static thread_local SearchContext context;
+	auto& state = context.state;
+	auto& openSet = context.openSet;
+	state.startSearch(portalNodes.size());
+	openSet.clear();
+
+	for (const auto portalId: regionNodes[goalRegion].portals) {
+		const auto entryId = static_cast<NodeId>(portalId ^ 1); // Portal nodes are created in pairs, this is the one going into the goal region
+		const float cost = goalPortalCosts[portalNodes[entryId].toPortal];
+		auto& nodeState = state[entryId];
+		if (std::isfinite(cost) && cost < nodeState.gScore) {
+			nodeState.gScore = cost;
+			nodeState.fScore = cost;
+			if (!nodeState.inOpenSet) {
+				nodeState.inOpenSet = true;
+				openSet.push(entryId);
+			} else {
+				openSet.update(entryId);
+			}
+		}
+	}
+
+	while (!openSet.empty()) {
+		const auto curId = openSet.top();
+		openSet.pop();
+		state[curId].inOpenSet = false;
+		state[curId].inClosedSet = true;
+
+		const float gScore = state[curId].gScore;
+		result[portalNodes[curId].fromRegion][portalNodes[curId].fromPortal] = gScore;
+
+		for (const auto& [prevId, cost]: incoming[curId]) {
+			auto& prevState = state[prevId];
+			const float prevScore = gScore + cost;
+			if (!prevState.inClosedSet && prevScore < prevState.gScore) {
+				prevState.gScore = prevScore;
+				prevState.fScore = prevScore;
+				if (!prevState.inOpenSet) {
+					prevState.inOpenSet = true;
+					openSet.push(prevId);
+				} else {
+					openSet.update(prevId);
+				}
+			}
+		}
+	}
+
+	return result;
 }
 
 std::pair<uint16_t, uint16_t> NavmeshSet::getPortalDestination(uint16_t region, uint16_t edge) const
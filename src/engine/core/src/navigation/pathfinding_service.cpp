@@ -0,0 +1,168 @@
+#include "halley/navigation/pathfinding_service.h"
+
+#include <atomic>
+#include "halley/concurrency/concurrent.h"
+#include "halley/navigation/navmesh_set.h"
+using namespace Halley;
+
+struct PathfindingService::Batch {
+	Vector<Request> requests;
+	Vector<RequestId> ids; // Empty for batches submitted through pathfind()
+	Vector<Result> results;
+	std::atomic<size_t> remainingTasks = 0;
+	std::optional<Promise<Vector<Result>>> promise;
+};
+
+PathfindingService::Request::Request(NavigationQuery query, float anisotropy, float nudge)
+	: query(std::move(query))
+	, anisotropy(anisotropy)
+	, nudge(nudge)
+{
+}
+
+PathfindingService::PathfindingService(std::shared_ptr<const NavmeshSet> navmeshSet, size_t requestsPerTask)
+	: navmeshSet(std::move(navmeshSet))
+	, requestsPerTask(std::max(requestsPerTask, size_t(1)))
+{
+	Expects(this->navmeshSet != nullptr);
+}
+
+PathfindingService::~PathfindingService()
+{
+	wait();
+}
+
+PathfindingService::RequestId PathfindingService::request(Request request)
+{
+	const auto id = nextId++;
+	queued.push_back(std::move(request));
+	queuedIds.push_back(id);
+	return id;
+}
+
+void PathfindingService::flush()
+{
+	if (queued.empty()) {
+		return;
+	}
+
+	auto batch = std::make_shared<Batch>();
+	batch->requests = std::move(queued);
+	batch->ids = std::move(queuedIds);
+	queued.clear();
+	queuedIds.clear();
+
+	dispatch(std::move(batch));
+}
+
+size_t PathfindingService::collectResults(Vector<Result>& dst)
+{
+	std::unique_lock<std::mutex> lock(completedMutex);
+	const size_t n = completed.size();
+	for (auto& result: completed) {
+		dst.push_back(std::move(result));
+	}
+	completed.clear();
+	return n;
+}
+
+Future<Vector<PathfindingService::Result>> PathfindingService::pathfind(Vector<Request> requests)
+{
+	if (requests.empty()) {
+		return Future<Vector<Result>>::makeImmediate({});
+	}
+
+	auto batch = std::make_shared<Batch>();
+	batch->requests = std::move(requests);
+	batch->promise = Promise<Vector<Result>>();
+	auto future = batch->promise->getFuture();
+
+	dispatch(std::move(batch));
+	return future;
+}
+
+void PathfindingService::wait()
+{
+	for (auto& task: tasks) {
+		task.wait();
+	}
+	tasks.clear();
+}
+
+size_t PathfindingService::getNumQueued() const
+{
+	return queued.size();
+}
+
+size_t PathfindingService::getNumInFlight() const
+{
+	std::unique_lock<std::mutex> lock(completedMutex);
+	return nInFlight;
+}
+
+void PathfindingService::dispatch(std::shared_ptr<Batch> batch)
+{
+	pruneTasks();
+
+	const size_t n = batch->requests.size();
+	const size_t nTasks = (n + requestsPerTask - 1) / requestsPerTask;
+	batch->results.resize(n);
+	batch->remainingTasks = nTasks;
+	{
+		std::unique_lock<std::mutex> lock(completedMutex);
+		nInFlight += n;
+	}
+
+	auto runTask = [this, batch] (size_t start, size_t end)
+	{
+		runBatchRange(*batch, start, end);
+
+		if (batch->promise) {
+			{
+				std::unique_lock<std::mutex> lock(completedMutex);
+				nInFlight -= end - start;
+			}
+			if (--batch->remainingTasks == 0) {
+				batch->promise->setValue(std::move(batch->results));
+			}
+		} else {
+			std::unique_lock<std::mutex> lock(completedMutex);
+			for (size_t i = start; i < end; ++i) {
+				completed.push_back(std::move(batch->results[i]));
+			}
+			nInFlight -= end - start;
+		}
+	};
+
+	// Without executors (e.g. in tools), just run everything on the calling thread
+	const bool async = Executors::hasInstance();
+	for (size_t i = 0; i < nTasks; ++i) {
+		const size_t start = i * requestsPerTask;
+		const size_t end = std::min(start + requestsPerTask, n);
+		if (async) {
+			tasks.push_back(Concurrent::execute(Executors::getCPUAux(), [runTask, start, end] () { runTask(start, end); }));
+		} else {
+			runTask(start, end);
+		}
+	}
+}
+
+void PathfindingService::runBatchRange(Batch& batch, size_t start, size_t end) const
+{
+	for (size_t i = start; i < end; ++i) {
+		const auto& request = batch.requests[i];
+		auto& result = batch.results[i];
+		result.id = batch.ids.empty() ? static_cast<RequestId>(i) : batch.ids[i];
+		try {
+			result.path = navmeshSet->pathfind(request.query, &result.error, request.anisotropy, request.nudge);
+		} catch (const std::exception& e) {
+			result.path = {};
+			result.error = e.what();
+		}
+	}
+}
+
+void PathfindingService::pruneTasks()
+{
+	tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [] (const Future<void>& task) { return task.isReady(); }), tasks.end());
+}
@@ -2,6 +2,7 @@
 #include "halley/net/entity/entity_network_session.h"
 #include "halley/entity/entity_factory.h"
 #include "halley/entity/world.h"
+#include "halley/data_structures/frame_arena.h"
 #include "halley/support/logger.h"
 #include "halley/utils/algorithm.h"
 #include "halley/entity/data_interpolator.h"
@@ -34,8 +35,8 @@ void EntityNetworkRemotePeer::sendEntities(Time t, gsl::span<const EntityNetwork
 		e.second.alive = false;
 	}
 
-	Vector<EntityRef> toCreate;
-	Vector<std::pair<EntityRef, OutboundEntity*>> toUpdate;
+	FrameVector<EntityRef> toCreate;
+	FrameVector<std::pair<EntityRef, OutboundEntity*>> toUpdate;
 
 	for (auto entry: entityIds) {
 		if (entry.ownerId == peerId) {
@@ -137,11 +138,16 @@ void EntityNetworkRemotePeer::sendCreateEntity(EntityRef entity)
 {
 	OutboundEntity result;
 
+	auto& snapshot = parent->getEntitySnapshot(entity);
 	result.networkId = assignId();
-	result.data = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
+	result.revision = snapshot.revision;
+	result.data = snapshot.data;
 
-	auto deltaData = parent->getFactory().entityDataToPrefabDelta(result.data, entity.getPrefab(), parent->getEntityDeltaOptions());
-	auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
+	if (!snapshot.createBytes) {
+		auto deltaData = parent->getFactory().entityDataToPrefabDelta(*snapshot.data, entity.getPrefab(), parent->getEntityDeltaOptions());
+		snapshot.createBytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
+	}
+	auto bytes = *snapshot.createBytes;
 	//Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + EntityData(deltaData).toYAML() + "\n");
 	Logger::logDev("Send Create: " + entity.getName() + " (" + entity.getInstanceUUID() + ") to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B)");
 
@@ -157,22 +163,34 @@ void EntityNetworkRemotePeer::sendUpdateEntity(Time t, OutboundEntity& remote, E
 		return;
 	}
 
-	// Encode delta using interpolators
-	auto newData = parent->getFactory().serializeEntity(entity, parent->getEntitySerializationOptions());
-	auto retriever = DataInterpolatorSetRetriever(entity, true);
-	auto options = parent->getEntityDeltaOptions();
-	options.interpolatorSet = &retriever;
-	auto deltaData = EntityDataDelta(remote.data, newData, options);
+	auto& snapshot = parent->getEntitySnapshot(entity);
+	if (remote.revision == snapshot.revision) {
+		return;
+	}
+
+	// Encode delta using interpolators, unless another peer with the same baseline already did
+	auto iter = snapshot.updateBytes.find(remote.revision);
+	if (iter == snapshot.updateBytes.end()) {
+		auto retriever = DataInterpolatorSetRetriever(entity, true);
+		auto options = parent->getEntityDeltaOptions();
+		options.interpolatorSet = &retriever;
+		auto deltaData = EntityDataDelta(*remote.data, *snapshot.data, options);
+
+		std::optional<Bytes> bytes;
+		if (deltaData.hasChange()) {
+			bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
+		}
+		iter = snapshot.updateBytes.emplace(remote.revision, std::move(bytes)).first;
+	}
 	
-	if (deltaData.hasChange()) {
-		remote.data = std::move(newData);
+	if (iter->second) {
+		remote.data = snapshot.data;
+		remote.revision = snapshot.revision;
 		remote.timeSinceSend = 0;
 
-		auto bytes = Serializer::toBytes(deltaData, parent->getByteSerializationOptions());
-		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B):\n" + deltaData.toYAML() + "\n");
-		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(bytes.size()) + " B)");
+		//Logger::logDev("Send Update " + entity.getName() + " to peer " + toString(static_cast<int>(peerId)) + " (" + toString(iter->second->size()) + " B)");
 		
-		send(EntityNetworkMessageUpdate(remote.networkId, std::move(bytes)));
+		send(EntityNetworkMessageUpdate(remote.networkId, Bytes(*iter->second)));
 	}
 }
 
@@ -69,7 +69,8 @@ void EntityNetworkSession::sendUpdates(Time t, Rect4i viewRect, gsl::span<const
 		}
 	}
 
-	// Update entities
+	// Update entities, sharing one snapshot per entity across all peers for this tick
+	snapshots.clear();
 	for (auto& peer: peers) {
 		peer.sendEntities(t, entityIds, session->getClientSharedData<EntityClientSharedData>(peer.getPeerId()));
 	}
@@ -334,6 +335,16 @@ Time EntityNetworkSession::getMinSendInterval() const
 	return 0.05;
 }
 
+EntityNetworkSession::EntitySnapshot& EntityNetworkSession::getEntitySnapshot(EntityRef entity)
+{
+	auto& snapshot = snapshots[entity.getEntityId()];
+	if (!snapshot.data) {
+		snapshot.revision = nextSnapshotRevision++;
+		snapshot.data = std::make_shared<EntityData>(factory->serializeEntity(entity, entitySerializationOptions));
+	}
+	return snapshot;
+}
+
 void EntityNetworkSession::onRemoteEntityCreated(EntityRef entity, NetworkSession::PeerId peerId)
 {
 	if (listener) {
@@ -27,6 +27,7 @@
 #include "os_linux.h"
 #include "os_freebsd.h"
 #include "halley/support/exception.h"
+#include "halley/resources/resource_data.h"
 #include <fstream>
 
 using namespace Halley;
@@ -127,6 +128,11 @@ Vector<Path> OS::enumerateDirectory(const Path& path)
 	return {};
 }
 
+std::unique_ptr<ResourceDataReader> OS::mapFileToMemory(const Path& path)
+{
+	return {};
+}
+
 void OS::setConsoleColor(int, int)
 {
 }
@@ -35,7 +35,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/poll.h>
+#include <sys/mman.h>
 #include "halley/utils/halley_iostream.h"
+#include "halley/resources/resource_data.h"
 
 using namespace Halley;
 
@@ -296,4 +298,31 @@ Vector<Path> Halley::OSUnix::enumerateDirectory(const Path& path)
 	return result;
 }
 
+std::unique_ptr<ResourceDataReader> Halley::OSUnix::mapFileToMemory(const Path& path)
+{
+	const int fd = open(path.getNativeString().c_str(), O_RDONLY);
+	if (fd < 0) {
+		return {};
+	}
+
+	struct stat s = {};
+	if (fstat(fd, &s) != 0 || s.st_size <= 0) {
+		::close(fd);
+		return {};
+	}
+
+	const auto size = static_cast<size_t>(s.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // The mapping keeps its own reference to the file
+	if (data == MAP_FAILED) {
+		return {};
+	}
+
+	const auto span = gsl::span<const gsl::byte>(static_cast<const gsl::byte*>(data), size);
+	return std::make_unique<ResourceDataReaderMemoryMapped>(span, [=] ()
+	{
+		munmap(data, size);
+	});
+}
+
 #endif
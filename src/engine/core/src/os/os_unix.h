@@ -38,6 +38,7 @@ namespace Halley {
 		String getCurrentWorkingDir() override;
 		void createDirectories(const Path& path) override;
 		Vector<Path> enumerateDirectory(const Path& path) override;
+		std::unique_ptr<ResourceDataReader> mapFileToMemory(const Path& path) override;
 
 		int runCommand(String command, String cwd, ILoggerSink* sink) override;
 		Future<int> runCommandAsync(const String& string, const String& cwd, ILoggerSink* sink) override;
@@ -24,6 +24,7 @@
 #include "halley/support/logger.h"
 #if defined(_WIN32) && !defined(WINDOWS_STORE)
 #include "halley/support/exception.h"
+#include "halley/resources/resource_data.h"
 
 #pragma warning(disable: 6387)
 #include "os_win32.h"
@@ -446,6 +447,39 @@ Vector<Path> OSWin32::enumerateDirectory(const Path& rootPath)
 	return result;
 }
 
+std::unique_ptr<ResourceDataReader> OSWin32::mapFileToMemory(const Path& path)
+{
+	const auto file = CreateFileW(path.getNativeString().getUTF16().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return {};
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || static_cast<uint64_t>(fileSize.QuadPart) > std::numeric_limits<size_t>::max()) {
+		CloseHandle(file);
+		return {};
+	}
+
+	const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file); // The mapping keeps its own reference to the file
+	if (!mapping) {
+		return {};
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data) {
+		return {};
+	}
+
+	const auto size = static_cast<size_t>(fileSize.QuadPart);
+	const auto span = gsl::span<const gsl::byte>(static_cast<const gsl::byte*>(data), size);
+	return std::make_unique<ResourceDataReaderMemoryMapped>(span, [=] ()
+	{
+		UnmapViewOfFile(data);
+	});
+}
+
 void OSWin32::displayError(const std::string& cs)
 {
 	std::string error = cs;
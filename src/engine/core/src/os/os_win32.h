@@ -46,6 +46,7 @@ namespace Halley {
 		void createDirectories(const Path& path) override;
 		bool atomicWriteFile(const Path& path, gsl::span<const gsl::byte> data, std::optional<Path> backupOldVersionPath) override;
 		Vector<Path> enumerateDirectory(const Path& path) override;
+		std::unique_ptr<ResourceDataReader> mapFileToMemory(const Path& path) override;
 
 		void displayError(const std::string& cs) override;
 		void onWindowCreated(void* window) override;
@@ -3,6 +3,7 @@
 #include "halley/support/exception.h"
 #include "halley/resources/resource.h"
 #include <set>
+#include <algorithm>
 
 using namespace Halley;
 
@@ -79,6 +80,21 @@ AssetType AssetDatabase::TypedDB::getType() const
 	return type;
 }
 
+void AssetDatabase::TypedDB::getEntriesSorted(Vector<Entry*>& dst)
+{
+	Vector<std::pair<std::string_view, Entry*>> sorted;
+	sorted.reserve(assets.size());
+	for (auto& [name, entry]: assets) {
+		sorted.emplace_back(std::string_view(name.cppStr()), &entry);
+	}
+	std::sort(sorted.begin(), sorted.end(), [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+	dst.reserve(dst.size() + sorted.size());
+	for (auto& e: sorted) {
+		dst.push_back(e.second);
+	}
+}
+
 void AssetDatabase::addAsset(const String& name, AssetType type, Entry&& entry)
 {
 	const auto iter = dbs.find(static_cast<int>(type));
@@ -130,6 +146,21 @@ Vector<String> AssetDatabase::getAssets() const
 	return result;
 }
 
+Vector<AssetDatabase::Entry*> AssetDatabase::getEntriesSorted()
+{
+	Vector<Entry*> result;
+	for (auto& db: dbs) {
+		db.second.getEntriesSorted(result);
+	}
+	return result;
+}
+
+Vector<const AssetDatabase::Entry*> AssetDatabase::getEntriesSorted() const
+{
+	auto entries = const_cast<AssetDatabase*>(this)->getEntriesSorted();
+	return Vector<const Entry*>(entries.begin(), entries.end());
+}
+
 void AssetDatabase::serialize(Serializer& s) const
 {
 	s << dbs;
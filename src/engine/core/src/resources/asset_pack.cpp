@@ -8,14 +8,36 @@
 
 using namespace Halley;
 
-void AssetPackHeader::init(size_t assetDbSize)
+static_assert(offsetof(AssetPackHeader, entryTableStartPos) == AssetPackHeader::headerSizeV1);
+
+void AssetPackHeader::init(size_t assetDbSize, size_t entryCount)
 {
-	memcpy(identifier.data(), "HALLEYPK", 8);
+	memcpy(identifier.data(), "HALLEYP2", 8);
 	assetDbStartPos = sizeof(AssetPackHeader);
-	dataStartPos = assetDbStartPos + assetDbSize;
+	entryTableStartPos = assetDbStartPos + assetDbSize;
+	entryTableCount = entryCount;
+	dataStartPos = entryTableStartPos + entryCount * sizeof(AssetPackEntryLocation);
+	memset(iv.data(), 0, iv.size());
+}
+
+void AssetPackHeader::initWithTrailingIndex(uint64_t dataStart, uint64_t dataSize, size_t assetDbSize, size_t entryCount)
+{
+	memcpy(identifier.data(), "HALLEYP2", 8);
+	dataStartPos = dataStart;
+	assetDbStartPos = dataStart + dataSize;
+	entryTableStartPos = assetDbStartPos + assetDbSize;
+	entryTableCount = entryCount;
 	memset(iv.data(), 0, iv.size());
 }
 
+static void writeEntryTable(const Vector<AssetDatabase::Entry*>& entries, Byte* dst)
+{
+	for (size_t i = 0; i < entries.size(); ++i) {
+		const auto location = AssetPackEntryLocation{ entries[i]->packPos, entries[i]->packSize };
+		memcpy(dst + i * sizeof(AssetPackEntryLocation), &location, sizeof(AssetPackEntryLocation));
+	}
+}
+
 AssetPack::AssetPack()
 	: assetDb(std::make_unique<AssetDatabase>())
 	, hasReader(false)
@@ -38,11 +60,18 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 		throw Exception("Asset pack is invalid (too small)", HalleyExceptions::Resources);
 	}
 	AssetPackHeader header;
-	int nRead = reader->read(gsl::as_writable_bytes(gsl::span<AssetPackHeader>(&header, 1)));
-	if (nRead != int(sizeof(header))) {
+	const auto headerBytes = gsl::as_writable_bytes(gsl::span<AssetPackHeader>(&header, 1));
+	int nRead = reader->read(headerBytes.subspan(0, AssetPackHeader::headerSizeV1));
+	if (nRead != int(AssetPackHeader::headerSizeV1)) {
 		throw Exception("Unable to read header", HalleyExceptions::Resources);
 	}
-	if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0) {
+	const bool hasEntryTable = memcmp(header.identifier.data(), "HALLEYP2", 8) == 0;
+	if (hasEntryTable) {
+		const auto rest = headerBytes.subspan(AssetPackHeader::headerSizeV1);
+		if (reader->read(rest) != int(rest.size())) {
+			throw Exception("Unable to read header", HalleyExceptions::Resources);
+		}
+	} else if (memcmp(header.identifier.data(), "HALLEYPK", 8) != 0) {
 		throw Exception("Asset pack is invalid (invalid identifier)", HalleyExceptions::Resources);
 	}
 	iv = header.iv;
@@ -50,8 +79,10 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 
 	// Read asset database
 	{
-		const size_t assetDbSize = size_t(header.dataStartPos - header.assetDbStartPos);
+		const auto assetDbEnd = hasEntryTable ? header.entryTableStartPos : header.dataStartPos;
+		const size_t assetDbSize = size_t(assetDbEnd - header.assetDbStartPos);
 		auto assetDbBytes = Bytes(assetDbSize);
+		reader->seek(int64_t(header.assetDbStartPos), SEEK_SET);
 		nRead = reader->read(gsl::as_writable_bytes(gsl::span<Byte>(assetDbBytes)));
 		if (nRead != int(assetDbBytes.size())) {
 			throw Exception("Unable to read header", HalleyExceptions::Resources);
@@ -60,11 +91,23 @@ AssetPack::AssetPack(std::unique_ptr<ResourceDataReader> _reader, const String&
 		Deserializer::fromBytes<AssetDatabase>(*assetDb, Compression::decompress(assetDbBytes));
 	}
 
+	readEntryLocations(header, hasEntryTable);
+
 	std::array<char, 16> ivEmpty;
 	memset(ivEmpty.data(), 0, ivEmpty.size());
 	const bool hasCrypt = memcmp(iv.data(), ivEmpty.data(), iv.size()) != 0 && !encryptionKey.isEmpty();
 
-	if (preLoad || hasCrypt) {
+	const auto mapped = reader->getMappedData();
+	if (!mapped.empty() && !hasCrypt) {
+		// Serve assets straight from the mapping. Views handed out share ownership of it, so they outlive the pack if needed.
+		if (size_t(mapped.size()) < dataOffset) {
+			throw Exception("Asset pack is invalid (too small)", HalleyExceptions::Resources);
+		}
+		std::shared_ptr<ResourceDataReader> mapping = std::move(reader);
+		mappedData = std::shared_ptr<const char>(mapping, reinterpret_cast<const char*>(mapped.data()) + dataOffset);
+		mappedSize = size_t(mapped.size()) - dataOffset;
+		hasReader = false;
+	} else if (preLoad || hasCrypt) {
 		readToMemory();
 	}
 
@@ -88,6 +131,9 @@ AssetPack& AssetPack::operator=(AssetPack&& other) noexcept
 	dataOffset = other.dataOffset;
 	reader = std::move(other.reader);
 	data = std::move(other.data);
+	mappedData = std::move(other.mappedData);
+	mappedSize = other.mappedSize;
+	iv = other.iv;
 	hasReader = !!reader;
 
 	other.hasReader = false;
@@ -119,17 +165,32 @@ const Bytes& AssetPack::getData() const
 Bytes AssetPack::writeOut() const
 {
 	auto assetDbBytes = Compression::compress(Serializer::toBytes(*assetDb));
+	const auto entries = assetDb->getEntriesSorted();
 	AssetPackHeader header;
-	header.init(assetDbBytes.size());
+	header.init(assetDbBytes.size(), entries.size());
 	header.iv = iv;
 
 	auto result = Bytes(size_t(header.dataStartPos + data.size()));
 	memcpy(result.data(), &header, sizeof(AssetPackHeader));
 	memcpy(result.data() + header.assetDbStartPos, assetDbBytes.data(), assetDbBytes.size());
+	writeEntryTable(entries, result.data() + header.entryTableStartPos);
 	memcpy(result.data() + header.dataStartPos, data.data(), data.size());
 	return result;
 }
 
+Bytes AssetPack::writeOutIndex(AssetPackHeader& header, uint64_t dataStartPos, uint64_t dataSize) const
+{
+	auto assetDbBytes = Compression::compress(Serializer::toBytes(*assetDb));
+	const auto entries = assetDb->getEntriesSorted();
+	header.initWithTrailingIndex(dataStartPos, dataSize, assetDbBytes.size(), entries.size());
+	header.iv = iv;
+
+	auto result = Bytes(assetDbBytes.size() + entries.size() * sizeof(AssetPackEntryLocation));
+	memcpy(result.data(), assetDbBytes.data(), assetDbBytes.size());
+	writeEntryTable(entries, result.data() + assetDbBytes.size());
+	return result;
+}
+
 std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType type, bool stream)
 {
 	auto path = asset;
@@ -137,16 +198,21 @@ std::unique_ptr<ResourceData> AssetPack::getData(const String& asset, AssetType
 	if (!assetInfo) {
 		return {};
 	}
-	auto ps = assetInfo->path.split(':');
-	size_t pos = size_t(ps.at(0).toInteger());
-	size_t size = size_t(ps.at(1).toInteger());
+	const size_t pos = size_t(assetInfo->packPos);
+	const size_t size = size_t(assetInfo->packSize);
 
 	if (stream) {
 		return std::make_unique<ResourceDataStream>(path, [=] () -> std::unique_ptr<ResourceDataReader> {
 			return std::make_unique<PackDataReader>(*this, pos, size);
 		});
 	} else {
-		if (hasReader) {
+		if (mappedData) {
+			if (pos + size > mappedSize) {
+				throw Exception("Asset \"" + asset + "\" is out of pack bounds.", HalleyExceptions::Resources);
+			}
+
+			return std::make_unique<ResourceDataStatic>(std::shared_ptr<const char>(mappedData, mappedData.get() + pos), size, path);
+		} else if (hasReader) {
 			auto result = new char[size];
 			try {
 				readData(pos, gsl::as_writable_bytes(gsl::span<char>(result, size)));
@@ -195,6 +261,14 @@ void AssetPack::decrypt(const String& key)
 
 void AssetPack::readData(size_t pos, gsl::span<gsl::byte> dst)
 {
+	if (mappedData) {
+		if (pos + size_t(dst.size()) > mappedSize) {
+			throw Exception("Asset data is out of pack bounds.", HalleyExceptions::Resources);
+		}
+		memcpy(dst.data(), mappedData.get() + pos, dst.size());
+		return;
+	}
+
 	if (hasReader) {
 		std::unique_lock<std::mutex> lock(readerMutex);
 		if (reader) {
@@ -218,6 +292,40 @@ std::unique_ptr<ResourceDataReader> AssetPack::extractReader()
 	return std::move(reader);
 }
 
+bool AssetPack::isMemoryMapped() const
+{
+	return !!mappedData;
+}
+
+void AssetPack::readEntryLocations(const AssetPackHeader& header, bool hasEntryTable)
+{
+	auto entries = assetDb->getEntriesSorted();
+
+	if (hasEntryTable) {
+		if (header.entryTableCount != entries.size()) {
+			throw Exception("Asset pack is invalid (entry table doesn't match asset database)", HalleyExceptions::Resources);
+		}
+
+		Vector<AssetPackEntryLocation> table(entries.size());
+		const auto tableBytes = gsl::as_writable_bytes(gsl::span<AssetPackEntryLocation>(table));
+		reader->seek(int64_t(header.entryTableStartPos), SEEK_SET);
+		if (reader->read(tableBytes) != int(tableBytes.size())) {
+			throw Exception("Unable to read asset pack entry table", HalleyExceptions::Resources);
+		}
+		for (size_t i = 0; i < entries.size(); ++i) {
+			entries[i]->packPos = table[i].pos;
+			entries[i]->packSize = table[i].size;
+		}
+	} else {
+		// Legacy packs store "pos:size" in the path, parse it once here rather than on every lookup
+		for (auto* entry: entries) {
+			const auto ps = entry->path.split(':');
+			entry->packPos = uint64_t(ps.at(0).toInteger64());
+			entry->packSize = uint64_t(ps.at(1).toInteger64());
+		}
+	}
+}
+
 std::shared_ptr<bool> AssetPack::getAliveToken() const
 {
 	if (!aliveToken) {
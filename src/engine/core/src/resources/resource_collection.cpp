@@ -53,16 +53,19 @@ ResourceCollectionBase::ResourceCollectionBase(Resources& parent, AssetType type
 
 void ResourceCollectionBase::clear()
 {
+	std::unique_lock lock(mutex);
 	resources.clear();
 }
 
 void ResourceCollectionBase::unload(std::string_view assetId)
 {
+	std::unique_lock lock(mutex);
 	resources.erase(assetId);
 }
 
 void ResourceCollectionBase::unloadAll(int minDepth)
 {
+	std::unique_lock lock(mutex);
 	for (auto iter = resources.begin(); iter != resources.end(); ) {
 		auto next = iter;
 		++next;
@@ -106,6 +109,24 @@ std::shared_ptr<Resource> ResourceCollectionBase::getUntyped(std::string_view na
 	return doGet(name, priority, true);
 }
 
+Future<std::shared_ptr<Resource>> ResourceCollectionBase::getUntypedAsync(std::string_view name, ResourceLoadPriority priority)
+{
+	return Concurrent::execute(Executors::getDiskIO(), [this, name = String(name), priority] ()
+	{
+		return doTryGet(name, priority);
+	});
+}
+
+Future<void> ResourceCollectionBase::preload(gsl::span<const String> names, ResourceLoadPriority priority)
+{
+	Vector<Future<std::shared_ptr<Resource>>> futures;
+	futures.reserve(names.size());
+	for (const auto& name: names) {
+		futures.push_back(getUntypedAsync(name, priority));
+	}
+	return Concurrent::whenAll(futures.begin(), futures.end());
+}
+
 Vector<String> ResourceCollectionBase::enumerate() const
 {
 	if (resourceEnumerator) {
@@ -154,7 +175,7 @@ ResourceMemoryUsage ResourceCollectionBase::clearOldResources(float maxAge)
 	ResourceMemoryUsage usage;
 
 	{
-		std::shared_lock lock(mutex);
+		std::unique_lock lock(mutex);
 
 		for (auto iter = resources.begin(); iter != resources.end(); ) {
 			auto next = iter;
@@ -257,27 +278,79 @@ std::shared_ptr<Resource> ResourceCollectionBase::doGet(std::string_view assetId
 	if (res != resources.end()) {
 		return res->second.res;
 	}
-	
-	// Load resource from disk
-	const auto [newRes, loaded] = loadAsset(assetId, priority, allowFallback);
+
+	// If another thread is already loading it, wait for that load only
+	const auto pendingIter = pendingLoads.find(assetId);
+	if (pendingIter != pendingLoads.end()) {
+		const auto pending = pendingIter->second;
+		lockWrite.unlock();
+		if (pending->loadingThread == std::this_thread::get_id()) {
+			throw Exception("Circular dependency while loading \"" + toString(type) + ":" + assetId + "\"", HalleyExceptions::Resources);
+		}
+		return pending->result.get();
+	}
+
+	std::promise<std::shared_ptr<Resource>> promise;
+	auto pending = std::make_shared<PendingLoad>();
+	pending->loadingThread = std::this_thread::get_id();
+	pending->result = promise.get_future().share();
+	pendingLoads[String(assetId)] = pending;
+	lockWrite.unlock();
+
+	// Load resource from disk, without holding the collection lock
+	std::shared_ptr<Resource> newRes;
+	bool loaded = false;
+	try {
+		std::tie(newRes, loaded) = loadAsset(assetId, priority, allowFallback);
+	} catch (...) {
+		{
+			std::unique_lock lock(mutex);
+			pendingLoads.erase(assetId);
+		}
+		promise.set_exception(std::current_exception());
+		throw;
+	}
 
 	// Store in cache
 	if (loaded) {
 		newRes->setAssetId(assetId);
-		resources.emplace(assetId, Wrapper(newRes, 0));
-		lockWrite.unlock();
+	}
+	{
+		std::unique_lock lock(mutex);
+		if (loaded) {
+			resources.emplace(assetId, Wrapper(newRes, 0));
+		}
+		pendingLoads.erase(assetId);
+	}
+	if (loaded) {
 		newRes->onLoaded(parent);
 	}
+	promise.set_value(newRes);
 
 	return newRes;
 }
 
+std::shared_ptr<Resource> ResourceCollectionBase::doTryGet(std::string_view assetId, ResourceLoadPriority priority)
+{
+	try {
+		return doGet(assetId, priority, true);
+	} catch (const std::exception& e) {
+		Logger::logException(e);
+	} catch (...) {
+		Logger::logError("Unknown error while loading \"" + toString(type) + ":" + assetId + "\"");
+	}
+	return {};
+}
+
 bool ResourceCollectionBase::exists(std::string_view assetId) const
 {
 	// Look in cache
-	const auto res = resources.find(assetId);
-	if (res != resources.end()) {
-		return true;
+	{
+		std::shared_lock lock(mutex);
+		const auto res = resources.find(assetId);
+		if (res != resources.end()) {
+			return true;
+		}
 	}
 
 	return parent.locator->exists(assetId, type);
@@ -289,6 +362,7 @@ void ResourceCollectionBase::setFallback(std::string_view assetId)
 }
 
 void ResourceCollectionBase::setResource(int curDepth, std::string_view name, std::shared_ptr<Resource> resource) {
+	std::unique_lock lock(mutex);
 	resources.emplace(name, Wrapper(std::move(resource), curDepth));
 }
 
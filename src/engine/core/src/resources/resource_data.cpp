@@ -85,6 +85,67 @@ void ResourceDataReaderFileSystem::close()
 	}
 }
 
+ResourceDataReaderMemoryMapped::ResourceDataReaderMemoryMapped(gsl::span<const gsl::byte> data, UnmapCallback unmap)
+	: data(data)
+	, unmap(std::move(unmap))
+{
+}
+
+ResourceDataReaderMemoryMapped::~ResourceDataReaderMemoryMapped()
+{
+	close();
+}
+
+size_t ResourceDataReaderMemoryMapped::size() const
+{
+	return data.size();
+}
+
+int ResourceDataReaderMemoryMapped::read(gsl::span<gsl::byte> dst)
+{
+	const size_t toRead = std::min(size_t(dst.size()), data.size() - std::min(curPos, data.size()));
+	if (toRead > 0) {
+		memcpy(dst.data(), data.data() + curPos, toRead);
+	}
+	curPos += toRead;
+	return int(toRead);
+}
+
+void ResourceDataReaderMemoryMapped::seek(int64_t pos, int whence)
+{
+	switch (whence) {
+	case SEEK_SET:
+		curPos = size_t(pos);
+		break;
+	case SEEK_CUR:
+		curPos = size_t(curPos + pos);
+		break;
+	case SEEK_END:
+		curPos = size_t(data.size() + pos);
+		break;
+	}
+}
+
+size_t ResourceDataReaderMemoryMapped::tell() const
+{
+	return curPos;
+}
+
+void ResourceDataReaderMemoryMapped::close()
+{
+	if (unmap) {
+		unmap();
+		unmap = {};
+	}
+	data = {};
+	curPos = 0;
+}
+
+gsl::span<const gsl::byte> ResourceDataReaderMemoryMapped::getMappedData() const
+{
+	return data;
+}
+
 
 ResourceData::ResourceData(String p)
 	: path(p)
@@ -104,6 +165,14 @@ ResourceDataStatic::ResourceDataStatic(const void* _data, size_t _size, String p
 	set(_data, _size, owning);
 }
 
+ResourceDataStatic::ResourceDataStatic(std::shared_ptr<const char> data, size_t size, String path)
+	: ResourceData(path)
+	, data(std::move(data))
+	, size(size)
+	, loaded(true)
+{
+}
+
 static void deleter(const char* data)
 {
 	delete[] data;
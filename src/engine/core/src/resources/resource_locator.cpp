@@ -133,7 +133,7 @@ void ResourceLocator::addFileSystem(const Path& path)
 
 void ResourceLocator::addPack(const Path& path, const String& encryptionKey, bool preLoad, bool allowFailure, std::optional<int> priority)
 {
-	auto dataReader = system.getDataReader(path.string());
+	auto dataReader = PackResourceLocator::openPack(system, path);
 	if (dataReader) {
 		auto resourceLocator = std::make_unique<PackResourceLocator>(std::move(dataReader), path, encryptionKey, preLoad, priority);
 		add(std::move(resourceLocator), path);
@@ -173,7 +173,7 @@ void ResourceLocator::removePack(const Path& path)
 
 Vector<String> ResourceLocator::getAssetsFromPack(const Path& path, const String& encryptionKey) const
 {
-	auto dataReader = system.getDataReader(path.string());
+	auto dataReader = PackResourceLocator::openPack(system, path);
 	if (dataReader) {
 		std::unique_ptr<IResourceLocatorProvider> resourceLocator = std::make_unique<PackResourceLocator>(std::move(dataReader), path, "", true);
 		auto& db = resourceLocator->getAssetDatabase();
@@ -2,6 +2,7 @@
 #include <utility>
 #include "halley/resources/asset_pack.h"
 #include "halley/api/system_api.h"
+#include "halley/os/os.h"
 #include "halley/utils/algorithm.h"
 using namespace Halley;
 
@@ -18,6 +19,15 @@ PackResourceLocator::~PackResourceLocator()
 {
 }
 
+std::unique_ptr<ResourceDataReader> PackResourceLocator::openPack(SystemAPI& system, const Path& path)
+{
+	// Prefer mapping the pack, so assets can be used in place; fall back to the platform reader (e.g. for packed app bundles)
+	if (auto mapped = OS::get().mapFileToMemory(path)) {
+		return mapped;
+	}
+	return system.getDataReader(path.string());
+}
+
 std::unique_ptr<ResourceData> PackResourceLocator::getData(const String& asset, AssetType type, bool stream)
 {
 	if (!assetPack) {
@@ -54,7 +64,7 @@ bool PackResourceLocator::purgeIfAffected(SystemAPI& system, gsl::span<const Str
 
 void PackResourceLocator::loadAfterPurge()
 {
-	assetPack = std::make_unique<AssetPack>(system->getDataReader(path.string()), encryptionKey, preLoad);
+	assetPack = std::make_unique<AssetPack>(openPack(*system, path), encryptionKey, preLoad);
 }
 
 int PackResourceLocator::getPriority() const
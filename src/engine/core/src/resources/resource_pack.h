@@ -12,6 +12,8 @@ namespace Halley {
 		explicit PackResourceLocator(std::unique_ptr<ResourceDataReader> reader, Path path, String encryptionKey = "", bool preLoad = false, std::optional<int> priority = {});
 		~PackResourceLocator();
 
+		static std::unique_ptr<ResourceDataReader> openPack(SystemAPI& system, const Path& path);
+
 	protected:
 		std::unique_ptr<ResourceData> getData(const String& asset, AssetType type, bool stream) override;
 		const AssetDatabase& getAssetDatabase() override;
@@ -40,7 +40,7 @@ void ScriptEnvironment::update(Time time, ScriptState& graphState, EntityId curE
 		throw Exception("Unable to update script state, script not set.", HalleyExceptions::Entity);
 	}
 
-	ProfilerEvent event(ProfilerEventType::ScriptUpdate, currentGraph->getAssetId());
+	ProfilerEvent event(ProfilerEventType::ScriptUpdate, currentGraph->getProfilerName());
 
 	currentState = &graphState;
 	currentEntityVariables = &entityVariables;
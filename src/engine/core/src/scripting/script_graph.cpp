@@ -448,6 +448,15 @@ void ScriptGraph::clearTypes()
 	}
 }
 
+ProfilerNameId ScriptGraph::getProfilerName() const
+{
+	// Interned lazily, since the asset id is only set after construction
+	if (profilerName == 0) {
+		profilerName = ProfilerCapture::internName(getAssetId());
+	}
+	return profilerName;
+}
+
 GraphNodeId ScriptGraph::getNodeRoot(GraphNodeId nodeId) const
 {
 	return roots.getRoot(nodeId);
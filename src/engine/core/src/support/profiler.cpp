@@ -1,9 +1,56 @@
 #include "halley/support/profiler.h"
 
+#include "halley/support/exception.h"
 #include "halley/utils/algorithm.h"
 
 using namespace Halley;
 
+namespace {
+	class ProfilerNameTable {
+	public:
+		ProfilerNameTable()
+		{
+			names.emplace_back();
+			ids[std::string_view()] = 0;
+		}
+
+		ProfilerNameId intern(std::string_view name)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			const auto iter = ids.find(name);
+			if (iter != ids.end()) {
+				return iter->second;
+			}
+
+			// Keys point into the deque, which never relocates its elements
+			const auto id = static_cast<ProfilerNameId>(names.size());
+			const auto& str = names.emplace_back(name);
+			ids[std::string_view(str.cppStr())] = id;
+			return id;
+		}
+
+		const String& get(ProfilerNameId id)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			return id < names.size() ? names[id] : names[0];
+		}
+
+	private:
+		std::mutex mutex;
+		std::deque<String> names;
+		HashMap<std::string_view, ProfilerNameId> ids;
+	};
+
+	ProfilerNameTable& getNameTable()
+	{
+		static ProfilerNameTable table;
+		return table;
+	}
+
+	constexpr int eventIdIndexShift = 48;
+	constexpr uint64_t eventIdSeqMask = (uint64_t(1) << eventIdIndexShift) - 1;
+}
+
 
 bool ProfilerData::ThreadInfo::operator<(const ThreadInfo& other) const
 {
@@ -60,6 +107,11 @@ ProfilerData::Duration ProfilerData::getElapsedTime(ProfilerEventType eventType)
 	return end - start;
 }
 
+const String& ProfilerData::getEventName(const Event& event) const
+{
+	return ProfilerCapture::getName(event.name);
+}
+
 gsl::span<const ProfilerData::ThreadInfo> ProfilerData::getThreads() const
 {
 	return threads;
@@ -132,13 +184,27 @@ void ProfilerData::processEvents()
 	std::sort(threads.begin(), threads.end());
 }
 
-ProfilerCapture::ProfilerCapture(size_t maxEvents)
+ProfilerCapture::ThreadBuffer::ThreadBuffer(size_t capacity, uint16_t index)
+	: threadId(std::this_thread::get_id())
+	, index(index)
+	, head(0)
+{
+	size_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	slots = std::make_unique<EventSlot[]>(size);
+	mask = size - 1;
+}
+
+ProfilerCapture::ProfilerCapture(size_t maxEventsPerThread)
 	: recording(false)
-	, curId(0)
+	, maxEventsPerThread(std::max(maxEventsPerThread, size_t(1)))
 {
-	events.resize(maxEvents);
 }
 
+ProfilerCapture::~ProfilerCapture() = default;
+
 ProfilerCapture& ProfilerCapture::get()
 {
 	// TODO: move to HalleyStatics?
@@ -146,40 +212,96 @@ ProfilerCapture& ProfilerCapture::get()
 	return profiler;
 }
 
-ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, std::string_view name)
+ProfilerNameId ProfilerCapture::internName(std::string_view name)
+{
+	if (name.empty()) {
+		return 0;
+	}
+	return getNameTable().intern(name);
+}
+
+const String& ProfilerCapture::getName(ProfilerNameId id)
+{
+	return getNameTable().get(id);
+}
+
+ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, ProfilerNameId name)
 {
 	return recordEventStart(type, name, std::chrono::steady_clock::now());
 }
 
 void ProfilerCapture::recordEventEnd(EventId id)
 {
-	recordEventEnd(id, std::chrono::steady_clock::now());
+	if (id != 0) {
+		recordEventEnd(id, std::chrono::steady_clock::now());
+	}
 }
 
-ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, std::string_view name, std::chrono::steady_clock::time_point time)
+ProfilerCapture::EventId ProfilerCapture::recordEventStart(ProfilerEventType type, ProfilerNameId name, std::chrono::steady_clock::time_point time)
 {
-	if (recording) {
-		const auto id = curId++; // I think this is thread-safe?
-		if (id < endId) {
-			const auto pos = id % events.size();
-			const auto threadId = type == ProfilerEventType::GPU ? std::thread::id() : std::this_thread::get_id();
-			events[pos] = ProfilerData::Event{ name, threadId, type, 0, id, time, {} };
-			return id;
-		} else {
-			--curId;
-		}
+	if (!recording) {
+		return 0;
 	}
-	return 0;
+
+	auto& buffer = getThreadBuffer();
+	const auto seq = buffer.head.load(std::memory_order_relaxed);
+	auto& slot = buffer.slots[seq & buffer.mask];
+
+	// Invalidate the slot before touching it, so a concurrent reader can't mistake it for the old event
+	slot.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.startTime.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+	slot.endTime.store(0, std::memory_order_relaxed);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.type.store(type, std::memory_order_relaxed);
+	slot.seq.store(seq + 1, std::memory_order_release);
+	buffer.head.store(seq + 1, std::memory_order_release);
+
+	return (static_cast<uint64_t>(buffer.index + 1) << eventIdIndexShift) | (seq + 1);
 }
 
 void ProfilerCapture::recordEventEnd(EventId id, std::chrono::steady_clock::time_point time)
 {
-	if (recording && id != 0) {
-		const auto pos = id % events.size();
-		if (events[pos].id == id) { // Dodgy, potential race condition here
-			events[pos].endTime = time;
+	if (!recording || id == 0) {
+		return;
+	}
+
+	// Events always end on the thread that started them, so only that thread's buffer needs checking
+	auto& buffer = getThreadBuffer();
+	if ((id >> eventIdIndexShift) != static_cast<uint64_t>(buffer.index + 1)) {
+		return;
+	}
+	const auto seq = id & eventIdSeqMask;
+	auto& slot = buffer.slots[(seq - 1) & buffer.mask];
+	if (slot.seq.load(std::memory_order_relaxed) == seq) {
+		slot.endTime.store(time.time_since_epoch().count(), std::memory_order_release);
+	}
+}
+
+ProfilerCapture::ThreadBuffer& ProfilerCapture::getThreadBuffer()
+{
+	thread_local const ProfilerCapture* owner = nullptr;
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (owner != this) {
+		buffer = &registerThreadBuffer();
+		owner = this;
+	}
+	return *buffer;
+}
+
+ProfilerCapture::ThreadBuffer& ProfilerCapture::registerThreadBuffer()
+{
+	std::unique_lock<std::mutex> lock(threadBuffersMutex);
+	const auto threadId = std::this_thread::get_id();
+	for (auto& buffer: threadBuffers) {
+		if (buffer.threadId == threadId) {
+			return buffer;
 		}
 	}
+	if (threadBuffers.size() >= std::numeric_limits<uint16_t>::max()) {
+		throw Exception("Too many threads registered with the profiler", HalleyExceptions::Core);
+	}
+	return threadBuffers.emplace_back(maxEventsPerThread, static_cast<uint16_t>(threadBuffers.size()));
 }
 
 bool ProfilerCapture::isRecording() const
@@ -198,8 +320,12 @@ void ProfilerCapture::startFrame(bool rec)
 	}
 	frameEndTime = {};
 
-	startId = curId.fetch_add(events.size()) + events.size();
-	endId = startId + events.size();
+	{
+		std::unique_lock<std::mutex> lock(threadBuffersMutex);
+		for (auto& buffer: threadBuffers) {
+			buffer.frameStart = buffer.head.load(std::memory_order_acquire);
+		}
+	}
 
 	recording = rec;
 	state = State::FrameStarted;
@@ -217,16 +343,45 @@ ProfilerData ProfilerCapture::getCapture()
 {
 	Expects(state == State::FrameEnded);
 
-	const auto startIdx = startId % events.size();
-	const auto endIdx = curId % events.size();
-
+	using TimePoint = ProfilerData::TimePoint;
 	Vector<ProfilerData::Event> eventsCopy;
-	if (startIdx < endIdx) {
-		eventsCopy.insert(eventsCopy.end(), events.begin() + startIdx, events.begin() + endIdx);
-	} else {
-		eventsCopy.insert(eventsCopy.end(), events.begin() + startIdx, events.end());
-		eventsCopy.insert(eventsCopy.end(), events.begin(), events.begin() + endIdx);
+
+	{
+		std::unique_lock<std::mutex> lock(threadBuffersMutex);
+		for (auto& buffer: threadBuffers) {
+			const auto capacity = buffer.mask + 1;
+			const auto end = buffer.head.load(std::memory_order_acquire);
+			const auto start = std::max(buffer.frameStart, end > capacity ? end - capacity : 0);
+
+			for (auto seq = start; seq < end; ++seq) {
+				const auto& slot = buffer.slots[seq & buffer.mask];
+				const auto slotSeq = slot.seq.load(std::memory_order_acquire);
+				if (slotSeq != seq + 1) {
+					continue;
+				}
+
+				const auto startTime = slot.startTime.load(std::memory_order_relaxed);
+				const auto endTime = slot.endTime.load(std::memory_order_acquire);
+				const auto name = slot.name.load(std::memory_order_relaxed);
+				const auto type = slot.type.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.seq.load(std::memory_order_relaxed) != slotSeq) {
+					// Overwritten by the owning thread while we were reading it
+					continue;
+				}
+
+				const auto threadId = type == ProfilerEventType::GPU ? std::thread::id() : buffer.threadId;
+				const auto id = (static_cast<uint64_t>(buffer.index + 1) << eventIdIndexShift) | slotSeq;
+				eventsCopy.push_back(ProfilerData::Event{ name, threadId, type, 0, id,
+					TimePoint(TimePoint::duration(startTime)), endTime != 0 ? TimePoint(TimePoint::duration(endTime)) : TimePoint{} });
+			}
+		}
 	}
+
+	std::stable_sort(eventsCopy.begin(), eventsCopy.end(), [] (const ProfilerData::Event& a, const ProfilerData::Event& b)
+	{
+		return a.startTime < b.startTime;
+	});
 	
 	return ProfilerData(frameStartTime, frameEndTime, std::move(eventsCopy));
 }
@@ -261,7 +416,7 @@ constexpr static bool alwaysLogType(ProfilerEventType type)
 	}
 }
 
-ProfilerEvent::ProfilerEvent(ProfilerEventType type, std::string_view name)
+ProfilerEvent::ProfilerEvent(ProfilerEventType type, ProfilerNameId name)
 {
 	if (isDevMode() || alwaysLogType(type)) {
 		id = ProfilerCapture::get().recordEventStart(type, name);
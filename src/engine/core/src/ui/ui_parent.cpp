@@ -101,6 +101,10 @@ bool UIParent::isWaitingToSpawnChildren() const
 
 void UIParent::markAsNeedingLayout() {}
 
+void UIParent::markLayoutDirty() {}
+
+void UIParent::markDescendantAsNeedingLayout(bool sizeChanged) {}
+
 Vector<std::shared_ptr<UIWidget>>& UIParent::getChildren()
 {
 	/*
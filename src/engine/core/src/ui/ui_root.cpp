@@ -62,8 +62,18 @@ Rect4f UIRoot::getRect() const
 
 void UIRoot::runLayout()
 {
-	for (auto& c: getChildren()) {
-		c->layout();
+	// Widgets only do work if something under them was invalidated, so this is cheap when nothing changed.
+	// A few extra passes are allowed for widgets that only find out their size changed while being laid out.
+	constexpr int maxPasses = 3;
+	for (int pass = 0; pass < maxPasses; ++pass) {
+		bool pending = false;
+		for (auto& c: getChildren()) {
+			c->layout();
+			pending = pending || (c->isActive() && c->hasPendingLayout());
+		}
+		if (!pending) {
+			break;
+		}
 	}
 }
 
@@ -143,14 +143,35 @@ Vector2f UIWidget::getLayoutMinimumSize(bool force) const
 void UIWidget::setRect(Rect4f rect, IUIElementListener* listener)
 {
 	setWidgetRect(rect);
+
+	Rect4f sizerRect;
 	if (sizer) {
 		const auto border = getInnerBorder();
 		const auto p0 = getLayoutOriginPosition();
 		const auto size = getLayoutSize(rect.getSize());
+		sizerRect = Rect4f(p0 + Vector2f(border.x, border.y), p0 + size - Vector2f(border.z, border.w));
+	}
+
+	// Listeners (e.g. render surfaces) need to see every placement, so they always get a full pass
+	const bool fullLayout = layoutDirty || listener || rect != lastLayoutRect || sizerRect != lastSizerRect;
+	if (!fullLayout) {
+		if (descendantLayoutDirty) {
+			descendantLayoutDirty = false;
+			layoutDirtyChildren();
+		}
+		return;
+	}
+
+	layoutDirty = false;
+	descendantLayoutDirty = false;
+	lastLayoutRect = rect;
+	lastSizerRect = sizerRect;
+
+	if (sizer) {
 		if (listener) {
 			onPreNotifySetRect(*listener);
 		}
-		sizer->setRect(Rect4f(p0 + Vector2f(border.x, border.y), p0 + size - Vector2f(border.z, border.w)), listener);
+		sizer->setRect(sizerRect, listener);
 	} else {
 		for (auto& c: getChildren()) {
 			c->layout();
@@ -158,6 +179,21 @@ void UIWidget::setRect(Rect4f rect, IUIElementListener* listener)
 	}
 }
 
+void UIWidget::layoutDirtyChildren()
+{
+	// Our own rect didn't change, so let the sizer place its entries again; clean ones end up with the same rect and return straight away
+	if (sizer) {
+		sizer->setRect(lastSizerRect, nullptr);
+		return;
+	}
+
+	for (auto& c: getChildren()) {
+		if (c->isActive() && c->hasPendingLayout()) {
+			c->layout();
+		}
+	}
+}
+
 void UIWidget::onPreNotifySetRect(IUIElementListener& listener)
 {
 }
@@ -211,6 +247,8 @@ void UIWidget::setAnchor()
 
 std::optional<UISizer>& UIWidget::tryGetSizer()
 {
+	// The caller may modify the sizer, so assume it did
+	markAsNeedingLayout();
 	return sizer;
 }
 
@@ -224,6 +262,7 @@ UISizer& UIWidget::getSizer()
 	if (!sizer) {
 		throw Exception("UIWidget does not have a sizer.", HalleyExceptions::UI);
 	}
+	markAsNeedingLayout();
 	return sizer.value();
 }
 
@@ -233,6 +272,7 @@ void UIWidget::setSizer(std::optional<UISizer> sizer)
 	if (this->sizer) {
 		this->sizer->reparent(*this);
 	}
+	markAsNeedingLayout();
 }
 
 void UIWidget::add(std::shared_ptr<IUIElement> element, float proportion, Vector4f border, int fillFlags, Vector2f position, size_t insertPos)
@@ -248,6 +288,7 @@ void UIWidget::add(std::shared_ptr<IUIElement> element, float proportion, Vector
 	}
 	if (sizer) {
 		sizer->add(element, proportion, border, fillFlags, position, insertPos);
+		markAsNeedingLayout();
 	}
 }
 
@@ -255,6 +296,7 @@ void UIWidget::addSpacer(float size)
 {
 	if (sizer) {
 		sizer->addSpacer(size);
+		markAsNeedingLayout();
 	}
 }
 
@@ -262,6 +304,7 @@ void UIWidget::addStretchSpacer(float proportion)
 {
 	if (sizer) {
 		sizer->addStretchSpacer(proportion);
+		markAsNeedingLayout();
 	}
 }
 
@@ -280,6 +323,7 @@ void UIWidget::remove(IUIElement& element)
 	}
 	if (sizer) {
 		sizer->remove(element);
+		markAsNeedingLayout();
 	}
 }
 
@@ -376,9 +420,16 @@ bool UIWidget::ignoreClip() const
 void UIWidget::setPosition(Vector2f pos)
 {
 	Expects(pos.isValid());
-	
-	position = pos;
-	positionUpdated = true;
+
+	if (position != pos) {
+		position = pos;
+		positionUpdated = true;
+
+		// The parent has to place us again, either back into its sizer or to move our children along
+		if (parent) {
+			parent->markLayoutDirty();
+		}
+	}
 }
 
 void UIWidget::setMinSize(Vector2f size)
@@ -967,17 +1018,54 @@ bool UIWidget::needsLayout() const
 	return layoutNeeded > 0;
 }
 
+bool UIWidget::hasPendingLayout() const
+{
+	return layoutDirty || descendantLayoutDirty;
+}
+
 void UIWidget::markAsNeedingLayout()
 {
 	layoutNeeded = 1;
+	layoutDirty = true;
 	if (parent) {
-		parent->markAsNeedingLayout();
+		parent->markDescendantAsNeedingLayout(true);
 	}
 	if (sizer) {
 		sizer->updateEnabled();
 	}
 }
 
+void UIWidget::markLayoutDirty()
+{
+	layoutDirty = true;
+	if (parent) {
+		parent->markDescendantAsNeedingLayout(false);
+	}
+}
+
+void UIWidget::markDescendantAsNeedingLayout(bool sizeChanged)
+{
+	if (sizeChanged) {
+		layoutNeeded = 1;
+		layoutDirty = true;
+		if (sizer) {
+			sizer->updateEnabled();
+		}
+		sizeChanged = childrenAffectLayoutSize();
+	} else {
+		descendantLayoutDirty = true;
+	}
+
+	if (parent) {
+		parent->markDescendantAsNeedingLayout(sizeChanged);
+	}
+}
+
+bool UIWidget::childrenAffectLayoutSize() const
+{
+	return true;
+}
+
 bool UIWidget::canReceiveFocus() const
 {
 	return false;
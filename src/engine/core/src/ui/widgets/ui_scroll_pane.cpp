@@ -70,6 +70,7 @@ void UIScrollPane::scrollTo(Vector2f position)
 	}
 
 	if (scrollPos != old) {
+		markLayoutDirty();
 		sendEventDown(UIEvent(UIEventType::ScrollPositionChanged, getId(), Vector2f(scrollPos)));
 	}
 }
@@ -172,7 +173,12 @@ void UIScrollPane::refresh(bool force)
 		clipSize.y = getSize().y;
 		scrollPos.y = 0;
 	}
+	const bool wasSizeFixed = !childrenAffectLayoutSize();
 	contentsSize = UIWidget::getLayoutMinimumSize(false);
+	if (wasSizeFixed && childrenAffectLayoutSize()) {
+		// Contents shrank below the clip area, so our parent now has to take them into account
+		markAsNeedingLayout();
+	}
 
 	setMouseClip(getRect(), force);
 	scrollTo(getScrollPosition());
@@ -231,6 +237,12 @@ Vector2f UIScrollPane::getBasePosition(const String& widgetId)
 	}
 }
 
+bool UIScrollPane::childrenAffectLayoutSize() const
+{
+	// Once the contents overflow the clip area along every axis, our minimum size is just the clip size
+	return !(scrollHorizontal && scrollVertical && contentsSize.x >= clipSize.x && contentsSize.y >= clipSize.y);
+}
+
 Vector2f UIScrollPane::getLayoutOriginPosition() const
 {
 	return getPosition() - scrollPos.floor();
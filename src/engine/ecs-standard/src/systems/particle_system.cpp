@@ -20,15 +20,21 @@ public:
 
 	void update(Time t)
 	{
+		// Transforms are resolved up front, as they might need to update cached data shared between entities
 		for (auto& e: particleFamily) {
+			e.particles.particles.setPosition(Vector3f(e.transform2D.getGlobalPosition(), e.transform2D.getGlobalHeight()));
+		}
+
+		// Emitters are independent of each other, so they can be stepped in parallel. Dead ones are destroyed once every chunk is done.
+		const bool isEditor = getWorld().isEditor();
+		parallelForEach(particleFamily, 0, [&] (ParticleFamily& e, EntityCommandBuffer& commands)
+		{
 			auto& particles = e.particles.particles;
-			particles.setPosition(Vector3f(e.transform2D.getGlobalPosition(), e.transform2D.getGlobalHeight()));
 			particles.update(t);
-
-			if (!particles.isAlive() && !particles.isEnabled() && !getWorld().isEditor()) {
-				getWorld().destroyEntity(e.entityId);
+			if (!particles.isAlive() && !particles.isEnabled() && !isEditor) {
+				commands.destroyEntity(e.entityId);
 			}
-		}
+		});
 
 		editorDebugDraw();
 	}
@@ -399,7 +399,8 @@ private:
 
 	void updateDevCon()
 	{
-		ProfilerEvent event(ProfilerEventType::CoreDevConClient, "Scripts");
+		static const auto profilerName = ProfilerCapture::internName("Scripts");
+		ProfilerEvent event(ProfilerEventType::CoreDevConClient, profilerName);
 		auto* devConClient = getAPI().core->getDevConClient();
 		if (devConClient) {
 			updateInterest(devConClient->getInterest());
@@ -79,10 +79,19 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 
 	int bpp = TextureDescriptor::getBytesPerPixel(descriptor.format);
 
+	// Block-compressed textures come with their mip chain precomputed, as the GPU can't generate it for them
+	const bool blockCompressed = TextureDescriptor::isBlockCompressed(descriptor.format);
+	const bool generateMips = descriptor.useMipMap && !blockCompressed;
+	const int nLevels = blockCompressed ? std::max(descriptor.mipLevels, 1) : 1;
+	if (blockCompressed && (size.x % 4 != 0 || size.y % 4 != 0)) {
+		// The importer won't produce these, as the mip chain it encodes wouldn't line up with the one D3D11 expects
+		throw Exception("Block-compressed textures must be a multiple of 4 in size on Direct3D 11, got " + toString(size.x) + "x" + toString(size.y), HalleyExceptions::VideoPlugin);
+	}
+
 	CD3D11_TEXTURE2D_DESC desc;
 	desc.Width = size.x;
 	desc.Height = size.y;
-	desc.MipLevels = descriptor.useMipMap ? 0 : 1;
+	desc.MipLevels = generateMips ? 0 : nLevels;
 	desc.ArraySize = 1;
 
 	switch (descriptor.format) {
@@ -114,11 +123,27 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 	case TextureFormat::RGBAFloat16:
 		desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
 		break;
+	case TextureFormat::BC1:
+		desc.Format = DXGI_FORMAT_BC1_UNORM;
+		break;
+	case TextureFormat::BC3:
+		desc.Format = DXGI_FORMAT_BC3_UNORM;
+		break;
+	case TextureFormat::BC7:
+		desc.Format = DXGI_FORMAT_BC7_UNORM;
+		break;
+	case TextureFormat::ETC2RGB:
+	case TextureFormat::ETC2RGBA:
+	case TextureFormat::ASTC4x4:
+		throw Exception("Texture format " + toString(descriptor.format) + " is not supported on Direct3D 11", HalleyExceptions::VideoPlugin);
 	default:
 		throw Exception("Unknown texture format", HalleyExceptions::VideoPlugin);
 	}
 
-	vramUsage = bpp * size.x * size.y;
+	vramUsage = 0;
+	for (int level = 0; level < nLevels; ++level) {
+		vramUsage += TextureDescriptor::getByteSize(descriptor.format, TextureDescriptor::getMipSize(size, level));
+	}
 
 	desc.BindFlags = 0;
 	if (descriptor.isDepthStencil) {
@@ -130,29 +155,46 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 			desc.BindFlags |= D3D11_BIND_RENDER_TARGET;
 		}
 	}
-	if (descriptor.useMipMap) {
+	if (generateMips) {
 		desc.BindFlags |= D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
 	}
 
 	desc.SampleDesc.Count = 1;
 	desc.SampleDesc.Quality = 0;
-	desc.MiscFlags = descriptor.useMipMap ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
+	desc.MiscFlags = generateMips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
 	format = desc.Format;
 
 	bool hasPixelData = false;
-	D3D11_SUBRESOURCE_DATA subResData;
+	Vector<D3D11_SUBRESOURCE_DATA> subResData(nLevels);
 			
 	if (descriptor.pixelData.empty()) {
 		desc.Usage = D3D11_USAGE_DEFAULT;
 	} else {
-		if (descriptor.canBeUpdated || descriptor.useMipMap) {
+		if (descriptor.canBeUpdated || generateMips) {
 			desc.Usage = D3D11_USAGE_DEFAULT;
 		} else {
 			desc.Usage = D3D11_USAGE_IMMUTABLE;
 		}
-		subResData.pSysMem = descriptor.pixelData.getSpan().data();
-		subResData.SysMemPitch = descriptor.pixelData.getStrideOr(bpp * size.x);
-		subResData.SysMemSlicePitch = 0;
+
+		const auto data = descriptor.pixelData.getSpan();
+		if (blockCompressed) {
+			size_t pos = 0;
+			for (int level = 0; level < nLevels; ++level) {
+				const auto levelSize = TextureDescriptor::getMipSize(size, level);
+				const auto levelBytes = TextureDescriptor::getByteSize(descriptor.format, levelSize);
+				if (pos + levelBytes > size_t(data.size())) {
+					throw Exception("Not enough data for texture mip level " + toString(level), HalleyExceptions::VideoPlugin);
+				}
+				subResData[level].pSysMem = data.data() + pos;
+				subResData[level].SysMemPitch = UINT(TextureDescriptor::getByteSize(descriptor.format, Vector2i(levelSize.x, 1)));
+				subResData[level].SysMemSlicePitch = 0;
+				pos += levelBytes;
+			}
+		} else {
+			subResData[0].pSysMem = data.data();
+			subResData[0].SysMemPitch = descriptor.pixelData.getStrideOr(bpp * size.x);
+			subResData[0].SysMemSlicePitch = 0;
+		}
 		hasPixelData = true;
 	}
 
@@ -162,7 +204,7 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 		desc.Usage = D3D11_USAGE_STAGING;
 	}
 
-	HRESULT result = video.getDevice().CreateTexture2D(&desc, hasPixelData && !descriptor.useMipMap ? &subResData : nullptr, &texture);
+	HRESULT result = video.getDevice().CreateTexture2D(&desc, hasPixelData && !generateMips ? subResData.data() : nullptr, &texture);
 	if (result != S_OK) {
 		throw Exception("Error loading texture.", HalleyExceptions::VideoPlugin);
 	}
@@ -171,7 +213,7 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 		CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
 		srvDesc.Format = desc.Format;
 		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = descriptor.useMipMap ? -1 : 1;
+		srvDesc.Texture2D.MipLevels = generateMips ? -1 : nLevels;
 		srvDesc.Texture2D.MostDetailedMip = 0;
 
 		if (descriptor.format == TextureFormat::Depth) {
@@ -193,9 +235,9 @@ void DX11Texture::doLoad(TextureDescriptor& descriptor)
 			}
 		}
 		
-		if (descriptor.useMipMap) {
+		if (generateMips) {
 			if (hasPixelData) {
-				video.getDeviceContext().UpdateSubresource(texture, 0, nullptr, subResData.pSysMem, subResData.SysMemPitch, 0);
+				video.getDeviceContext().UpdateSubresource(texture, 0, nullptr, subResData[0].pSysMem, subResData[0].SysMemPitch, 0);
 			}
 			generateMipMaps();
 		}
@@ -232,7 +274,7 @@ void DX11Texture::bind(DX11Video& video, int textureUnit, TextureSamplerType sam
 
 void DX11Texture::generateMipMaps()
 {
-	if (descriptor.useMipMap && srv) {
+	if (descriptor.useMipMap && srv && !TextureDescriptor::isBlockCompressed(descriptor.format)) {
 		video.getDeviceContext().GenerateMips(srv);
 	}
 }
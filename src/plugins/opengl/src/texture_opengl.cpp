@@ -10,6 +10,25 @@
 
 using namespace Halley;
 
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#endif
+
 TextureOpenGL::TextureOpenGL(VideoOpenGL& parent, Vector2i size)
 	: Texture(size)
 	, parent(parent)
@@ -46,7 +65,9 @@ void TextureOpenGL::doLoad(TextureDescriptor& d)
     glUtils.setTextureUnit(0);
 	glUtils.bindTexture(textureId);
 	
-	if (texSize != d.size) {
+	if (TextureDescriptor::isBlockCompressed(d.format)) {
+		createCompressed(d);
+	} else if (texSize != d.size) {
 		create(d.size, d.format, d.useMipMap, d.useFiltering, d.addressMode, d.pixelData);
 	} else if (!d.pixelData.empty()) {
 		updateImage(d.pixelData, d.format, d.useMipMap);
@@ -61,7 +82,7 @@ void TextureOpenGL::reload(Resource&& resource)
 
 void TextureOpenGL::generateMipMaps()
 {
-	if (descriptor.useMipMap) {
+	if (descriptor.useMipMap && !TextureDescriptor::isBlockCompressed(descriptor.format)) {
 		GLUtils glUtils;
 	    glUtils.setTextureUnit(0);
 		glUtils.bindTexture(textureId);
@@ -170,6 +191,43 @@ void TextureOpenGL::create(Vector2i size, TextureFormat format, bool useMipMap,
 	texSize = size;
 }
 
+void TextureOpenGL::createCompressed(const TextureDescriptor& d)
+{
+	Expects(d.size.x > 0);
+	Expects(d.size.y > 0);
+	Expects(!d.pixelData.empty());
+	glCheckError();
+
+	// Mipmaps can't be generated for compressed formats, so only the levels that come with the data are used
+	const bool useMipMap = d.useMipMap && d.mipLevels > 1;
+#if defined (WITH_OPENGL) || defined(WITH_OPENGL_ES3)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, d.mipLevels - 1);
+	GLuint wrap = getGLAddressMode(d.addressMode);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+#endif
+
+	int filtering = d.useFiltering ? GL_LINEAR : GL_NEAREST;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, useMipMap ? GL_LINEAR_MIPMAP_LINEAR : filtering);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering);
+
+	const auto internalFormat = getGLInternalFormat(d.format);
+	const auto data = d.pixelData.getSpan();
+	size_t pos = 0;
+	for (int level = 0; level < d.mipLevels; ++level) {
+		const auto levelSize = TextureDescriptor::getMipSize(d.size, level);
+		const auto levelBytes = TextureDescriptor::getByteSize(d.format, levelSize);
+		if (pos + levelBytes > size_t(data.size())) {
+			throw Exception("Not enough data for texture mip level " + toString(level), HalleyExceptions::VideoPlugin);
+		}
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelSize.x, levelSize.y, 0, GLsizei(levelBytes), data.data() + pos);
+		glCheckError();
+		pos += levelBytes;
+	}
+
+	texSize = d.size;
+}
+
 void TextureOpenGL::updateImage(TextureDescriptorImageData& pixelData, TextureFormat format, bool useMipMap)
 {
 	int stride = pixelData.getStrideOr(size.x);
@@ -202,6 +260,18 @@ unsigned TextureOpenGL::getGLInternalFormat(TextureFormat format)
 		return GL_RGBA;
 	case TextureFormat::Depth:
 		return GL_DEPTH_COMPONENT24;
+	case TextureFormat::BC1:
+		return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case TextureFormat::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureFormat::BC7:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case TextureFormat::ETC2RGB:
+		return GL_COMPRESSED_RGB8_ETC2;
+	case TextureFormat::ETC2RGBA:
+		return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	case TextureFormat::ASTC4x4:
+		return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
 	default:
 		throw Exception("Unknown texture format: " + toString(static_cast<int>(format)), HalleyExceptions::VideoPlugin);
 	}
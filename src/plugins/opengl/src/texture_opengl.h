@@ -27,6 +27,7 @@ namespace Halley
 
 	private:
 		void updateImage(TextureDescriptorImageData& pixelData, TextureFormat format, bool useMipMap);
+		void createCompressed(const TextureDescriptor& descriptor);
 		void create(Vector2i size, TextureFormat format, bool useMipMap, bool useFiltering, TextureAddressMode addressMode, TextureDescriptorImageData& imgData);
 
 		static unsigned int getGLInternalFormat(TextureFormat format);
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	// Plain in-memory reader, which doesn't expose its contents as a mapping
+	class BytesReader final : public ResourceDataReader {
+	public:
+		BytesReader(Bytes bytes) : bytes(std::move(bytes)) {}
+
+		size_t size() const override { return bytes.size(); }
+		size_t tell() const override { return pos; }
+		void close() override {}
+
+		int read(gsl::span<gsl::byte> dst) override
+		{
+			const size_t toRead = std::min(size_t(dst.size()), bytes.size() - std::min(pos, bytes.size()));
+			memcpy(dst.data(), bytes.data() + pos, toRead);
+			pos += toRead;
+			return int(toRead);
+		}
+
+		void seek(int64_t offset, int whence) override
+		{
+			if (whence == SEEK_SET) {
+				pos = size_t(offset);
+			} else if (whence == SEEK_CUR) {
+				pos = size_t(int64_t(pos) + offset);
+			} else {
+				pos = size_t(int64_t(bytes.size()) + offset);
+			}
+		}
+
+	private:
+		Bytes bytes;
+		size_t pos = 0;
+	};
+
+	void addAsset(AssetPack& pack, const String& name, const String& contents)
+	{
+		auto& data = pack.getData();
+		const auto pos = alignUp(data.size(), AssetPackHeader::entryAlignment);
+		data.resize(pos + contents.size());
+		memcpy(data.data() + pos, contents.c_str(), contents.size());
+
+		auto entry = AssetDatabase::Entry(String(), Metadata());
+		entry.packPos = pos;
+		entry.packSize = contents.size();
+		pack.getAssetDatabase().addAsset(name, AssetType::BinaryFile, std::move(entry));
+	}
+
+	Bytes makePackBytes()
+	{
+		AssetPack pack;
+		addAsset(pack, "first", "hello");
+		addAsset(pack, "second", "world!");
+		return pack.writeOut();
+	}
+
+	String readStatic(AssetPack& pack, const String& name)
+	{
+		auto data = pack.getData(name, AssetType::BinaryFile, false);
+		auto* staticData = dynamic_cast<ResourceDataStatic*>(data.get());
+		return staticData ? staticData->getString() : String();
+	}
+
+	String readStream(AssetPack& pack, const String& name)
+	{
+		auto data = pack.getData(name, AssetType::BinaryFile, true);
+		auto* streamData = dynamic_cast<ResourceDataStream*>(data.get());
+		if (!streamData) {
+			return {};
+		}
+		const auto bytes = streamData->getReader()->readAll();
+		return String(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+}
+
+TEST(HalleyAssetPack, ReadsFromReader)
+{
+	AssetPack pack(std::make_unique<BytesReader>(makePackBytes()));
+	EXPECT_FALSE(pack.isMemoryMapped());
+	EXPECT_EQ(readStatic(pack, "first"), "hello");
+	EXPECT_EQ(readStatic(pack, "second"), "world!");
+	EXPECT_EQ(readStream(pack, "second"), "world!");
+	EXPECT_EQ(pack.getData("missing", AssetType::BinaryFile, false), nullptr);
+}
+
+TEST(HalleyAssetPack, ReadsPreloaded)
+{
+	AssetPack pack(std::make_unique<BytesReader>(makePackBytes()), "", true);
+	EXPECT_FALSE(pack.isMemoryMapped());
+	EXPECT_EQ(readStatic(pack, "first"), "hello");
+	EXPECT_EQ(readStream(pack, "second"), "world!");
+}
+
+TEST(HalleyAssetPack, ReadsLegacyFormat)
+{
+	// Version 1 packs have no entry table, and store "pos:size" as the path of each asset
+	AssetDatabase db;
+	db.addAsset("first", AssetType::BinaryFile, AssetDatabase::Entry("0:5", Metadata()));
+	db.addAsset("second", AssetType::BinaryFile, AssetDatabase::Entry("5:6", Metadata()));
+	const auto dbBytes = Compression::compress(Serializer::toBytes(db));
+	const String contents = "helloworld!";
+
+	AssetPackHeader header;
+	memcpy(header.identifier.data(), "HALLEYPK", 8);
+	memset(header.iv.data(), 0, header.iv.size());
+	header.assetDbStartPos = AssetPackHeader::headerSizeV1;
+	header.dataStartPos = header.assetDbStartPos + dbBytes.size();
+
+	Bytes bytes(size_t(header.dataStartPos) + contents.size());
+	memcpy(bytes.data(), &header, AssetPackHeader::headerSizeV1);
+	memcpy(bytes.data() + header.assetDbStartPos, dbBytes.data(), dbBytes.size());
+	memcpy(bytes.data() + header.dataStartPos, contents.c_str(), contents.size());
+
+	AssetPack pack(std::make_unique<BytesReader>(std::move(bytes)));
+	EXPECT_EQ(readStatic(pack, "first"), "hello");
+	EXPECT_EQ(readStatic(pack, "second"), "world!");
+}
+
+TEST(HalleyAssetPack, MappedPackServesInPlace)
+{
+	const auto bytes = makePackBytes();
+	bool unmapped = false;
+	auto pack = std::make_unique<AssetPack>(std::make_unique<ResourceDataReaderMemoryMapped>(gsl::as_bytes(gsl::span<const Byte>(bytes)), [&] () { unmapped = true; }));
+	ASSERT_TRUE(pack->isMemoryMapped());
+
+	auto data = pack->getData("second", AssetType::BinaryFile, false);
+	auto* staticData = dynamic_cast<ResourceDataStatic*>(data.get());
+	ASSERT_NE(staticData, nullptr);
+	EXPECT_EQ(staticData->getString(), "world!");
+
+	// No copy was made, the data points straight into the mapping
+	const auto* ptr = static_cast<const Byte*>(staticData->getData());
+	EXPECT_GE(ptr, bytes.data());
+	EXPECT_LT(ptr, bytes.data() + bytes.size());
+	EXPECT_EQ(readStream(*pack, "first"), "hello");
+
+	// The mapping stays alive for as long as anything handed out from it does
+	pack.reset();
+	EXPECT_FALSE(unmapped);
+	EXPECT_EQ(staticData->getString(), "world!");
+	data.reset();
+	EXPECT_TRUE(unmapped);
+}
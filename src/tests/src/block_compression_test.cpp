@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "halley/file_formats/block_compression.h"
+using namespace Halley;
+
+namespace {
+	Image makeGradient(Vector2i size, bool translucent)
+	{
+		Image image(Image::Format::RGBA, size);
+		auto px = image.getPixelBytes();
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				auto* p = px.data() + (y * size.x + x) * 4;
+				p[0] = uint8_t(x * 255 / size.x);
+				p[1] = uint8_t(255 - p[0]);
+				p[2] = uint8_t(p[0] / 2 + y);
+				p[3] = translucent ? uint8_t(255 - p[0] / 2) : 255;
+			}
+		}
+		return image;
+	}
+
+	int maxError(const Image& a, const Image& b, int channels)
+	{
+		// Only compare actual pixels, the buffer is padded past the last row
+		const auto pa = a.getPixelBytes();
+		const auto pb = b.getPixelBytes();
+		const auto size = a.getSize();
+		const auto nBytes = size_t(size.x) * size_t(size.y) * 4;
+		EXPECT_EQ(size, b.getSize());
+		int result = 0;
+		for (size_t i = 0; i < nBytes; ++i) {
+			if (int(i % 4) < channels) {
+				result = std::max(result, std::abs(int(pa[i]) - int(pb[i])));
+			}
+		}
+		return result;
+	}
+
+	void testRoundTrip(TextureFormat format, bool translucent, int tolerance)
+	{
+		// Deliberately not a multiple of the block size
+		const auto size = Vector2i(37, 29);
+		const auto image = makeGradient(size, translucent);
+
+		const auto data = BlockCompression::encode(image, format);
+		EXPECT_EQ(data.size(), TextureDescriptor::getByteSize(format, size));
+
+		const auto decoded = BlockCompression::decode(data.byte_span(), size, format);
+		EXPECT_LE(maxError(image, *decoded, translucent ? 4 : 3), tolerance);
+	}
+
+	using Texel = std::array<int, 4>;
+
+	// Decodes a single block assembled by hand from the format's specification, and checks it against the texels the specification gives for it
+	void testReferenceBlock(TextureFormat format, Vector<uint8_t> block, const std::array<Texel, 16>& expected)
+	{
+		const auto size = Vector2i(4, 4);
+		ASSERT_EQ(block.size(), TextureDescriptor::getByteSize(format, size));
+
+		const auto decoded = BlockCompression::decode(gsl::as_bytes(gsl::span<const uint8_t>(block.data(), block.size())), size, format);
+		const auto px = decoded->getPixelBytes();
+		for (int i = 0; i < 16; ++i) {
+			for (int c = 0; c < 4; ++c) {
+				EXPECT_EQ(int(px[i * 4 + c]), expected[i][c]) << "texel " << i << ", channel " << c;
+			}
+		}
+	}
+}
+
+TEST(HalleyBlockCompression, BC1)
+{
+	testRoundTrip(TextureFormat::BC1, false, 8);
+}
+
+TEST(HalleyBlockCompression, BC3)
+{
+	testRoundTrip(TextureFormat::BC3, true, 8);
+}
+
+TEST(HalleyBlockCompression, BC7)
+{
+	testRoundTrip(TextureFormat::BC7, true, 4);
+}
+
+TEST(HalleyBlockCompression, ETC2)
+{
+	testRoundTrip(TextureFormat::ETC2RGB, false, 12);
+	testRoundTrip(TextureFormat::ETC2RGBA, true, 12);
+}
+
+TEST(HalleyBlockCompression, ASTC)
+{
+	testRoundTrip(TextureFormat::ASTC4x4, false, 4);
+	testRoundTrip(TextureFormat::ASTC4x4, true, 12);
+}
+
+TEST(HalleyBlockCompression, MipChain)
+{
+	const auto size = Vector2i(64, 16);
+	const auto image = makeGradient(size, true);
+	const int levels = TextureDescriptor::getMaxMipLevels(size);
+	EXPECT_EQ(levels, 7);
+
+	size_t expected = 0;
+	for (int i = 0; i < levels; ++i) {
+		expected += TextureDescriptor::getByteSize(TextureFormat::BC7, TextureDescriptor::getMipSize(size, i));
+	}
+	EXPECT_EQ(BlockCompression::encode(image, TextureFormat::BC7, levels).size(), expected);
+
+	const auto mip = BlockCompression::makeMip(image);
+	EXPECT_EQ(mip->getSize(), Vector2i(32, 8));
+}
+
+TEST(HalleyBlockCompression, BC1Transparency)
+{
+	Image image(Image::Format::RGBA, Vector2i(4, 4));
+	image.clear(Image::convertRGBAToInt(255, 0, 0, 255));
+	image.getPixelBytes()[3] = 0;
+
+	const auto data = BlockCompression::encode(image, TextureFormat::BC1);
+	const auto decoded = BlockCompression::decode(data.byte_span(), image.getSize(), TextureFormat::BC1);
+	const auto px = decoded->getPixelBytes();
+	EXPECT_EQ(px[3], 0);
+	EXPECT_EQ(px[4], 255);
+	EXPECT_EQ(px[5], 0);
+	EXPECT_EQ(px[6], 0);
+	EXPECT_EQ(px[7], 255);
+}
+
+TEST(HalleyBlockCompression, BC1Reference)
+{
+	// Four colour mode (c0 > c1): red and blue endpoints, texel i uses index i % 4
+	testReferenceBlock(TextureFormat::BC1, {
+		0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4
+	}, {{
+		{ 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 },
+		{ 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 },
+		{ 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 },
+		{ 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 }
+	}});
+
+	// Three colour mode (c0 <= c1): odd texels use index 3, which is transparent black
+	testReferenceBlock(TextureFormat::BC1, {
+		0x1F, 0x00, 0x00, 0xF8, 0xCC, 0xCC, 0xCC, 0xCC
+	}, {{
+		{ 0, 0, 255, 255 }, { 0, 0, 0, 0 }, { 0, 0, 255, 255 }, { 0, 0, 0, 0 },
+		{ 0, 0, 255, 255 }, { 0, 0, 0, 0 }, { 0, 0, 255, 255 }, { 0, 0, 0, 0 },
+		{ 0, 0, 255, 255 }, { 0, 0, 0, 0 }, { 0, 0, 255, 255 }, { 0, 0, 0, 0 },
+		{ 0, 0, 255, 255 }, { 0, 0, 0, 0 }, { 0, 0, 255, 255 }, { 0, 0, 0, 0 }
+	}});
+}
+
+TEST(HalleyBlockCompression, BC3Reference)
+{
+	// Eight alpha mode (a0 > a1) with a0 = 224 and a1 = 0, so every interpolated alpha is exact. Texel i uses alpha index i % 8. The colour block is the four colour one from BC1Reference
+	testReferenceBlock(TextureFormat::BC3, {
+		0xE0, 0x00, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4
+	}, {{
+		{ 255, 0, 0, 224 }, { 0, 0, 255, 0 }, { 170, 0, 85, 192 }, { 85, 0, 170, 160 },
+		{ 255, 0, 0, 128 }, { 0, 0, 255, 96 }, { 170, 0, 85, 64 }, { 85, 0, 170, 32 },
+		{ 255, 0, 0, 224 }, { 0, 0, 255, 0 }, { 170, 0, 85, 192 }, { 85, 0, 170, 160 },
+		{ 255, 0, 0, 128 }, { 0, 0, 255, 96 }, { 170, 0, 85, 64 }, { 85, 0, 170, 32 }
+	}});
+}
+
+TEST(HalleyBlockCompression, BC7Reference)
+{
+	// Mode 6: endpoints 0 and 127 with p-bits 0 and 1, so the block spans 0 to 255 on every channel. Texel i uses index i
+	testReferenceBlock(TextureFormat::BC7, {
+		0x40, 0xC0, 0x1F, 0xF0, 0x07, 0xFC, 0x01, 0x7F, 0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE
+	}, {{
+		{ 0, 0, 0, 0 }, { 16, 16, 16, 16 }, { 36, 36, 36, 36 }, { 52, 52, 52, 52 },
+		{ 68, 68, 68, 68 }, { 84, 84, 84, 84 }, { 104, 104, 104, 104 }, { 120, 120, 120, 120 },
+		{ 135, 135, 135, 135 }, { 151, 151, 151, 151 }, { 171, 171, 171, 171 }, { 187, 187, 187, 187 },
+		{ 203, 203, 203, 203 }, { 219, 219, 219, 219 }, { 239, 239, 239, 239 }, { 255, 255, 255, 255 }
+	}});
+}
+
+TEST(HalleyBlockCompression, ETC2Reference)
+{
+	// Individual mode, not flipped: base colours 0x88 and 0x44 with table 0 (2, 8). Columns use modifiers +2, -2, +8 and -8
+	testReferenceBlock(TextureFormat::ETC2RGB, {
+		0x84, 0x84, 0x84, 0x00, 0xF0, 0xF0, 0xFF, 0x00
+	}, {{
+		{ 138, 138, 138, 255 }, { 134, 134, 134, 255 }, { 76, 76, 76, 255 }, { 60, 60, 60, 255 },
+		{ 138, 138, 138, 255 }, { 134, 134, 134, 255 }, { 76, 76, 76, 255 }, { 60, 60, 60, 255 },
+		{ 138, 138, 138, 255 }, { 134, 134, 134, 255 }, { 76, 76, 76, 255 }, { 60, 60, 60, 255 },
+		{ 138, 138, 138, 255 }, { 134, 134, 134, 255 }, { 76, 76, 76, 255 }, { 60, 60, 60, 255 }
+	}});
+
+	// EAC alpha with base 128, multiplier 2 and table 0. Texel j, counting down columns, uses index j % 8. Followed by the colour block above
+	testReferenceBlock(TextureFormat::ETC2RGBA, {
+		0x80, 0x20, 0x05, 0x39, 0x77, 0x05, 0x39, 0x77, 0x84, 0x84, 0x84, 0x00, 0xF0, 0xF0, 0xFF, 0x00
+	}, {{
+		{ 138, 138, 138, 122 }, { 134, 134, 134, 132 }, { 76, 76, 76, 122 }, { 60, 60, 60, 132 },
+		{ 138, 138, 138, 116 }, { 134, 134, 134, 138 }, { 76, 76, 76, 116 }, { 60, 60, 60, 138 },
+		{ 138, 138, 138, 110 }, { 134, 134, 134, 144 }, { 76, 76, 76, 110 }, { 60, 60, 60, 144 },
+		{ 138, 138, 138, 98 }, { 134, 134, 134, 156 }, { 76, 76, 76, 98 }, { 60, 60, 60, 156 }
+	}});
+}
+
+TEST(HalleyBlockCompression, ASTCReference)
+{
+	// Block mode 0x053 (4x4 weights in 0..7), one partition, LDR RGB direct endpoints (0, 0, 0) and (255, 128, 64). Texel i uses weight i % 8
+	testReferenceBlock(TextureFormat::ASTC4x4, {
+		0x53, 0x00, 0x01, 0xFE, 0x01, 0x00, 0x01, 0x80, 0x00, 0x00, 0x5F, 0x63, 0x11, 0x5F, 0x63, 0x11
+	}, {{
+		{ 0, 0, 0, 255 }, { 36, 18, 9, 255 }, { 72, 36, 18, 255 }, { 108, 54, 27, 255 },
+		{ 147, 74, 37, 255 }, { 183, 92, 46, 255 }, { 219, 110, 55, 255 }, { 255, 128, 64, 255 },
+		{ 0, 0, 0, 255 }, { 36, 18, 9, 255 }, { 72, 36, 18, 255 }, { 108, 54, 27, 255 },
+		{ 147, 74, 37, 255 }, { 183, 92, 46, 255 }, { 219, 110, 55, 255 }, { 255, 128, 64, 255 }
+	}});
+
+	// Block mode 0x042 (4x4 weights in 0..3), one partition, LDR RGBA direct endpoints (16, 32, 48, 255) and (240, 224, 208, 0). Texel i uses weight i % 4
+	testReferenceBlock(TextureFormat::ASTC4x4, {
+		0x42, 0x80, 0x21, 0xE0, 0x41, 0xC0, 0x61, 0xA0, 0xFF, 0x01, 0x00, 0x00, 0x27, 0x27, 0x27, 0x27
+	}, {{
+		{ 16, 32, 48, 255 }, { 89, 95, 100, 171 }, { 167, 161, 156, 84 }, { 240, 224, 208, 0 },
+		{ 16, 32, 48, 255 }, { 89, 95, 100, 171 }, { 167, 161, 156, 84 }, { 240, 224, 208, 0 },
+		{ 16, 32, 48, 255 }, { 89, 95, 100, 171 }, { 167, 161, 156, 84 }, { 240, 224, 208, 0 },
+		{ 16, 32, 48, 255 }, { 89, 95, 100, 171 }, { 167, 161, 156, 84 }, { 240, 224, 208, 0 }
+	}});
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+TEST(HalleyConcurrent, ForeachChunkFromBusyWorker)
+{
+	// The only worker is busy running the caller, so the helper foreachChunk queues can't start until it's done
+	ExecutionQueue queue;
+	ThreadPool pool("test", queue, 1, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+
+	std::atomic<size_t> total = 0;
+	Concurrent::execute(queue, [&] ()
+	{
+		Concurrent::foreachChunk(queue, 100, 7, [&] (size_t, size_t start, size_t end, size_t)
+		{
+			total += end - start;
+		});
+	}).wait();
+
+	EXPECT_EQ(total, 100);
+}
+
+TEST(HalleyConcurrent, ForeachChunkPropagatesExceptions)
+{
+	ExecutionQueue queue;
+	ThreadPool pool("test", queue, 2, [] (String name, std::function<void()> f) { return std::thread(std::move(f)); });
+
+	EXPECT_THROW(Concurrent::foreachChunk(queue, 100, 1, [&] (size_t chunk, size_t, size_t, size_t)
+	{
+		if (chunk == 50) {
+			throw Exception("test", HalleyExceptions::Concurrency);
+		}
+	}), Exception);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	// Mirrors the options EntityNetworkSession uses to encode entity snapshots
+	class SnapshotEncoding {
+	public:
+		SnapshotEncoding()
+		{
+			dictionary.addEntry("components");
+			dictionary.addEntry("children");
+			dictionary.addEntry("Transform2D");
+			dictionary.addEntry("position");
+
+			byteOptions.version = SerializerOptions::maxVersion;
+			byteOptions.dictionary = &dictionary;
+			deltaOptions.allowNonSerializable = false;
+		}
+
+		Bytes encode(const EntityData& from, const EntityData& to)
+		{
+			return Serializer::toBytes(EntityDataDelta(from, to, deltaOptions), byteOptions);
+		}
+
+		EntityData decode(const EntityData& from, const Bytes& bytes)
+		{
+			return EntityData::applyDelta(from, Deserializer::fromBytes<EntityDataDelta>(bytes, byteOptions));
+		}
+
+		SerializationDictionary dictionary;
+		SerializerOptions byteOptions;
+		EntityDataDelta::Options deltaOptions;
+	};
+
+	ConfigNode makeComponent(Vector2f position, int value)
+	{
+		ConfigNode::MapType result;
+		result["position"] = ConfigNode(position);
+		result["value"] = ConfigNode(value);
+		return result;
+	}
+
+	EntityData makeEntity(const UUID& uuid, const UUID& childUUID)
+	{
+		EntityData child(childUUID);
+		child.setName("child");
+		child.setComponents({ { "Transform2D", makeComponent(Vector2f(1, 2), 0) } });
+
+		EntityData result(uuid);
+		result.setName("entity");
+		result.setComponents({ { "Transform2D", makeComponent(Vector2f(10, 20), 1) }, { "Sprite", makeComponent(Vector2f(), 2) } });
+		result.setChildren({ std::move(child) });
+		return result;
+	}
+
+	void expectSameData(const EntityData& a, const EntityData& b)
+	{
+		EXPECT_EQ(a.toConfigNode(false), b.toConfigNode(false));
+	}
+}
+
+TEST(HalleyEntityData, SnapshotDeltaRoundTrip)
+{
+	SnapshotEncoding encoding;
+	const auto uuid = UUID::generate();
+	const auto childUUID = UUID::generate();
+	const auto baseline = makeEntity(uuid, childUUID);
+
+	auto target = makeEntity(uuid, childUUID);
+	target.setName("renamed");
+	target.updateComponent("Transform2D", makeComponent(Vector2f(11, 20), 1));
+	target.setComponents({ target.getComponents()[0] });
+	target.getChildren()[0].updateComponent("Transform2D", makeComponent(Vector2f(1, 3), 5));
+	target.getChildren().push_back(EntityData(UUID::generate()));
+
+	const auto bytes = encoding.encode(baseline, target);
+	expectSameData(encoding.decode(baseline, bytes), target);
+
+	// Peers on the same baseline share the encoded bytes, so encoding must be deterministic
+	EXPECT_EQ(encoding.encode(baseline, target), bytes);
+}
+
+TEST(HalleyEntityData, SnapshotDeltasChain)
+{
+	// A peer that received each revision in turn ends up in the same state as one that skipped straight to the latest
+	SnapshotEncoding encoding;
+	const auto uuid = UUID::generate();
+	const auto childUUID = UUID::generate();
+	const auto rev1 = makeEntity(uuid, childUUID);
+
+	auto rev2 = EntityData(rev1);
+	rev2.updateComponent("Transform2D", makeComponent(Vector2f(15, 25), 1));
+
+	auto rev3 = EntityData(rev2);
+	rev3.getChildren().clear();
+	rev3.updateComponent("Sprite", makeComponent(Vector2f(), 7));
+
+	const auto stepwise = encoding.decode(encoding.decode(rev1, encoding.encode(rev1, rev2)), encoding.encode(rev2, rev3));
+	const auto direct = encoding.decode(rev1, encoding.encode(rev1, rev3));
+	expectSameData(stepwise, rev3);
+	expectSameData(direct, rev3);
+}
+
+TEST(HalleyEntityData, UnchangedSnapshotHasNoDelta)
+{
+	SnapshotEncoding encoding;
+	const auto snapshot = makeEntity(UUID::generate(), UUID::generate());
+	EXPECT_FALSE(EntityDataDelta(snapshot, EntityData(snapshot), encoding.deltaOptions).hasChange());
+}
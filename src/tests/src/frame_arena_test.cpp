@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	// Each thread has its own arena, so running on a new thread starts from an empty one
+	template <typename F>
+	void runOnFreshArena(F f)
+	{
+		std::thread(std::move(f)).join();
+	}
+}
+
+TEST(HalleyFrameArena, ReleasedMemoryIsReused)
+{
+	runOnFreshArena([] ()
+	{
+		auto* a = FrameArena::alloc(100, 16);
+		auto* b = FrameArena::alloc(100, 16);
+		FrameArena::free(b, 100);
+		FrameArena::free(a, 100);
+
+		// Everything was released, so the arena starts over from the same place
+		EXPECT_EQ(FrameArena::alloc(100, 16), a);
+		FrameArena::free(a, 100);
+		EXPECT_EQ(FrameArena::getReservedBytes(), 64 * 1024);
+	});
+}
+
+TEST(HalleyFrameArena, LastAllocationIsReclaimed)
+{
+	runOnFreshArena([] ()
+	{
+		auto* a = FrameArena::alloc(32, 8);
+		auto* b = FrameArena::alloc(32, 8);
+		FrameArena::free(b, 32);
+		EXPECT_EQ(FrameArena::alloc(32, 8), b);
+		FrameArena::free(b, 32);
+		FrameArena::free(a, 32);
+	});
+}
+
+TEST(HalleyFrameArena, Alignment)
+{
+	runOnFreshArena([] ()
+	{
+		Vector<std::pair<void*, size_t>> ptrs;
+		for (size_t alignment: { 1, 64, 2, 16, 4096, 8 }) {
+			auto* p = FrameArena::alloc(3, alignment);
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0);
+			ptrs.emplace_back(p, 3);
+		}
+		for (auto& [p, size]: ptrs) {
+			FrameArena::free(p, size);
+		}
+	});
+}
+
+TEST(HalleyFrameArena, BlocksAreMergedOnRewind)
+{
+	runOnFreshArena([] ()
+	{
+		constexpr size_t size = 100 * 1024;
+		Vector<void*> ptrs;
+		for (int i = 0; i < 3; ++i) {
+			ptrs.push_back(FrameArena::alloc(size, 16));
+			memset(ptrs.back(), i, size);
+		}
+		const auto reserved = FrameArena::getReservedBytes();
+		EXPECT_GE(reserved, 3 * size);
+		for (auto* p: ptrs) {
+			FrameArena::free(p, size);
+		}
+
+		// The rewound arena is a single block, so the same allocations fit without growing it
+		ptrs.clear();
+		for (int i = 0; i < 3; ++i) {
+			ptrs.push_back(FrameArena::alloc(size, 16));
+		}
+		EXPECT_EQ(FrameArena::getReservedBytes(), reserved);
+		EXPECT_EQ(static_cast<char*>(ptrs[1]) - static_cast<char*>(ptrs[0]), ptrdiff_t(size));
+		for (auto* p: ptrs) {
+			FrameArena::free(p, size);
+		}
+	});
+}
+
+TEST(HalleyFrameArena, EndFrameReleasesUnusedMemory)
+{
+	runOnFreshArena([] ()
+	{
+		constexpr size_t size = 1024 * 1024;
+		FrameArena::free(FrameArena::alloc(size, 16), size);
+		EXPECT_GE(FrameArena::getReservedBytes(), size);
+
+		// The frame that needed the memory keeps it
+		FrameArena::endFrame();
+		FrameArena::free(FrameArena::alloc(16, 16), 16);
+		EXPECT_GE(FrameArena::getReservedBytes(), size);
+
+		// A frame that didn't need it gives it back
+		FrameArena::endFrame();
+		FrameArena::free(FrameArena::alloc(16, 16), 16);
+		EXPECT_LT(FrameArena::getReservedBytes(), size);
+	});
+}
+
+TEST(HalleyFrameArena, Containers)
+{
+	runOnFreshArena([] ()
+	{
+		{
+			FrameVector<int> values;
+			FrameHashMap<int, int> map;
+			for (int i = 0; i < 1000; ++i) {
+				values.push_back(i);
+				map[i] = i * 2;
+			}
+			for (int i = 0; i < 1000; ++i) {
+				EXPECT_EQ(values[i], i);
+				EXPECT_EQ(map.at(i), i * 2);
+			}
+		}
+
+		// Once the containers are gone the arena is empty again, and the next allocation starts over
+		const auto reserved = FrameArena::getReservedBytes();
+		FrameVector<int> values;
+		values.resize(10);
+		EXPECT_EQ(FrameArena::getReservedBytes(), reserved);
+	});
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "halley/file_formats/hlif_file.h"
+using namespace Halley;
+
+namespace {
+	void testRoundTrip(const Image& image)
+	{
+		const auto encoded = HLIFFile::encode(image);
+		const auto info = HLIFFile::getInfo(encoded.byte_span());
+		EXPECT_EQ(image.getSize(), info.size);
+		EXPECT_EQ(image.getFormat(), info.format);
+
+		Image decoded;
+		HLIFFile::decode(decoded, encoded.byte_span());
+		ASSERT_EQ(image.getSize(), decoded.getSize());
+		EXPECT_EQ(image.getFormat(), decoded.getFormat());
+
+		// Compare row by row, the buffers are padded past the last row
+		const auto size = image.getSize();
+		for (int y = 0; y < size.y; ++y) {
+			const auto a = image.getPixelBytesRow(0, size.x, y);
+			const auto b = decoded.getPixelBytesRow(0, size.x, y);
+			ASSERT_TRUE(std::equal(a.begin(), a.end(), b.begin())) << "Mismatch at row " << y;
+		}
+	}
+}
+
+TEST(HLIF, RoundTripRGBA)
+{
+	// Tall enough to be split into several bands
+	Image image(Image::Format::RGBA, Vector2i(300, 517));
+	auto px = image.getPixelBytes().subspan(0, 300 * 517 * 4);
+	for (size_t i = 0; i < px.size(); ++i) {
+		px[i] = uint8_t((i * 7) ^ (i >> 9));
+	}
+	testRoundTrip(image);
+}
+
+TEST(HLIF, RoundTripPaletted)
+{
+	// Few colours, so it gets palette encoded
+	Image image(Image::Format::RGBAPremultiplied, Vector2i(257, 300));
+	auto px = image.getPixels4BPP();
+	for (size_t i = 0; i < px.size(); ++i) {
+		px[i] = int(Image::convertRGBAToInt(uint8_t(i % 13 * 19), uint8_t(i / 257 % 7 * 30), 40, 255));
+	}
+	testRoundTrip(image);
+}
+
+TEST(HLIF, RoundTripSingleChannel)
+{
+	Image image(Image::Format::SingleChannel, Vector2i(1000, 333));
+	auto px = image.getPixels1BPP();
+	for (size_t i = 0; i < px.size(); ++i) {
+		px[i] = uint8_t(i % 1000 / 4 + i / 1000);
+	}
+	testRoundTrip(image);
+}
+
+TEST(HLIF, RejectsTruncatedData)
+{
+	Image image(Image::Format::RGBA, Vector2i(64, 64));
+	const auto encoded = HLIFFile::encode(image);
+	Image decoded;
+	EXPECT_THROW(HLIFFile::decode(decoded, encoded.byte_span().subspan(0, encoded.size() - 1)), Exception);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include "halley/tools/assets/import_cache.h"
+#include "halley/tools/file/filesystem.h"
+using namespace Halley;
+
+namespace {
+	Bytes toBytes(const String& str)
+	{
+		Bytes result(str.size());
+		memcpy(result.data(), str.c_str(), str.size());
+		return result;
+	}
+
+	ImportingAsset makeAsset(const String& contents, int quality = 1)
+	{
+		Metadata meta;
+		meta.set("quality", quality);
+
+		ImportingAsset asset;
+		asset.assetId = "test";
+		asset.assetType = ImportAssetType::SimpleCopy;
+		asset.inputFiles.emplace_back(Path("test.txt"), toBytes(contents), meta);
+		return asset;
+	}
+
+	AssetResource makeResource()
+	{
+		AssetResource result;
+		result.name = "test";
+		result.type = AssetType::TextFile;
+		result.platformVersions["pc"].filepath = "test.txt";
+		result.primaryInputFile = Path("test.txt");
+		return result;
+	}
+
+	// A scratch directory with two checkouts of the same sources, as if on two different machines
+	class HalleyImportCache : public testing::Test {
+	protected:
+		ScopedTemporaryFile root;
+		Path cacheDir;
+		Path srcA;
+		Path srcB;
+
+		void SetUp() override
+		{
+			cacheDir = root.getPath() / "cache";
+			srcA = root.getPath() / "a" / "assets_src";
+			srcB = root.getPath() / "b" / "assets_src";
+			FileSystem::createDir(cacheDir);
+			writeInput("shared.txt", "shared");
+		}
+
+		void writeInput(const Path& path, const String& contents)
+		{
+			for (const auto& src: { srcA, srcB }) {
+				FileSystem::createParentDir(src / path);
+				FileSystem::writeFile(src / path, contents);
+			}
+		}
+
+		ImportCache makeCache() const
+		{
+			return ImportCache(cacheDir, 1, { "pc" });
+		}
+	};
+}
+
+TEST_F(HalleyImportCache, KeyDependsOnInputs)
+{
+	const auto cache = makeCache();
+	const auto key = cache.getKey(makeAsset("hello"));
+
+	EXPECT_EQ(ImportCache(root.getPath() / "elsewhere", 1, { "pc" }).getKey(makeAsset("hello")), key);
+	EXPECT_NE(cache.getKey(makeAsset("hellp")), key);
+	EXPECT_NE(cache.getKey(makeAsset("hello", 2)), key);
+	EXPECT_NE(ImportCache(cacheDir, 2, { "pc" }).getKey(makeAsset("hello")), key);
+	EXPECT_NE(ImportCache(cacheDir, 1, { "pc", "switch" }).getKey(makeAsset("hello")), key);
+}
+
+TEST_F(HalleyImportCache, StoredEntriesAreFetched)
+{
+	const auto cache = makeCache();
+	const auto key = cache.getKey(makeAsset("hello"));
+	Vector<TimestampedPath> inputs;
+	EXPECT_FALSE(cache.tryGet(key, { srcA }, inputs).has_value());
+
+	const Vector<std::pair<Path, std::optional<Bytes>>> outFiles = { { Path("text/test.txt"), toBytes("hello") } };
+	const Vector<TimestampedPath> additionalInputs = { { srcA / "shared.txt", 0 } };
+	ASSERT_TRUE(cache.store(key, { makeResource() }, outFiles, additionalInputs, { srcA }));
+
+	// Fetched from the other checkout, with the additional inputs resolved against it
+	const auto entry = cache.tryGet(key, { srcB }, inputs);
+	ASSERT_TRUE(entry.has_value());
+	ASSERT_EQ(entry->out.size(), 1);
+	EXPECT_EQ(entry->out[0].name, "test");
+	EXPECT_EQ(entry->out[0].platformVersions.at("pc").filepath, "test.txt");
+	ASSERT_EQ(entry->outFiles.size(), 1);
+	EXPECT_EQ(entry->outFiles[0].first, Path("text/test.txt"));
+	EXPECT_EQ(entry->outFiles[0].second, toBytes("hello"));
+	ASSERT_EQ(inputs.size(), 1);
+	EXPECT_EQ(inputs[0].first, srcB / "shared.txt");
+}
+
+TEST_F(HalleyImportCache, ChangedAdditionalInputMisses)
+{
+	const auto cache = makeCache();
+	const auto key = cache.getKey(makeAsset("hello"));
+	ASSERT_TRUE(cache.store(key, { makeResource() }, {}, { { srcA / "shared.txt", 0 } }, { srcA }));
+
+	Vector<TimestampedPath> inputs;
+	EXPECT_TRUE(cache.tryGet(key, { srcA }, inputs).has_value());
+
+	FileSystem::writeFile(srcA / "shared.txt", String("changed"));
+	EXPECT_FALSE(cache.tryGet(key, { srcA }, inputs).has_value());
+	EXPECT_TRUE(cache.tryGet(key, { srcB }, inputs).has_value());
+
+	FileSystem::remove(srcB / "shared.txt");
+	EXPECT_FALSE(cache.tryGet(key, { srcB }, inputs).has_value());
+}
+
+TEST_F(HalleyImportCache, UncacheableResultsAreRejected)
+{
+	const auto cache = makeCache();
+	const auto key = cache.getKey(makeAsset("hello"));
+
+	// Files written by the importer itself
+	EXPECT_FALSE(cache.store(key, { makeResource() }, { { Path("text/test.txt"), std::nullopt } }, {}, { srcA }));
+
+	// Inputs from outside the source directories
+	FileSystem::writeFile(root.getPath() / "outside.txt", String("outside"));
+	EXPECT_FALSE(cache.store(key, { makeResource() }, {}, { { root.getPath() / "outside.txt", 0 } }, { srcA }));
+
+	Vector<TimestampedPath> inputs;
+	EXPECT_FALSE(cache.tryGet(key, { srcA }, inputs).has_value());
+}
+
+TEST_F(HalleyImportCache, CorruptEntriesAreIgnored)
+{
+	const auto cache = makeCache();
+	const auto key = cache.getKey(makeAsset("hello"));
+	ASSERT_TRUE(cache.store(key, { makeResource() }, {}, {}, { srcA }));
+
+	for (const auto& file: FileSystem::enumerateDirectory(cacheDir)) {
+		FileSystem::writeFile(cacheDir / file, String("garbage"));
+	}
+
+	Vector<TimestampedPath> inputs;
+	EXPECT_FALSE(cache.tryGet(key, { srcA }, inputs).has_value());
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	// Lands in the largest size class, which nothing else in the tests allocates from
+	constexpr size_t testSize = 4000;
+
+	Vector<void*> allocMany(SizePool& pool, size_t n)
+	{
+		Vector<void*> result;
+		for (size_t i = 0; i < n; ++i) {
+			result.push_back(pool.alloc());
+			memset(result.back(), int(i), pool.getSize());
+		}
+		return result;
+	}
+
+	void freeAll(SizePool& pool, const Vector<void*>& ptrs)
+	{
+		for (auto* p: ptrs) {
+			pool.free(p);
+		}
+	}
+}
+
+TEST(HalleyMemoryPool, SizeClasses)
+{
+	EXPECT_EQ(PoolPool::getPool(1)->getSize(), 16);
+	EXPECT_EQ(PoolPool::getPool(17)->getSize(), 32);
+	EXPECT_EQ(PoolPool::getPool(20), PoolPool::getPool(32));
+	EXPECT_NE(PoolPool::getPool(32), PoolPool::getPool(33));
+
+	for (size_t size = 1; size <= 4096; ++size) {
+		const auto poolSize = PoolPool::getPool(size)->getSize();
+		EXPECT_GE(poolSize, size);
+		EXPECT_LE(poolSize, size + std::max(size_t(15), size / 4));
+	}
+
+	// Oversized allocations get a pool of their own
+	auto* big = PoolPool::getPool(10000);
+	EXPECT_EQ(big->getSize(), 10000);
+	auto* p = big->alloc();
+	memset(p, 1, 10000);
+	big->free(p);
+}
+
+TEST(HalleyMemoryPool, FreedMemoryIsReused)
+{
+	auto& pool = *PoolPool::getPool(48);
+
+	auto ptrs = allocMany(pool, 1000);
+	std::sort(ptrs.begin(), ptrs.end());
+	EXPECT_EQ(std::unique(ptrs.begin(), ptrs.end()), ptrs.end());
+	for (auto* p: ptrs) {
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0);
+	}
+
+	void* last = ptrs.back();
+	freeAll(pool, ptrs);
+	EXPECT_EQ(pool.alloc(), last);
+	pool.free(last);
+}
+
+TEST(HalleyMemoryPool, StatsTrackLiveBytes)
+{
+	// Live counts are batched per thread and flushed when the thread exits, so the stats are read after joining
+	auto& pool = *PoolPool::getPool(testSize);
+	const auto before = pool.getStats();
+
+	Vector<void*> ptrs;
+	std::thread([&] () { ptrs = allocMany(pool, 100); }).join();
+	const auto during = pool.getStats();
+	EXPECT_EQ(during.liveBytes, before.liveBytes + 100 * pool.getSize());
+	EXPECT_GE(during.peakLiveBytes, during.liveBytes);
+	EXPECT_GE(during.reservedBytes, during.liveBytes);
+
+	std::thread([&] () { freeAll(pool, ptrs); }).join();
+	const auto after = pool.getStats();
+	EXPECT_EQ(after.liveBytes, before.liveBytes);
+	EXPECT_EQ(after.peakLiveBytes, during.peakLiveBytes);
+	EXPECT_GT(after.getFragmentation(), during.getFragmentation());
+}
+
+TEST(HalleyMemoryPool, CrossThreadFreesAreReused)
+{
+	auto& pool = *PoolPool::getPool(testSize);
+	constexpr size_t n = 150;
+
+	size_t reservedFirst = 0;
+	size_t reservedSecond = 0;
+	std::thread([&] ()
+	{
+		auto ptrs = allocMany(pool, n);
+		reservedFirst = pool.getStats().reservedBytes;
+
+		// Freed from another thread while this one is still alive, so they're handed back to this thread's cache
+		std::thread([&] () { freeAll(pool, ptrs); }).join();
+
+		ptrs = allocMany(pool, n);
+		reservedSecond = pool.getStats().reservedBytes;
+		freeAll(pool, ptrs);
+	}).join();
+
+	// Only the rest of the current slab is used up before the freed objects are taken back
+	EXPECT_LE(reservedSecond, reservedFirst + 64 * 1024);
+}
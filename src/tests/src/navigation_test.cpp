@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	// Two 10x10 squares side by side, connected through x = 10
+	std::shared_ptr<NavmeshSet> makeTwoSquares()
+	{
+		Vector<Navmesh::PolygonData> polys;
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(0, 0), 10, 10), { -1, 1, -1, -1 }, 1.0f });
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(10, 0), 10, 10), { -1, -1, -1, 0 }, 1.0f });
+		const auto bounds = NavmeshBounds(Vector2f(0, 0), Vector2f(20, 0), Vector2f(0, 10), 1, 1, Vector2f(1, 1));
+
+		auto set = std::make_shared<NavmeshSet>();
+		set->add(Navmesh(std::move(polys), bounds, 0));
+		set->linkNavmeshes();
+		return set;
+	}
+
+	// Same squares as a single navmesh, with a grid spanning side0 along x
+	Navmesh makeTwoSquaresNavmesh(Vector2f side0)
+	{
+		Vector<Navmesh::PolygonData> polys;
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(0, 0), 10, 10), { -1, 1, -1, -1 }, 1.0f });
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(10, 0), 10, 10), { -1, -1, -1, 0 }, 1.0f });
+		const auto bounds = NavmeshBounds(Vector2f(0, 0), side0, Vector2f(0, 10), 1, 1, Vector2f(1, 1));
+		return Navmesh(std::move(polys), bounds, 0);
+	}
+
+	// Same squares, with region portals on the far left and far right edges
+	Navmesh makeTwoSquaresWithPortals()
+	{
+		Vector<Navmesh::PolygonData> polys;
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(0, 0), 10, 10), { -1, 1, -1, -8 }, 1.0f });
+		polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(10, 0), 10, 10), { -1, -9, -1, 0 }, 1.0f });
+		const auto bounds = NavmeshBounds(Vector2f(0, 0), Vector2f(20, 0), Vector2f(0, 10), 1, 1, Vector2f(1, 1));
+		return Navmesh(std::move(polys), bounds, 0);
+	}
+
+	// n 10x10 squares in a row, each one its own region, linked through region portals on their shared edges
+	std::shared_ptr<NavmeshSet> makeRegionStrip(int n, Vector2f scaleFactor)
+	{
+		auto set = std::make_shared<NavmeshSet>();
+		for (int i = 0; i < n; ++i) {
+			const auto origin = Vector2f(float(i * 10), 0);
+			Vector<Navmesh::PolygonData> polys;
+			polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(origin, 10, 10), { -1, i < n - 1 ? -8 : -1, -1, i > 0 ? -9 : -1 }, 1.0f });
+			const auto bounds = NavmeshBounds(origin, Vector2f(10, 0), Vector2f(0, 10), 1, 1, scaleFactor);
+			set->add(Navmesh(std::move(polys), bounds, 0));
+		}
+		set->linkNavmeshes();
+		return set;
+	}
+
+	struct TestState {
+		int value = 0;
+	};
+}
+
+TEST(HalleyNavigation, SearchStateResetsBetweenSearches)
+{
+	SearchStateArray<TestState> state;
+	state.startSearch(4);
+	state[0].value = 1;
+	state[3].value = 2;
+	EXPECT_EQ(state[0].value, 1);
+
+	state.startSearch(8);
+	EXPECT_EQ(state[0].value, 0);
+	EXPECT_EQ(state[3].value, 0);
+	EXPECT_EQ(state[7].value, 0);
+}
+
+TEST(HalleyNavigation, ServiceBatch)
+{
+	PathfindingService service(makeTwoSquares());
+
+	Vector<PathfindingService::Request> requests;
+	requests.emplace_back(NavigationQuery(WorldPosition(Vector2f(2, 5), 0), WorldPosition(Vector2f(18, 5), 0), NavigationQuery::PostProcessingType::None));
+	requests.emplace_back(NavigationQuery(WorldPosition(Vector2f(2, 5), 0), WorldPosition(Vector2f(18, 5), 1), NavigationQuery::PostProcessingType::None));
+	auto results = service.pathfind(std::move(requests)).get();
+
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results[0].id, 0);
+	ASSERT_TRUE(results[0].path.has_value());
+	EXPECT_EQ(results[0].path->path.front(), Vector2f(2, 5));
+	EXPECT_EQ(results[0].path->path.back(), Vector2f(18, 5));
+
+	EXPECT_EQ(results[1].id, 1);
+	EXPECT_FALSE(results[1].path.has_value());
+	EXPECT_FALSE(results[1].error.isEmpty());
+}
+
+TEST(HalleyNavigation, ServiceQueue)
+{
+	PathfindingService service(makeTwoSquares(), 1);
+
+	const auto a = service.request(NavigationQuery(WorldPosition(Vector2f(2, 5), 0), WorldPosition(Vector2f(18, 5), 0), NavigationQuery::PostProcessingType::None));
+	const auto b = service.request(NavigationQuery(WorldPosition(Vector2f(18, 2), 0), WorldPosition(Vector2f(3, 8), 0), NavigationQuery::PostProcessingType::None));
+	EXPECT_EQ(service.getNumQueued(), 2);
+
+	service.flush();
+	service.wait();
+	EXPECT_EQ(service.getNumQueued(), 0);
+	EXPECT_EQ(service.getNumInFlight(), 0);
+
+	Vector<PathfindingService::Result> results;
+	ASSERT_EQ(service.collectResults(results), 2);
+	std::sort(results.begin(), results.end(), [] (const auto& x, const auto& y) { return x.id < y.id; });
+	EXPECT_EQ(results[0].id, a);
+	EXPECT_EQ(results[1].id, b);
+	EXPECT_TRUE(results[0].path.has_value());
+	EXPECT_TRUE(results[1].path.has_value());
+
+	EXPECT_EQ(service.collectResults(results), 0);
+}
+
+TEST(HalleyNavigation, PortalCosts)
+{
+	auto navmesh = makeTwoSquaresWithPortals();
+	ASSERT_EQ(navmesh.getPortals().size(), 2);
+	EXPECT_FALSE(navmesh.hasPortalCosts());
+
+	navmesh.computePortalCosts();
+	ASSERT_TRUE(navmesh.hasPortalCosts());
+	EXPECT_NEAR(navmesh.getPortalCost(0, 1), 20.0f, 0.01f);
+	EXPECT_NEAR(navmesh.getPortalCost(1, 0), 20.0f, 0.01f);
+
+	const auto fromPoint = navmesh.getPortalCostsFrom(Vector2f(2, 5));
+	ASSERT_EQ(fromPoint.size(), 2);
+	EXPECT_NEAR(fromPoint[0], 8.0f, 0.01f);
+	EXPECT_NEAR(fromPoint[1], 18.0f, 0.01f);
+}
+
+TEST(HalleyNavigation, RegionPath)
+{
+	// Costs are scaled down here, which the region search heuristic needs to account for
+	const auto navmeshSet = makeRegionStrip(3, Vector2f(0.25f, 0.25f));
+
+	const auto path = navmeshSet->pathfind(NavigationQuery(WorldPosition(Vector2f(2, 5), 0), WorldPosition(Vector2f(28, 5), 0), NavigationQuery::PostProcessingType::None));
+	ASSERT_TRUE(path.has_value());
+	ASSERT_EQ(path->regions.size(), 3);
+	EXPECT_EQ(path->regions[0].regionNodeId, 0);
+	EXPECT_EQ(path->regions[1].regionNodeId, 1);
+	EXPECT_EQ(path->regions[2].regionNodeId, 2);
+}
+
+TEST(HalleyNavigation, FlowField)
+{
+	const auto navmeshSet = makeTwoSquares();
+	const auto goal = WorldPosition(Vector2f(18, 5), 0);
+
+	NavigationFlowFieldCache cache;
+	const auto field = cache.getFlowField(*navmeshSet, goal);
+	ASSERT_TRUE(field != nullptr);
+	ASSERT_TRUE(field->isValid());
+	EXPECT_EQ(cache.getFlowField(*navmeshSet, WorldPosition(Vector2f(17, 5), 0)), field);
+
+	// Crosses into the right square through the shared edge
+	const auto next = field->getNextPosition(*navmeshSet, WorldPosition(Vector2f(2, 5), 0));
+	ASSERT_TRUE(next.has_value());
+	EXPECT_NEAR(next->x, 10.0f, 0.01f);
+	EXPECT_NEAR(next->y, 5.0f, 0.01f);
+
+	// Goes straight to the goal once in its polygon
+	EXPECT_EQ(field->getNextPosition(*navmeshSet, WorldPosition(Vector2f(12, 3), 0)), goal.pos);
+	EXPECT_LT(field->getCost(*navmeshSet, WorldPosition(Vector2f(12, 3), 0)).value(), field->getCost(*navmeshSet, WorldPosition(Vector2f(2, 5), 0)).value());
+	EXPECT_FALSE(field->getNextPosition(*navmeshSet, WorldPosition(Vector2f(2, 5), 1)).has_value());
+
+	NavigationPathFollower follower;
+	follower.setFlowField(field);
+	EXPECT_FALSE(follower.isDone());
+	follower.update(WorldPosition(Vector2f(2, 5), 0), *navmeshSet, 0.5f);
+	EXPECT_NEAR(follower.getNextPosition().x, 10.0f, 0.01f);
+	follower.update(goal, *navmeshSet, 0.5f);
+	EXPECT_TRUE(follower.isDone());
+}
+
+TEST(HalleyNavigation, FlowFieldAcrossRegions)
+{
+	const auto navmeshSet = makeRegionStrip(3, Vector2f(1, 1));
+	const auto goal = WorldPosition(Vector2f(28, 5), 0);
+
+	const auto field = std::make_shared<NavigationFlowField>(*navmeshSet, goal);
+	ASSERT_TRUE(field->isValid());
+	EXPECT_EQ(field->getRegionId(), 2);
+
+	// Regions away from the goal lead just past the portal into the next one
+	EXPECT_EQ(field->getRegionAt(*navmeshSet, WorldPosition(Vector2f(2, 5), 0)), 0);
+	const auto next = field->getNextPosition(*navmeshSet, WorldPosition(Vector2f(2, 5), 0));
+	ASSERT_TRUE(next.has_value());
+	EXPECT_GT(next->x, 10.0f);
+	EXPECT_LT(next->x, 10.5f);
+	EXPECT_NEAR(next->y, 5.0f, 0.01f);
+	EXPECT_GT(field->getCost(*navmeshSet, WorldPosition(Vector2f(2, 5), 0)).value(), field->getCost(*navmeshSet, WorldPosition(Vector2f(15, 5), 0)).value());
+	EXPECT_GT(field->getCost(*navmeshSet, WorldPosition(Vector2f(15, 5), 0)).value(), field->getCost(*navmeshSet, WorldPosition(Vector2f(25, 5), 0)).value());
+
+	// Agents outside of the goal's region follow the field too, instead of pathing on their own
+	NavigationPathFollower follower;
+	follower.setFlowField(field);
+	follower.update(WorldPosition(Vector2f(2, 5), 0), *navmeshSet, 0.5f);
+	EXPECT_FALSE(follower.getPath().has_value());
+	EXPECT_EQ(follower.getCurrentRegionId(), 0);
+	EXPECT_GT(follower.getNextPosition().x, 10.0f);
+
+	follower.update(WorldPosition(Vector2f(12, 5), 0), *navmeshSet, 0.5f);
+	EXPECT_EQ(follower.getCurrentRegionId(), 1);
+	EXPECT_GT(follower.getNextPosition().x, 20.0f);
+}
+
+TEST(HalleyNavigation, ClosestPointOutsideNavmesh)
+{
+	// 30x30 grid of unit squares, with a 10x10 hole in the middle
+	constexpr int n = 30;
+	auto isHole = [] (int x, int y) { return x >= 10 && x < 20 && y >= 10 && y < 20; };
+
+	Vector<int> polyIdx(n * n, -1);
+	int nPolys = 0;
+	for (int i = 0; i < n * n; ++i) {
+		if (!isHole(i % n, i / n)) {
+			polyIdx[i] = nPolys++;
+		}
+	}
+	auto getConnection = [&] (int x, int y) { return x < 0 || y < 0 || x >= n || y >= n ? -1 : polyIdx[x + y * n]; };
+
+	Vector<Navmesh::PolygonData> polys;
+	for (int y = 0; y < n; ++y) {
+		for (int x = 0; x < n; ++x) {
+			if (!isHole(x, y)) {
+				polys.push_back(Navmesh::PolygonData{ Polygon::makePolygon(Vector2f(x, y), 1, 1), { getConnection(x, y - 1), getConnection(x + 1, y), getConnection(x, y + 1), getConnection(x - 1, y) }, 1.0f });
+			}
+		}
+	}
+
+	const auto bounds = NavmeshBounds(Vector2f(0, 0), Vector2f(n, 0), Vector2f(0, n), 1, 1, Vector2f(1, 1));
+	const auto navmesh = Navmesh(std::move(polys), bounds, 0);
+
+	Random rng(1234u);
+	for (int i = 0; i < 200; ++i) {
+		const auto pos = Vector2f(rng.getFloat(-10.0f, 40.0f), rng.getFloat(-10.0f, 40.0f));
+
+		// Brute force reference
+		std::optional<Vector2f> expected;
+		float bestDist = std::numeric_limits<float>::infinity();
+		if (navmesh.containsPoint(pos)) {
+			expected = pos;
+		} else {
+			for (const auto& poly: navmesh.getPolygons()) {
+				const auto p = poly.getClosestPoint(pos);
+				if ((p - pos).length() < bestDist) {
+					bestDist = (p - pos).length();
+					expected = p;
+				}
+			}
+		}
+
+		const auto result = navmesh.getClosestPointTo(pos);
+		ASSERT_TRUE(result.has_value());
+		EXPECT_NEAR((*result - pos).length(), (*expected - pos).length(), 0.001f);
+	}
+
+	// Just outside of the outer edge and inside the hole
+	EXPECT_TRUE(navmesh.getNodeAt(Vector2f(-1, 5)).has_value());
+	EXPECT_TRUE(navmesh.getNodeAt(Vector2f(11, 15)).has_value());
+	EXPECT_FALSE(navmesh.getNodeAt(Vector2f(-10, 5)).has_value());
+}
+
+TEST(HalleyNavigation, ClosestPointFarAway)
+{
+	const auto navmesh = makeTwoSquaresNavmesh(Vector2f(20, 0));
+
+	const auto right = navmesh.getClosestPointTo(Vector2f(1.0e9f, 5.0f));
+	ASSERT_TRUE(right.has_value());
+	EXPECT_NEAR(right->x, 20.0f, 0.001f);
+	EXPECT_NEAR(right->y, 5.0f, 0.001f);
+
+	const auto corner = navmesh.getClosestPointTo(Vector2f(-1.0e9f, -1.0e9f));
+	ASSERT_TRUE(corner.has_value());
+	EXPECT_NEAR(corner->x, 0.0f, 0.001f);
+	EXPECT_NEAR(corner->y, 0.0f, 0.001f);
+}
+
+TEST(HalleyNavigation, ClosestPointOutsideGrid)
+{
+	// The grid only covers the first square, so the second one sticks out of it
+	const auto navmesh = makeTwoSquaresNavmesh(Vector2f(10, 0));
+
+	const auto result = navmesh.getClosestPointTo(Vector2f(25, 5));
+	ASSERT_TRUE(result.has_value());
+	EXPECT_NEAR(result->x, 20.0f, 0.001f);
+	EXPECT_NEAR(result->y, 5.0f, 0.001f);
+}
+
+TEST(HalleyNavigation, SerializeKeepsEdgeQueries)
+{
+	const auto navmesh = makeTwoSquaresNavmesh(Vector2f(20, 0));
+	const auto bytes = Serializer::toBytes(navmesh, SerializerOptions(SerializerOptions::maxVersion));
+	const auto loaded = Deserializer::fromBytes<Navmesh>(bytes, SerializerOptions(SerializerOptions::maxVersion));
+
+	for (const auto pos: { Vector2f(-5, 5), Vector2f(25, 5), Vector2f(10, -3), Vector2f(30, 30) }) {
+		const auto expected = navmesh.getClosestPointTo(pos);
+		const auto result = loaded.getClosestPointTo(pos);
+		ASSERT_TRUE(expected.has_value());
+		ASSERT_TRUE(result.has_value());
+		EXPECT_NEAR((*result - *expected).length(), 0.0f, 0.001f);
+	}
+}
+
+TEST(HalleyNavigation, RegenerateCells)
+{
+	Vector<Polygon> obstacles;
+	obstacles.push_back(Polygon::makePolygon(Vector2f(10, 10), 10, 10));
+
+	NavmeshGenerator::Params params{ NavmeshBounds(Vector2f(0, 0), Vector2f(100, 0), Vector2f(0, 100), 4, 4, Vector2f(1, 1)) };
+	params.obstacles = obstacles;
+	params.agentSize = 2.0f;
+
+	NavmeshGenerator::CellCache cache;
+	const auto initial = NavmeshGenerator::generate(params, cache);
+	EXPECT_FALSE(cache.isEmpty());
+	EXPECT_EQ(cache.getNumCellsGenerated(), 16);
+
+	// Add an obstacle far from the first one, and only redo the cells it overlaps
+	obstacles.push_back(Polygon::makePolygon(Vector2f(70, 70), 10, 10));
+	params.obstacles = obstacles;
+	const auto regenerated = NavmeshGenerator::regenerate(params, cache, gsl::span<const Polygon>(&obstacles.back(), 1));
+	EXPECT_GT(cache.getNumCellsGenerated(), 0);
+	EXPECT_LT(cache.getNumCellsGenerated(), 16);
+	const auto full = NavmeshGenerator::generate(params);
+
+	auto getArea = [] (const NavmeshSet& set)
+	{
+		float area = 0;
+		for (const auto& navmesh: set.getNavmeshes()) {
+			area += navmesh.getArea();
+		}
+		return area;
+	};
+	auto getNumPolygons = [] (const NavmeshSet& set)
+	{
+		size_t n = 0;
+		for (const auto& navmesh: set.getNavmeshes()) {
+			n += navmesh.getPolygons().size();
+		}
+		return n;
+	};
+
+	EXPECT_LT(getArea(regenerated), getArea(initial));
+	EXPECT_EQ(regenerated.getNavmeshes().size(), full.getNavmeshes().size());
+	EXPECT_EQ(getNumPolygons(regenerated), getNumPolygons(full));
+	EXPECT_NEAR(getArea(regenerated), getArea(full), 0.01f);
+}
@@ -54,3 +54,11 @@ TEST(HalleyPath, IsAbsolute)
 	EXPECT_EQ(Path("foo").isAbsolute(), false);
 	EXPECT_EQ(Path("foo/bar").isAbsolute(), false);
 }
+
+TEST(HalleyPath, IsPrefixOf)
+{
+	EXPECT_TRUE(Path("/foo/bar").isPrefixOf(Path("/foo/bar/baz.txt")));
+	EXPECT_TRUE(Path("foo").isPrefixOf(Path("foo/bar")));
+	EXPECT_FALSE(Path("/foo/bar").isPrefixOf(Path("/foo/baz/bar.txt")));
+	EXPECT_FALSE(Path("/foo/bar/baz").isPrefixOf(Path("/foo/bar")));
+}
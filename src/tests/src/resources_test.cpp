@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+#include <thread>
+using namespace Halley;
+
+namespace {
+	// Text files served by a custom loader, so no locator or packs are needed
+	struct TestResources {
+		HalleyAPI api{};
+		Resources resources;
+		std::atomic<int> loads = 0;
+
+		TestResources()
+			: resources({}, api, ResourceOptions())
+		{
+			resources.init<TextFile>();
+		}
+
+		void setLoader(std::function<std::shared_ptr<Resource>(std::string_view)> loader)
+		{
+			resources.of<TextFile>().setResourceLoader([this, loader = std::move(loader)] (std::string_view name, ResourceLoadPriority)
+			{
+				++loads;
+				return loader(name);
+			});
+		}
+	};
+}
+
+TEST(HalleyResources, ConcurrentGetsLoadOnce)
+{
+	TestResources t;
+	t.setLoader([] (std::string_view name)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		return std::make_shared<TextFile>(String(name));
+	});
+
+	Vector<std::shared_ptr<const TextFile>> results(4);
+	Vector<std::thread> threads;
+	for (size_t i = 0; i < results.size(); ++i) {
+		threads.emplace_back([&t, &results, i] ()
+		{
+			results[i] = t.resources.get<TextFile>("shared");
+		});
+	}
+	for (auto& thread: threads) {
+		thread.join();
+	}
+
+	EXPECT_EQ(t.loads, 1);
+	for (const auto& result: results) {
+		ASSERT_NE(result, nullptr);
+		EXPECT_EQ(result, results[0]);
+		EXPECT_EQ(result->getData(), "shared");
+	}
+}
+
+TEST(HalleyResources, LoadingOtherAssetsFromLoader)
+{
+	TestResources t;
+	t.setLoader([&] (std::string_view name) -> std::shared_ptr<Resource>
+	{
+		if (name == "outer") {
+			const auto inner = t.resources.get<TextFile>("inner");
+			return std::make_shared<TextFile>(String("outer+") + inner->getData());
+		}
+		return std::make_shared<TextFile>(String(name));
+	});
+
+	EXPECT_EQ(t.resources.get<TextFile>("outer")->getData(), "outer+inner");
+	EXPECT_EQ(t.loads, 2);
+}
+
+TEST(HalleyResources, RecursiveLoadThrows)
+{
+	TestResources t;
+	t.setLoader([&] (std::string_view name)
+	{
+		return std::make_shared<TextFile>(t.resources.get<TextFile>(name)->getData());
+	});
+	EXPECT_THROW(static_cast<void>(t.resources.get<TextFile>("loop")), Exception);
+
+	// The failed load doesn't linger, so the asset can still be loaded afterwards
+	t.setLoader([] (std::string_view name)
+	{
+		return std::make_shared<TextFile>(String(name));
+	});
+	EXPECT_EQ(t.resources.get<TextFile>("loop")->getData(), "loop");
+}
+
+TEST(HalleyResources, FailedLoadIsRetried)
+{
+	TestResources t;
+	t.setLoader([&] (std::string_view name) -> std::shared_ptr<Resource>
+	{
+		if (t.loads == 1) {
+			throw Exception("Failed to load", HalleyExceptions::Resources);
+		}
+		return std::make_shared<TextFile>(String(name));
+	});
+
+	EXPECT_THROW(static_cast<void>(t.resources.get<TextFile>("flaky")), Exception);
+	EXPECT_EQ(t.resources.get<TextFile>("flaky")->getData(), "flaky");
+	EXPECT_EQ(t.resources.get<TextFile>("flaky")->getData(), "flaky");
+	EXPECT_EQ(t.loads, 2);
+}
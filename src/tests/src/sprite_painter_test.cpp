@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	SpritePainterEntry makeEntry(size_t idx, int layer, float tieBreaker)
+	{
+		return SpritePainterEntry(SpritePainterEntryType::Callback, idx, 1, 1, layer, tieBreaker, idx, {});
+	}
+
+	Vector<SpritePainterEntry> makeRandomEntries(size_t n, uint32_t seed)
+	{
+		// Few distinct values, so there are plenty of ties that must keep insertion order
+		const std::array<int, 5> layers = { std::numeric_limits<int>::min(), -3, 0, 2, std::numeric_limits<int>::max() };
+		const std::array<float, 7> tieBreakers = { -std::numeric_limits<float>::infinity(), -100.5f, -0.25f, -0.0f, 0.0f, 0.25f, 1e20f };
+
+		Random rng(seed);
+		Vector<SpritePainterEntry> result;
+		for (size_t i = 0; i < n; ++i) {
+			result.push_back(makeEntry(i, layers[rng.getSizeT(0, layers.size() - 1)], tieBreakers[rng.getSizeT(0, tieBreakers.size() - 1)]));
+		}
+		return result;
+	}
+
+	Vector<uint32_t> getIndices(const Vector<SpritePainterEntry>& entries)
+	{
+		Vector<uint32_t> result;
+		for (const auto& e: entries) {
+			result.push_back(e.getIndex());
+		}
+		return result;
+	}
+}
+
+TEST(HalleySpritePainter, SortKeyMatchesOrdering)
+{
+	const auto entries = makeRandomEntries(200, 1);
+	for (const auto& a: entries) {
+		for (const auto& b: entries) {
+			if (a.getSortKey() < b.getSortKey()) {
+				EXPECT_TRUE(a < b);
+			} else if (a.getSortKey() > b.getSortKey()) {
+				EXPECT_TRUE(b < a);
+			}
+		}
+	}
+
+	EXPECT_EQ(makeEntry(0, 0, -0.0f).getSortKey(), makeEntry(1, 0, 0.0f).getSortKey());
+	EXPECT_LT(makeEntry(0, -1, 1e20f).getSortKey(), makeEntry(1, 0, -1e20f).getSortKey());
+}
+
+TEST(HalleySpritePainter, RadixSortMatchesStableSort)
+{
+	Vector<SpritePainterEntry> valuesScratch;
+	Vector<uint64_t> keys;
+	Vector<uint64_t> keysScratch;
+
+	// Scratch buffers are reused across sorts of different sizes
+	for (const size_t n: { 1000, 64, 3000 }) {
+		auto entries = makeRandomEntries(n, uint32_t(n));
+		auto expected = entries;
+		std::stable_sort(expected.begin(), expected.end());
+
+		keys.clear();
+		for (const auto& e: entries) {
+			keys.push_back(e.getSortKey());
+		}
+		radixSortStable(entries, keys, valuesScratch, keysScratch);
+
+		EXPECT_EQ(getIndices(entries), getIndices(expected));
+		for (size_t i = 0; i < n; ++i) {
+			EXPECT_EQ(keys[i], entries[i].getSortKey());
+		}
+	}
+}
+
+TEST(HalleySpritePainter, RadixSortKeepsSortedInput)
+{
+	Vector<int> values = { 1, 2, 3, 4 };
+	Vector<uint64_t> keys = { 5, 5, 7, 0xFF00000000000000ull };
+	Vector<int> valuesScratch;
+	Vector<uint64_t> keysScratch;
+
+	radixSortStable(values, keys, valuesScratch, keysScratch);
+	EXPECT_EQ(values, Vector<int>({ 1, 2, 3, 4 }));
+	EXPECT_TRUE(valuesScratch.empty());
+
+	keys = { 0xFF00000000000000ull, 5, 7, 5 };
+	radixSortStable(values, keys, valuesScratch, keysScratch);
+	EXPECT_EQ(values, Vector<int>({ 2, 4, 3, 1 }));
+	EXPECT_EQ(keys, Vector<uint64_t>({ 5, 5, 7, 0xFF00000000000000ull }));
+}
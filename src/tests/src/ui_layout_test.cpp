@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	struct TestLayout {
+		std::shared_ptr<UIWidget> root;
+		std::shared_ptr<UIWidget> top;
+		std::shared_ptr<UIWidget> bottom;
+		std::shared_ptr<UIWidget> inner;
+
+		TestLayout()
+		{
+			root = std::make_shared<UIWidget>("root", Vector2f(), UISizer(UISizerType::Vertical, 0));
+			top = std::make_shared<UIWidget>("top", Vector2f(100, 20), UISizer(UISizerType::Vertical, 0));
+			bottom = std::make_shared<UIWidget>("bottom", Vector2f(100, 30), UISizer(UISizerType::Vertical, 0));
+			inner = std::make_shared<UIWidget>("inner", Vector2f(50, 10));
+
+			bottom->add(inner);
+			root->add(top);
+			root->add(bottom);
+			root->forceAddChildren(UIInputType::Mouse, true);
+			root->layout();
+		}
+	};
+}
+
+TEST(HalleyUILayout, InitialLayout)
+{
+	TestLayout l;
+	EXPECT_EQ(l.root->getSize(), Vector2f(100, 50));
+	EXPECT_EQ(l.top->getRect(), Rect4f(0, 0, 100, 20));
+	EXPECT_EQ(l.bottom->getRect(), Rect4f(0, 20, 100, 30));
+	EXPECT_EQ(l.inner->getRect(), Rect4f(0, 20, 100, 10));
+	EXPECT_FALSE(l.root->hasPendingLayout());
+}
+
+TEST(HalleyUILayout, MinSizeChangePropagates)
+{
+	TestLayout l;
+	l.top->setMinSize(Vector2f(100, 40));
+	EXPECT_TRUE(l.root->hasPendingLayout());
+
+	l.root->layout();
+	EXPECT_EQ(l.root->getSize(), Vector2f(100, 70));
+	EXPECT_EQ(l.bottom->getRect(), Rect4f(0, 40, 100, 30));
+	EXPECT_EQ(l.inner->getRect(), Rect4f(0, 40, 100, 10));
+	EXPECT_FALSE(l.root->hasPendingLayout());
+	EXPECT_FALSE(l.bottom->hasPendingLayout());
+}
+
+TEST(HalleyUILayout, MovedChildIsPlacedAgain)
+{
+	TestLayout l;
+	l.bottom->setPosition(Vector2f(5, 5));
+	EXPECT_TRUE(l.root->hasPendingLayout());
+
+	l.root->layout();
+	EXPECT_EQ(l.bottom->getRect(), Rect4f(0, 20, 100, 30));
+	EXPECT_EQ(l.inner->getRect(), Rect4f(0, 20, 100, 10));
+}
+
+TEST(HalleyUILayout, HiddenChildFreesSpace)
+{
+	TestLayout l;
+	l.top->setActive(false);
+	l.root->layout();
+	EXPECT_EQ(l.bottom->getRect(), Rect4f(0, 0, 100, 30));
+	EXPECT_EQ(l.inner->getRect(), Rect4f(0, 0, 100, 10));
+}
+
+namespace {
+	class CountingWidget : public UIWidget {
+	public:
+		CountingWidget(String id, Vector2f minSize)
+			: UIWidget(std::move(id), minSize)
+		{}
+
+		int layoutCount = 0;
+
+	protected:
+		void onLayout() override
+		{
+			++layoutCount;
+		}
+	};
+
+	struct CountingLayout {
+		std::shared_ptr<UIWidget> root;
+		std::shared_ptr<UIWidget> left;
+		std::shared_ptr<UIWidget> right;
+		std::shared_ptr<CountingWidget> leftLeaf;
+		std::shared_ptr<CountingWidget> rightLeaf;
+
+		CountingLayout()
+		{
+			root = std::make_shared<UIWidget>("root", Vector2f(), UISizer(UISizerType::Horizontal, 0));
+			left = std::make_shared<UIWidget>("left", Vector2f(50, 50));
+			right = std::make_shared<UIWidget>("right", Vector2f(50, 50));
+			leftLeaf = std::make_shared<CountingWidget>("leftLeaf", Vector2f(10, 10));
+			rightLeaf = std::make_shared<CountingWidget>("rightLeaf", Vector2f(10, 10));
+
+			left->add(leftLeaf);
+			right->add(rightLeaf);
+			root->add(left);
+			root->add(right);
+			root->forceAddChildren(UIInputType::Mouse, true);
+			root->layout();
+
+			leftLeaf->layoutCount = 0;
+			rightLeaf->layoutCount = 0;
+		}
+	};
+}
+
+TEST(HalleyUILayout, CleanLayoutDoesNoWork)
+{
+	CountingLayout l;
+	l.root->layout();
+	EXPECT_EQ(l.leftLeaf->layoutCount, 0);
+	EXPECT_EQ(l.rightLeaf->layoutCount, 0);
+}
+
+TEST(HalleyUILayout, OnlyDirtySubtreeIsLaidOut)
+{
+	CountingLayout l;
+	l.leftLeaf->setPosition(Vector2f(5, 5));
+	EXPECT_TRUE(l.root->hasPendingLayout());
+	EXPECT_TRUE(l.left->hasPendingLayout());
+	EXPECT_FALSE(l.right->hasPendingLayout());
+
+	l.root->layout();
+	EXPECT_EQ(l.leftLeaf->layoutCount, 1);
+	EXPECT_EQ(l.rightLeaf->layoutCount, 0);
+	EXPECT_EQ(l.left->getRect(), Rect4f(0, 0, 50, 50));
+	EXPECT_EQ(l.right->getRect(), Rect4f(50, 0, 50, 50));
+	EXPECT_FALSE(l.root->hasPendingLayout());
+}
+
+TEST(HalleyUILayout, ResizedLeafLeavesSiblingAlone)
+{
+	CountingLayout l;
+	l.leftLeaf->setMinSize(Vector2f(20, 20));
+	l.root->layout();
+	EXPECT_EQ(l.leftLeaf->layoutCount, 1);
+	EXPECT_EQ(l.rightLeaf->layoutCount, 0);
+}
@@ -0,0 +1,368 @@
+#include <gtest/gtest.h>
+#include <halley.hpp>
+using namespace Halley;
+
+namespace {
+	class TestCoreAPI : public CoreAPI {
+	public:
+		void quit(int exitCode) override {}
+		void setStage(StageID stage) override {}
+		void setStage(std::unique_ptr<Stage> stage) override {}
+		void initStage(Stage& stage) override {}
+		Stage& getCurrentStage() override { throw Exception("No stage in tests", HalleyExceptions::Core); }
+
+		HalleyStatics& getStatics() override { throw Exception("No statics in tests", HalleyExceptions::Core); }
+		const Environment& getEnvironment() override { throw Exception("No environment in tests", HalleyExceptions::Core); }
+
+		void addProfilerCallback(IProfileCallback* callback) override {}
+		void removeProfilerCallback(IProfileCallback* callback) override {}
+		void addStartFrameCallback(IStartFrameCallback* callback) override {}
+		void removeStartFrameCallback(IStartFrameCallback* callback) override {}
+
+		Future<std::unique_ptr<RenderSnapshot>> requestRenderSnapshot() override { throw Exception("No rendering in tests", HalleyExceptions::Core); }
+
+		bool isDevMode() override { return false; }
+		DevConClient* getDevConClient() const override { return nullptr; }
+	};
+
+	// Indices past the standard components, which the engine looks up by index (e.g. Transform2D)
+	class TestValueComponent final : public Component {
+	public:
+		static constexpr int componentIndex{ 16 };
+		static const constexpr char* componentName{ "TestValue" };
+
+		int value = 0;
+
+		TestValueComponent() {}
+		TestValueComponent(int value) : value(value) {}
+	};
+
+	class TestTagComponent final : public Component {
+	public:
+		static constexpr int componentIndex{ 17 };
+		static const constexpr char* componentName{ "TestTag" };
+	};
+
+	class ValueFamily : public FamilyBaseOf<ValueFamily> {
+	public:
+		TestValueComponent& value;
+
+		using Type = FamilyType<TestValueComponent>;
+
+	protected:
+		ValueFamily(TestValueComponent& value) : value(value) {}
+	};
+
+	class TaggedValueFamily : public FamilyBaseOf<TaggedValueFamily> {
+	public:
+		TestValueComponent& value;
+		const TestTagComponent& tag;
+
+		using Type = FamilyType<TestValueComponent, TestTagComponent>;
+
+	protected:
+		TaggedValueFamily(TestValueComponent& value, const TestTagComponent& tag) : value(value), tag(tag) {}
+	};
+
+	template <typename T>
+	class TestFamilyBinding : public FamilyBinding<T> {
+	public:
+		TestFamilyBinding(Family& family)
+		{
+			this->setFamily(&family);
+		}
+
+		void setOnAdded(std::function<void(T&)> callback)
+		{
+			this->setOnEntitiesAdded([callback = std::move(callback)] (void* entities, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i) {
+					callback(static_cast<T*>(entities)[i]);
+				}
+			});
+		}
+	};
+
+	class TestMessage final : public Message {
+	public:
+		static constexpr int messageIndex{ 0 };
+
+		int value = 0;
+
+		TestMessage() {}
+		TestMessage(int value) : value(value) {}
+
+		size_t getSize() const override { return sizeof(TestMessage); }
+		int getId() const override { return messageIndex; }
+	};
+
+	class SenderSystem final : public System {
+	public:
+		SenderSystem() : System({}, {}) {}
+
+		Vector<std::pair<EntityId, int>> toSend;
+
+	protected:
+		void updateBase(Time) override
+		{
+			for (const auto& [id, value]: toSend) {
+				sendMessageGeneric(id, TestMessage(value));
+			}
+			toSend.clear();
+		}
+	};
+
+	class ReceiverSystem final : public System {
+	public:
+		ReceiverSystem() : System({ &tagged }, { TestMessage::messageIndex }) {}
+
+		Vector<std::pair<EntityId, int>> received;
+
+	protected:
+		void processMessages() override
+		{
+			doProcessMessages(tagged, std::array<int, 1>{ TestMessage::messageIndex });
+		}
+
+		void onMessagesReceived(int msgIndex, Message** msgs, size_t* idx, size_t n, FamilyBindingBase& family) override
+		{
+			for (size_t i = 0; i < n; ++i) {
+				received.emplace_back(tagged[idx[i]].entityId, static_cast<TestMessage*>(msgs[i])->value);
+			}
+		}
+
+	private:
+		FamilyBinding<TaggedValueFamily> tagged;
+	};
+
+	// A world with no systems, services or resources, for testing entity and family bookkeeping
+	struct TestWorld {
+		TestCoreAPI core;
+		HalleyAPI api;
+		Resources resources;
+		World world;
+
+		TestWorld()
+			: api(makeAPI(core))
+			, resources({}, api, ResourceOptions())
+			, world(api, resources, WorldReflection())
+		{}
+
+		static HalleyAPI makeAPI(CoreAPI& core)
+		{
+			HalleyAPI result{};
+			result.core = &core;
+			return result;
+		}
+	};
+}
+
+TEST(HalleyWorld, ComponentChangesUpdateFamilies)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+	auto& tagged = t.world.getFamily<TaggedValueFamily>();
+
+	auto e = t.world.createEntity("e").addComponent(TestValueComponent(1));
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 1);
+	EXPECT_EQ(tagged.count(), 0);
+
+	e.addComponent(TestTagComponent());
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 1);
+	EXPECT_EQ(tagged.count(), 1);
+
+	e.removeComponent<TestValueComponent>();
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 0);
+	EXPECT_EQ(tagged.count(), 0);
+}
+
+TEST(HalleyWorld, CleanEntitiesAreLeftAlone)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+
+	auto a = t.world.createEntity("a").addComponent(TestValueComponent(1));
+	auto b = t.world.createEntity("b").addComponent(TestValueComponent(2));
+	t.world.spawnPending();
+	ASSERT_EQ(values.count(), 2);
+
+	// Only b changes, so a keeps its slot and component
+	b.addComponent(TestTagComponent());
+	const auto aIdx = values.tryGetIndex(a.getEntityId());
+	t.world.spawnPending();
+	EXPECT_EQ(values.tryGetIndex(a.getEntityId()), aIdx);
+	EXPECT_EQ(static_cast<ValueFamily*>(values.getElement(*aIdx))->value.value, 1);
+}
+
+TEST(HalleyWorld, DisablingParentRemovesChildren)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+
+	auto parent = t.world.createEntity("parent").addComponent(TestValueComponent(1));
+	t.world.createEntity("child", parent).addComponent(TestValueComponent(2));
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 2);
+
+	parent.setEnabled(false);
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 0);
+
+	parent.setEnabled(true);
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 2);
+}
+
+TEST(HalleyWorld, DestroyedEntitiesLeaveFamilies)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+
+	auto a = t.world.createEntity("a").addComponent(TestValueComponent(1));
+	t.world.createEntity("b").addComponent(TestValueComponent(2));
+	auto c = t.world.createEntity("c").addComponent(TestValueComponent(3));
+	t.world.spawnPending();
+	EXPECT_EQ(t.world.numEntities(), 3);
+
+	const auto aId = a.getEntityId();
+	const auto cId = c.getEntityId();
+	t.world.destroyEntity(a);
+	t.world.spawnPending();
+	EXPECT_EQ(t.world.numEntities(), 2);
+	EXPECT_EQ(values.count(), 2);
+	EXPECT_FALSE(values.tryGetIndex(aId).has_value());
+	EXPECT_TRUE(t.world.tryGetEntity(cId).isValid());
+	EXPECT_EQ(t.world.getEntity(cId).getComponent<TestValueComponent>().value, 3);
+}
+
+TEST(HalleyWorld, EntitiesDirtiedDuringUpdateStayQueued)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+	auto& tagged = t.world.getFamily<TaggedValueFamily>();
+
+	auto other = t.world.createEntity("other").addComponent(TestValueComponent(0));
+	t.world.spawnPending();
+	const auto otherId = other.getEntityId();
+
+	// Joining the family tags another entity, which marks it dirty in the middle of the update
+	TestFamilyBinding<ValueFamily> binding(values);
+	binding.setOnAdded([&] (ValueFamily& e)
+	{
+		if (e.entityId != otherId) {
+			t.world.getEntity(otherId).addComponent(TestTagComponent());
+		}
+	});
+
+	t.world.createEntity("trigger").addComponent(TestValueComponent(1));
+	t.world.spawnPending();
+	EXPECT_EQ(values.count(), 2);
+
+	t.world.spawnPending();
+	ASSERT_EQ(tagged.count(), 1);
+	EXPECT_EQ(static_cast<TaggedValueFamily*>(tagged.getElement(0))->entityId, otherId);
+}
+
+TEST(HalleyWorld, FamilyIndexFollowsRemovals)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+
+	// Enough entities to span several index pages
+	Vector<EntityId> ids;
+	for (int i = 0; i < 2500; ++i) {
+		ids.push_back(t.world.createEntity().addComponent(TestValueComponent(i)).getEntityId());
+	}
+	t.world.spawnPending();
+	ASSERT_EQ(values.count(), ids.size());
+
+	for (size_t i = 0; i < ids.size(); i += 3) {
+		t.world.destroyEntity(ids[i]);
+	}
+	t.world.spawnPending();
+
+	for (size_t i = 0; i < ids.size(); ++i) {
+		const auto idx = values.tryGetIndex(ids[i]);
+		if (i % 3 == 0) {
+			EXPECT_FALSE(idx.has_value());
+		} else {
+			ASSERT_TRUE(idx.has_value());
+			auto& elem = *static_cast<ValueFamily*>(values.getElement(*idx));
+			EXPECT_EQ(elem.entityId, ids[i]);
+			EXPECT_EQ(elem.value.value, int(i));
+		}
+	}
+}
+
+TEST(HalleyWorld, StableFamilyKeepsInsertionOrder)
+{
+	TestWorld t;
+	auto& values = t.world.getFamily<ValueFamily>();
+	values.setStableOrder(true);
+
+	Vector<EntityId> ids;
+	for (int i = 0; i < 10; ++i) {
+		ids.push_back(t.world.createEntity().addComponent(TestValueComponent(i)).getEntityId());
+	}
+	t.world.spawnPending();
+
+	t.world.destroyEntity(ids[0]);
+	t.world.destroyEntity(ids[4]);
+	t.world.spawnPending();
+	ASSERT_EQ(values.count(), 8);
+
+	int last = -1;
+	for (size_t i = 0; i < values.count(); ++i) {
+		auto& elem = *static_cast<ValueFamily*>(values.getElement(i));
+		EXPECT_GT(elem.value.value, last);
+		EXPECT_EQ(values.tryGetIndex(elem.entityId), i);
+		last = elem.value.value;
+	}
+}
+
+TEST(HalleyWorld, MessagesReachFamilyMembersOnce)
+{
+	TestWorld t;
+	auto& sender = static_cast<SenderSystem&>(t.world.addSystem(std::make_unique<SenderSystem>(), TimeLine::FixedUpdate));
+	auto& receiver = static_cast<ReceiverSystem&>(t.world.addSystem(std::make_unique<ReceiverSystem>(), TimeLine::FixedUpdate));
+
+	const auto a = t.world.createEntity("a").addComponent(TestValueComponent(1)).addComponent(TestTagComponent()).getEntityId();
+	const auto b = t.world.createEntity("b").addComponent(TestValueComponent(2)).getEntityId();
+	const auto c = t.world.createEntity("c").addComponent(TestValueComponent(3)).addComponent(TestTagComponent()).getEntityId();
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+
+	// b isn't in the receiver's family, so its message is never seen
+	sender.toSend = { { a, 10 }, { b, 20 }, { c, 30 }, { a, 11 } };
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+	EXPECT_EQ(receiver.received, (Vector<std::pair<EntityId, int>>{ { a, 10 }, { c, 30 }, { a, 11 } }));
+
+	// The sender purges its messages at the start of its next update
+	receiver.received.clear();
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+	EXPECT_TRUE(receiver.received.empty());
+	const auto* queue = t.world.tryGetEntityMessageQueue(TestMessage::messageIndex);
+	EXPECT_TRUE(!queue || queue->empty());
+}
+
+TEST(HalleyWorld, MessagesReachEarlierSystemsNextStep)
+{
+	TestWorld t;
+	auto& receiver = static_cast<ReceiverSystem&>(t.world.addSystem(std::make_unique<ReceiverSystem>(), TimeLine::FixedUpdate));
+	auto& sender = static_cast<SenderSystem&>(t.world.addSystem(std::make_unique<SenderSystem>(), TimeLine::FixedUpdate));
+
+	const auto a = t.world.createEntity("a").addComponent(TestValueComponent(1)).addComponent(TestTagComponent()).getEntityId();
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+
+	sender.toSend = { { a, 10 } };
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+	EXPECT_TRUE(receiver.received.empty());
+
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+	EXPECT_EQ(receiver.received, (Vector<std::pair<EntityId, int>>{ { a, 10 } }));
+
+	t.world.step(TimeLine::FixedUpdate, 0.1);
+	EXPECT_EQ(receiver.received.size(), 1);
+}
@@ -96,7 +96,7 @@ void EditorRootStage::onRender(RenderContext& context) const
 			halleyLogo.clone().setPos(Vector2f(getVideoAPI().getWindow().getDefinition().getSize() / 2)).draw(painter);
 		}
 
-		Sprite::draw(backgroundParticles.getSprites(), painter);
+		backgroundParticles.draw(painter);
 
 		// UI
 		spritePainter.draw(1, painter);
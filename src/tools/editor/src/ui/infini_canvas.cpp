@@ -12,6 +12,7 @@ void InfiniCanvas::setScrollPosition(Vector2f pos)
 	auto newPos = (pos * zoom).round() / zoom;
 	if (scrollPos != newPos) {
 		scrollPos = newPos;
+		markLayoutDirty();
 		onNewScrollPosition(scrollPos);
 	}
 }
@@ -36,6 +37,11 @@ Vector2f InfiniCanvas::getLayoutMinimumSize(bool force) const
 	return getMinimumSize();
 }
 
+bool InfiniCanvas::childrenAffectLayoutSize() const
+{
+	return false;
+}
+
 void InfiniCanvas::drawChildren(UIPainter& painter) const
 {
 	auto p = painter.withClip(getRect());
@@ -14,6 +14,7 @@ namespace Halley {
 
 	protected:
 		Vector2f getLayoutMinimumSize(bool force) const override;
+		bool childrenAffectLayoutSize() const override;
 		void drawChildren(UIPainter& painter) const override;
 
     private:
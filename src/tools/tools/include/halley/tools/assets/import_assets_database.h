@@ -6,11 +6,13 @@
 #include <cstdint>
 #include <utility>
 #include "asset_importer.h"
+#include "import_cache.h"
 #include "halley/resources/asset_database.h"
 
 namespace Halley
 {
 	class FileSystemCache;
+	class ImportCache;
 	class Project;
 	class Deserializer;
 	class Serializer;
@@ -137,6 +139,10 @@ namespace Halley
 
 		void setPlatforms(Vector<String> platforms);
 
+		// Shared content-addressed cache of import results, see ImportCache
+		void setImportCacheDirectory(std::optional<Path> directory);
+		std::shared_ptr<const ImportCache> getImportCache() const;
+
 	private:
 		Vector<String> platforms;
 		Path directory;
@@ -151,6 +157,9 @@ namespace Halley
 
 		mutable std::map<std::pair<AssetType, String>, const AssetEntry*> assetIndex;
 		mutable bool indexDirty = true;
+
+		std::optional<Path> importCacheDirectory;
+		std::shared_ptr<const ImportCache> importCache;
 	
 		mutable std::mutex mutex;
 
@@ -19,6 +19,7 @@ namespace Halley
 			Vector<std::pair<Path, std::optional<Bytes>>> outFiles;
 			Vector<TimestampedPath> additionalInputs;
 			bool success = false;
+			bool fromCache = false;
 			String errorMsg;
 		};
 		using MetadataFetchCallback = std::function<std::optional<Metadata>(const Path&)>;
@@ -31,6 +32,7 @@ namespace Halley
 	private:
 		ImportAssetsDatabase& db;
 		std::shared_ptr<AssetImporter> importer;
+		std::shared_ptr<const ImportCache> importCache;
 		Path assetsPath;
 		Project& project;
 		const bool packAfter;
@@ -41,6 +43,7 @@ namespace Halley
 		
 		std::atomic<int64_t> totalImportTime;
 		std::atomic<size_t> assetsImported{};
+		std::atomic<size_t> assetsFromCache{};
 		size_t assetsToImport{};
 
 		std::mutex mutex;
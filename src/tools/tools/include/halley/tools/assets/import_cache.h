@@ -0,0 +1,60 @@
+#pragma once
+#include "halley/file/path.h"
+#include "halley/data_structures/vector.h"
+#include "halley/text/halleystring.h"
+#include "halley/plugin/iasset_importer.h"
+#include <cstdint>
+#include <optional>
+
+namespace Halley
+{
+	class Serializer;
+	class Deserializer;
+
+	// Content-addressed store of import results, shareable between machines (e.g. a directory on a network drive)
+	// Entries are keyed by a hash of the input bytes, their metadata, the importer version and the target platforms, so anything that was
+	// imported before with identical inputs can be fetched instead of reimported, regardless of file timestamps.
+	class ImportCache
+	{
+	public:
+		class Entry
+		{
+		public:
+			struct AdditionalInput
+			{
+				int srcIdx = 0; // Index into the importer's asset source directories, so entries don't depend on where the project is checked out
+				Path path;
+				uint64_t hash = 0;
+
+				void serialize(Serializer& s) const;
+				void deserialize(Deserializer& s);
+			};
+
+			Vector<AssetResource> out;
+			Vector<std::pair<Path, Bytes>> outFiles;
+			Vector<AdditionalInput> additionalInputs;
+
+			void serialize(Serializer& s) const;
+			void deserialize(Deserializer& s);
+		};
+
+		ImportCache(Path directory, int version, Vector<String> platforms);
+
+		const Path& getDirectory() const;
+
+		uint64_t getKey(const ImportingAsset& asset) const;
+
+		// Returns the entry only if every additional file the importer read is still identical
+		std::optional<Entry> tryGet(uint64_t key, const Vector<Path>& assetsSrc, Vector<TimestampedPath>& additionalInputs) const;
+
+		// Returns false if the result can't be cached, e.g. the importer wrote files directly or read files outside of assetsSrc
+		bool store(uint64_t key, const Vector<AssetResource>& out, const Vector<std::pair<Path, std::optional<Bytes>>>& outFiles, const Vector<TimestampedPath>& additionalInputs, const Vector<Path>& assetsSrc) const;
+
+	private:
+		Path directory;
+		int version;
+		Vector<String> platforms;
+
+		Path getEntryPath(uint64_t key) const;
+	};
+}
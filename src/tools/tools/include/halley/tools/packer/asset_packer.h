@@ -4,6 +4,7 @@
 #include "halley/resources/resource.h"
 #include "halley/resources/asset_database.h"
 #include "halley/data_structures/maybe.h"
+#include "halley/support/logger.h"
 #include <set>
 
 namespace Halley {
@@ -51,8 +52,10 @@ namespace Halley {
 		static void packPlatform(Project& project, std::optional<std::set<String>> assetsToPack, const Vector<String>& deletedAssets, const String& platform, ProgressCallback progress, Vector<String>& packed);
 
 	private:
+		using LogMessages = Vector<std::pair<LoggerLevel, String>>;
+
 		static std::map<String, AssetPackListing> sortIntoPacks(const AssetPackManifest& manifest, const AssetDatabase& srcAssetDb, std::optional<std::set<String>> assetsToPack, const Vector<String>& deletedAssets);
 		static void generatePacks(Project& project, std::map<String, AssetPackListing> packs, const Path& src, const Path& dst, ProgressCallback progress, Vector<String>& packed);
-		static void generatePack(Project& project, const String& packId, const AssetPackListing& pack, const Path& src, const Path& dst, ProgressCallback progress);
+		static void generatePack(Project& project, const String& packId, const AssetPackListing& pack, const Path& src, const Path& dst, ProgressCallback progress, LogMessages& log);
 	};
 }
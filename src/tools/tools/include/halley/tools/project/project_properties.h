@@ -30,6 +30,10 @@ namespace Halley {
     	void setDefaultZoom(float zoom);
 		float getDefaultZoom() const;
 
+    	// Directory for the shared import cache, empty to disable it. Relative paths are relative to the project root.
+    	const String& getImportCachePath() const;
+    	void setImportCachePath(String path);
+
 	private:
 		const Path& propertiesFile;
     	UUID uuid;
@@ -38,6 +42,7 @@ namespace Halley {
         String binName;
     	bool importByExtension = false;
     	float defaultZoom = 1.0f;
+    	String importCachePath;
     	Vector<String> platforms;
 
     	bool dirty = false;
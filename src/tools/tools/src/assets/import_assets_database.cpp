@@ -615,9 +615,23 @@ void ImportAssetsDatabase::setPlatforms(Vector<String> platforms)
 	if (platforms != this->platforms) {
 		this->platforms = std::move(platforms);
 		load();
+		setImportCacheDirectory(importCacheDirectory);
 	}
 }
 
+void ImportAssetsDatabase::setImportCacheDirectory(std::optional<Path> cacheDirectory)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	importCacheDirectory = std::move(cacheDirectory);
+	importCache = importCacheDirectory ? std::make_shared<ImportCache>(*importCacheDirectory, version, platforms) : nullptr;
+}
+
+std::shared_ptr<const ImportCache> ImportAssetsDatabase::getImportCache() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return importCache;
+}
+
 const ImportAssetsDatabase::AssetEntry* ImportAssetsDatabase::findEntry(AssetType type, const String& id) const
 {
 	if (indexDirty) {
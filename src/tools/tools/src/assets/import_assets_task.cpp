@@ -33,7 +33,9 @@ void ImportAssetsTask::run()
 	auto lastSave = std::chrono::steady_clock::now();
 
 	assetsImported = 0;
+	assetsFromCache = 0;
 	assetsToImport = files.size();
+	importCache = db.getImportCache();
 	Vector<Future<void>> tasks;
 
 	constexpr bool parallelImport = !Debug::isDebug();
@@ -94,6 +96,9 @@ void ImportAssetsTask::run()
 	const Time realTime = timer.elapsedNanoseconds() / 1000000000.0;
 	const Time importTime = totalImportTime / 1000000000.0;
 	logInfo("Import took " + toString(realTime) + " seconds, on which " + toString(importTime) + " seconds of work were performed (" + toString(importTime / realTime) + "x realtime)");
+	if (importCache) {
+		logInfo(toString(assetsFromCache.load()) + " of " + toString(assetsToImport) + " assets fetched from import cache at " + importCache->getDirectory().getNativeString());
+	}
 }
 
 bool ImportAssetsTask::doImportAsset(ImportAssetsDatabaseEntry& asset)
@@ -115,6 +120,9 @@ bool ImportAssetsTask::doImportAsset(ImportAssetsDatabaseEntry& asset)
 	if (isCancelled()) {
 		return false;
 	}
+	if (result.fromCache) {
+		++assetsFromCache;
+	}
 
 	// Retrieve previous output from this asset, and remove any files which went missing
 	HashSet<Path> outFiles;
@@ -189,6 +197,22 @@ ImportAssetsTask::ImportResult ImportAssetsTask::importAsset(const ImportAssetsD
 			}
 			importingAsset.inputFiles.emplace_back(ImportingAssetFile(f.getPath(), std::move(data), meta ? std::move(meta.value()) : Metadata()));
 		}
+
+		// Fetch the result from the cache if these exact inputs were imported before
+		std::optional<uint64_t> cacheKey;
+		if (importCache) {
+			cacheKey = importCache->getKey(importingAsset);
+			if (auto entry = importCache->tryGet(*cacheKey, importer.getAssetsSrc(), result.additionalInputs)) {
+				result.out = std::move(entry->out);
+				for (auto& [path, data]: entry->outFiles) {
+					result.outFiles.emplace_back(std::move(path), std::move(data));
+				}
+				result.success = true;
+				result.fromCache = true;
+				return result;
+			}
+		}
+
 		toLoad.emplace_back(std::move(importingAsset));
 
 		// Import
@@ -227,6 +251,10 @@ ImportAssetsTask::ImportResult ImportAssetsTask::importAsset(const ImportAssetsD
 		}
 		
 		result.success = true;
+
+		if (cacheKey && !isCancelled()) {
+			importCache->store(*cacheKey, result.out, result.outFiles, result.additionalInputs, importer.getAssetsSrc());
+		}
 	} catch (const Exception& e) {
 		result.errorMsg = e.getMessage();
 		result.success = false;
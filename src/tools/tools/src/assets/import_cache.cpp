@@ -0,0 +1,150 @@
+#include "halley/tools/assets/import_cache.h"
+#include "halley/tools/file/filesystem.h"
+#include "halley/bytes/byte_serializer.h"
+#include "halley/maths/uuid.h"
+#include "halley/support/logger.h"
+#include "halley/utils/hash.h"
+
+using namespace Halley;
+
+void ImportCache::Entry::AdditionalInput::serialize(Serializer& s) const
+{
+	s << srcIdx;
+	s << path;
+	s << hash;
+}
+
+void ImportCache::Entry::AdditionalInput::deserialize(Deserializer& s)
+{
+	s >> srcIdx;
+	s >> path;
+	s >> hash;
+}
+
+void ImportCache::Entry::serialize(Serializer& s) const
+{
+	s << out;
+	s << outFiles;
+	s << additionalInputs;
+}
+
+void ImportCache::Entry::deserialize(Deserializer& s)
+{
+	s >> out;
+	s >> outFiles;
+	s >> additionalInputs;
+}
+
+ImportCache::ImportCache(Path directory, int version, Vector<String> platforms)
+	: directory(std::move(directory))
+	, version(version)
+	, platforms(std::move(platforms))
+{
+}
+
+const Path& ImportCache::getDirectory() const
+{
+	return directory;
+}
+
+uint64_t ImportCache::getKey(const ImportingAsset& asset) const
+{
+	Hash::Hasher hasher;
+	hasher.feed(version);
+	hasher.feed(platforms.size());
+	for (const auto& platform: platforms) {
+		hasher.feed(platform);
+	}
+
+	hasher.feed(static_cast<int>(asset.assetType));
+	hasher.feed(asset.assetId);
+	hasher.feed(asset.inputFiles.size());
+	for (const auto& file: asset.inputFiles) {
+		hasher.feed(file.name.getString());
+		hasher.feed(file.data.size());
+		hasher.feedBytes(file.data.byte_span());
+
+		const auto meta = Serializer::toBytes(file.metadata);
+		hasher.feed(meta.size());
+		hasher.feedBytes(meta.byte_span());
+	}
+
+	return hasher.digest();
+}
+
+std::optional<ImportCache::Entry> ImportCache::tryGet(uint64_t key, const Vector<Path>& assetsSrc, Vector<TimestampedPath>& additionalInputs) const
+{
+	const auto data = FileSystem::readFile(getEntryPath(key));
+	if (data.empty()) {
+		return {};
+	}
+
+	Entry entry;
+	try {
+		Deserializer::fromBytes(entry, data);
+	} catch (const std::exception& e) {
+		Logger::logWarning("Discarding corrupt import cache entry " + getEntryPath(key).getString() + ": " + e.what());
+		return {};
+	}
+
+	Vector<TimestampedPath> inputs;
+	for (const auto& input: entry.additionalInputs) {
+		if (input.srcIdx < 0 || input.srcIdx >= static_cast<int>(assetsSrc.size())) {
+			return {};
+		}
+		const auto path = assetsSrc[input.srcIdx] / input.path;
+		const auto inputData = FileSystem::readFile(path);
+		if (inputData.empty() || Hash::hash(inputData) != input.hash) {
+			return {};
+		}
+		inputs.push_back(TimestampedPath(path, FileSystem::getLastWriteTime(path)));
+	}
+
+	additionalInputs = std::move(inputs);
+	return entry;
+}
+
+bool ImportCache::store(uint64_t key, const Vector<AssetResource>& out, const Vector<std::pair<Path, std::optional<Bytes>>>& outFiles, const Vector<TimestampedPath>& additionalInputs, const Vector<Path>& assetsSrc) const
+{
+	Entry entry;
+	entry.out = out;
+
+	entry.outFiles.reserve(outFiles.size());
+	for (const auto& [path, data]: outFiles) {
+		if (!data) {
+			// Written by the importer itself, we don't have the contents
+			return false;
+		}
+		entry.outFiles.emplace_back(path, *data);
+	}
+
+	for (const auto& input: additionalInputs) {
+		auto& dst = entry.additionalInputs.emplace_back();
+		const auto iter = std::find_if(assetsSrc.begin(), assetsSrc.end(), [&] (const Path& src) { return src.isPrefixOf(input.first); });
+		if (iter == assetsSrc.end()) {
+			return false;
+		}
+		dst.srcIdx = static_cast<int>(iter - assetsSrc.begin());
+		dst.path = input.first.makeRelativeTo(*iter);
+		dst.hash = Hash::hash(FileSystem::readFile(input.first));
+	}
+
+	// Write to a temporary file and move it into place, so concurrent readers (possibly on other machines) never see a partial entry
+	const auto path = getEntryPath(key);
+	const auto tmpPath = path.replaceExtension("." + UUID::generate().toString() + ".tmp");
+	FileSystem::createParentDir(path);
+	if (!FileSystem::writeFile(tmpPath, Serializer::toBytes(entry))) {
+		return false;
+	}
+	if (!FileSystem::rename(tmpPath, path)) {
+		FileSystem::remove(tmpPath);
+		return false;
+	}
+	return true;
+}
+
+Path ImportCache::getEntryPath(uint64_t key) const
+{
+	const auto hex = toString(key, 16, 16);
+	return directory / hex.substr(0, 2) / (hex + ".cache");
+}
@@ -3,7 +3,10 @@
 #include "halley/bytes/compression.h"
 #include "halley/tools/assets/import_assets_database.h"
 #include "halley/tools/file/filesystem.h"
+#include "halley/file_formats/block_compression.h"
 #include "halley/file_formats/image.h"
+#include "halley/graphics/texture_descriptor.h"
+#include "halley/support/logger.h"
 
 using namespace Halley;
 
@@ -18,19 +21,63 @@ void TextureImporter::import(const ImportingAsset& asset, IAssetCollector& colle
 	Image image;
 	Deserializer s(asset.inputFiles.at(0).data);
 	s >> image;
-	auto meta = asset.inputFiles.at(0).metadata;
+	const auto& meta = asset.inputFiles.at(0).metadata;
 
+	// GPU block compression is opt-in per texture, either for every platform ("blockCompression: bc7")
+	// or per platform ("blockCompression: { pc: bc7, android: astc4x4 }"). Platforms not listed fall back to "pc".
+	const auto blockCompression = meta.getValue("blockCompression");
+	if (blockCompression.getType() == ConfigNodeType::Map) {
+		for (const auto& [platform, format]: blockCompression.asMap()) {
+			importTexture(asset, collector, image, meta, format.asString(""), platform);
+		}
+		if (!blockCompression.hasKey("pc")) {
+			importTexture(asset, collector, image, meta, "", "pc");
+		}
+	} else {
+		importTexture(asset, collector, image, meta, blockCompression.asString(""), "pc");
+	}
+}
+
+void TextureImporter::importTexture(const ImportingAsset& asset, IAssetCollector& collector, const Image& image, Metadata meta, const String& blockCompression, const String& platform)
+{
 	const bool useQOI = false;
 	const bool useHLIF = true;
 
+	const auto imgFormat = image.getFormat();
+	const bool canBlockCompress = imgFormat == Image::Format::RGB || imgFormat == Image::Format::RGBA || imgFormat == Image::Format::RGBAPremultiplied;
+
+	if (!blockCompression.isEmpty() && canBlockCompress) {
+		const auto format = fromString<TextureFormat>(blockCompression);
+		if (!TextureDescriptor::isBlockCompressed(format)) {
+			throw Exception("\"" + blockCompression + "\" is not a block-compressed texture format, on texture " + asset.assetId, HalleyExceptions::Tools);
+		}
+
+		// Direct3D only accepts BC textures whose top level is made of whole 4x4 blocks
+		const auto size = image.getSize();
+		const bool isBC = format == TextureFormat::BC1 || format == TextureFormat::BC3 || format == TextureFormat::BC7;
+		if (isBC && (size.x % 4 != 0 || size.y % 4 != 0)) {
+			Logger::logWarning("Texture " + asset.assetId + " can't be compressed to " + toString(format) + ", as its size (" + toString(size.x) + "x" + toString(size.y) + ") isn't a multiple of 4");
+		} else {
+			// The mip chain is encoded here, since block-compressed textures can't have mipmaps generated on the GPU
+			const int mipLevels = meta.getBool("mipmap", false) ? TextureDescriptor::getMaxMipLevels(size) : 1;
+			meta.set("compression", "block");
+			meta.set("textureFormat", toString(format));
+			meta.set("mipLevels", mipLevels);
+			collector.output(asset.assetId, AssetType::Texture, BlockCompression::encode(image, format, mipLevels), meta, platform);
+			return;
+		}
+	} else if (!blockCompression.isEmpty()) {
+		Logger::logWarning("Texture " + asset.assetId + " can't be block-compressed, as its image format is " + toString(imgFormat));
+	}
+
 	if (useHLIF) {
 		meta.set("compression", "hlif");
-		collector.output(asset.assetId, AssetType::Texture, image.saveHLIFToBytes(asset.assetId, lz4hc), meta);
-	} else if (useQOI && (image.getFormat() == Image::Format::RGB || image.getFormat() == Image::Format::RGBA || image.getFormat() == Image::Format::RGBAPremultiplied)) {
+		collector.output(asset.assetId, AssetType::Texture, image.saveHLIFToBytes(asset.assetId, lz4hc), meta, platform);
+	} else if (useQOI && (imgFormat == Image::Format::RGB || imgFormat == Image::Format::RGBA || imgFormat == Image::Format::RGBAPremultiplied)) {
 		meta.set("compression", "qoi");
-		collector.output(asset.assetId, AssetType::Texture, image.saveQOIToBytes(), meta);
+		collector.output(asset.assetId, AssetType::Texture, image.saveQOIToBytes(), meta, platform);
 	} else {
 		meta.set("compression", "png");
-		collector.output(asset.assetId, AssetType::Texture, image.savePNGToBytes(), meta);
+		collector.output(asset.assetId, AssetType::Texture, image.savePNGToBytes(), meta, platform);
 	}
 }
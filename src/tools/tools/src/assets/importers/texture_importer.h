@@ -3,6 +3,8 @@
 
 namespace Halley
 {
+	class Image;
+
 	class TextureImporter : public IAssetImporter
 	{
 	public:
@@ -13,5 +15,7 @@ namespace Halley
 
 	private:
 		bool lz4hc;
+
+		void importTexture(const ImportingAsset& asset, IAssetCollector& collector, const Image& image, Metadata meta, const String& blockCompression, const String& platform);
 	};
 }
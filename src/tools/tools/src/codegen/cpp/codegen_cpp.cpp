@@ -438,7 +438,11 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 			.addBlankLine();
 	}
 
-	sysClassGen.setAccessLevel(MemberAccess::Protected);
+	// parallelForEach only records structural changes through its EntityCommandBuffer, so it's available regardless of access
+	sysClassGen
+		.setAccessLevel(MemberAccess::Protected)
+		.addLine("using Halley::System::parallelForEach;")
+		.addBlankLine();
 
 	if ((int(system.access) & int(SystemAccess::API)) != 0) {
 		sysClassGen.addMethodDefinition(MethodSchema(TypeSchema("const Halley::HalleyAPI&"), {}, "getAPI", true), "return doGetAPI();");
@@ -547,6 +551,62 @@ Vector<String> CodegenCPP::generateSystemHeader(SystemSchema& system, const Hash
 		.setAccessLevel(MemberAccess::Private)
 		.addMethodDefinition(MethodSchema(TypeSchema("void"), {}, "initBase", false, false, true, true), initBaseMethodBody);
 
+	// Access declaration, used by World to schedule systems concurrently
+	// Systems that can reach the world, API or other systems directly can't be reasoned about, so they keep the default (exclusive) declaration
+	const int exclusiveAccess = int(SystemAccess::API) | int(SystemAccess::World) | int(SystemAccess::MessageBridge);
+	const bool sendsSystemMessages = std::any_of(system.systemMessages.begin(), system.systemMessages.end(), [] (const MessageReferenceSchema& msg) { return msg.send; });
+	if ((int(system.access) & exclusiveAccess) == 0 && !sendsSystemMessages) {
+		Vector<String> componentsRead;
+		Vector<String> componentsWritten;
+		for (auto& fam: system.families) {
+			for (auto& comp: fam.components) {
+				const auto id = comp.name + "Component::componentIndex";
+				if (comp.write && !std_ex::contains(componentsWritten, id)) {
+					componentsWritten.push_back(id);
+				}
+			}
+		}
+		for (auto& fam: system.families) {
+			for (auto& comp: fam.components) {
+				const auto id = comp.name + "Component::componentIndex";
+				if (!std_ex::contains(componentsWritten, id) && !std_ex::contains(componentsRead, id)) {
+					componentsRead.push_back(id);
+				}
+			}
+		}
+
+		Vector<String> messagesSent;
+		Vector<String> messagesReceived;
+		for (auto& msg: system.messages) {
+			if (msg.send) {
+				messagesSent.push_back(msg.name + "Message::messageIndex");
+			}
+			if (msg.receive) {
+				messagesReceived.push_back(msg.name + "Message::messageIndex");
+			}
+		}
+
+		const auto services = convert<ServiceSchema, String>(system.services, [](auto& service) { return "\"" + service.name + "\""; });
+
+		Vector<String> accessBody = { "Halley::SystemAccessDeclaration result;", "result.exclusive = false;" };
+		const auto addList = [&] (const String& field, const Vector<String>& values)
+		{
+			if (!values.empty()) {
+				accessBody.push_back("result." + field + " = { " + String::concatList(values, ", ") + " };");
+			}
+		};
+		addList("componentsRead", componentsRead);
+		addList("componentsWritten", componentsWritten);
+		addList("services", services);
+		addList("messagesSent", messagesSent);
+		addList("messagesReceived", messagesReceived);
+		accessBody.push_back("return result;");
+
+		sysClassGen
+			.addBlankLine()
+			.addMethodDefinition(MethodSchema(TypeSchema("Halley::SystemAccessDeclaration"), {}, "getAccessDeclaration", true, false, true, true), accessBody);
+	}
+
 	auto fams = convert<FamilySchema, MemberSchema>(system.families, [](auto& fam) { return MemberSchema(TypeSchema("Halley::FamilyBinding<" + upperFirst(fam.name) + "Family>"), fam.name + "Family"); });
 	auto mid = fams.begin() + std::min(fams.size(), size_t(1));
 	Vector<MemberSchema> mainFams(fams.begin(), mid);
@@ -10,8 +10,76 @@
 #include "halley/tools/assets/import_assets_database.h"
 #include "halley/tools/file/filesystem_cache.h"
 #include "halley/utils/algorithm.h"
+#include "halley/concurrency/concurrent.h"
+#include <cstdio>
+#include <thread>
 using namespace Halley;
 
+namespace {
+	// Sequential writer for pack files, so pack data never has to be held in memory as a whole
+	class PackFileWriter {
+	public:
+		explicit PackFileWriter(const Path& path)
+			: path(path)
+		{
+			FileSystem::createParentDir(path);
+#ifdef WIN32
+			_wfopen_s(&fp, path.getNativeString().getUTF16().c_str(), L"wb");
+#else
+			fp = fopen(path.getNativeString().c_str(), "wb");
+#endif
+			if (!fp) {
+				throw Exception("Unable to open pack file " + path.getNativeString() + " for writing", HalleyExceptions::Tools);
+			}
+		}
+
+		~PackFileWriter()
+		{
+			if (fp) {
+				fclose(fp);
+			}
+		}
+
+		PackFileWriter(const PackFileWriter& other) = delete;
+		PackFileWriter& operator=(const PackFileWriter& other) = delete;
+
+		void write(gsl::span<const gsl::byte> data)
+		{
+			if (fwrite(data.data(), 1, data.size(), fp) != size_t(data.size())) {
+				throw Exception("Unable to write pack file " + path.getNativeString(), HalleyExceptions::Tools);
+			}
+			pos += data.size();
+		}
+
+		void writeAtStart(gsl::span<const gsl::byte> data)
+		{
+			if (fseek(fp, 0, SEEK_SET) != 0) {
+				throw Exception("Unable to write pack file " + path.getNativeString(), HalleyExceptions::Tools);
+			}
+			write(data);
+		}
+
+		uint64_t getPosition() const
+		{
+			return pos;
+		}
+
+		void close()
+		{
+			const bool ok = fclose(fp) == 0;
+			fp = nullptr;
+			if (!ok) {
+				throw Exception("Unable to write pack file " + path.getNativeString(), HalleyExceptions::Tools);
+			}
+		}
+
+	private:
+		Path path;
+		FILE* fp = nullptr;
+		uint64_t pos = 0;
+	};
+}
+
 
 bool AssetPackListing::Entry::operator<(const Entry& other) const
 {
@@ -182,75 +250,148 @@ void AssetPacker::generatePacks(Project& project, std::map<String, AssetPackList
 		}
 	}
 
-	size_t n = toPack.size();
-	for (size_t i = 0; i < n; ++i) {
-		if (!std_ex::contains(packed, toPack[i].name)) {
-			packed.push_back(toPack[i].name);
+	const size_t n = toPack.size();
+	for (const auto& entry: toPack) {
+		if (!std_ex::contains(packed, entry.name)) {
+			packed.push_back(entry.name);
+		}
+	}
+
+	// Packs are independent of each other, so generate them in parallel, one pack per chunk.
+	// Progress is reported under a lock, as the average over all packs. Log messages are kept per pack and only written out from this thread, once every pack is done.
+	std::mutex progressMutex;
+	Vector<float> packProgress(n, 0.0f);
+	Vector<LogMessages> logs(n);
+	Vector<std::exception_ptr> errors(n);
+
+	Concurrent::foreachChunk(Executors::getCPUAux(), n, 1, [&] (size_t, size_t start, size_t end, size_t)
+	{
+		for (size_t i = start; i < end; ++i) {
+			try {
+				generatePack(project, toPack[i].name, *toPack[i].listing, src, toPack[i].dstPack, [&, i] (float p, const String& s)
+				{
+					std::unique_lock<std::mutex> lock(progressMutex);
+					packProgress[i] = p;
+					float total = 0;
+					for (const auto pp: packProgress) {
+						total += pp;
+					}
+					progress(total / float(n), s);
+				}, logs[i]);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}
+	});
+
+	for (const auto& log: logs) {
+		for (const auto& [level, msg]: log) {
+			Logger::log(level, msg);
+		}
+	}
+
+	for (const auto& error: errors) {
+		if (error) {
+			std::rethrow_exception(error);
 		}
-		generatePack(project, toPack[i].name, *toPack[i].listing, src, toPack[i].dstPack, [=] (float p, const String& s)
-		{
-			progress((p + i) * (1.0f / n), s);
-		});
 	}
 }
 
-void AssetPacker::generatePack(Project& project, const String& packId, const AssetPackListing& packListing, const Path& src, const Path& dst, ProgressCallback progress)
+void AssetPacker::generatePack(Project& project, const String& packId, const AssetPackListing& packListing, const Path& src, const Path& dst, ProgressCallback progress, LogMessages& log)
 {
 	AssetPack pack;
 	AssetDatabase& db = pack.getAssetDatabase();
-	Bytes& data = pack.getData();
 	auto& fs = project.getFileSystemCache();
+	const bool encrypted = !packListing.getEncryptionKey().isEmpty();
 
-	// Read old version of this pack, if available
+	// Open old version of this pack, if available. Only the entries that are copied over are read from it.
 	std::unique_ptr<AssetPack> oldPack;
 	auto reader = std::make_unique<ResourceDataReaderFileSystem>(dst);
 	if (reader->size() > 0) {
 		try {
-			oldPack = std::make_unique<AssetPack>(std::move(reader), packListing.getEncryptionKey(), true);
+			oldPack = std::make_unique<AssetPack>(std::move(reader), packListing.getEncryptionKey(), false);
 		} catch (...) {
 			// Just ignore it if it fails to load asset pack for whatever reason
 		}
 	}
 	reader = {};
 
+	// Unencrypted packs are streamed straight to a temporary file, with the index written after the data.
+	// Encrypted packs are encrypted as a whole, so they are still built in memory.
+	const auto tmpDst = Path(dst.getString() + ".tmp");
+	std::unique_ptr<PackFileWriter> writer;
+	Bytes& memData = pack.getData();
+	uint64_t dataStart = 0;
+	uint64_t dataSize = 0;
+	if (!encrypted) {
+		writer = std::make_unique<PackFileWriter>(tmpDst);
+		dataStart = alignUp(uint64_t(sizeof(AssetPackHeader)), uint64_t(AssetPackHeader::dataAlignment));
+		writer->write(Bytes(size_t(dataStart)).byte_span());
+	}
+
+	auto appendData = [&] (gsl::span<const gsl::byte> bytes) {
+		if (writer) {
+			writer->write(bytes);
+		} else {
+			const size_t pos = memData.size();
+			memData.resize(pos + bytes.size());
+			memcpy(memData.data() + pos, bytes.data(), bytes.size());
+		}
+		dataSize += bytes.size();
+	};
+
+	constexpr size_t copyChunkSize = 1024 * 1024;
+	Bytes copyBuffer;
+	const Bytes padding(AssetPackHeader::entryAlignment);
+
 	const size_t n = packListing.getEntries().size();
 	size_t i = 0;
 
 	for (auto& entry: packListing.getEntries()) {
-		// Read original file
 		// Priority:
 		// 1. Cache
 		// 2. Old pack
 		// 3. Filesystem (via cache)
+		const AssetDatabase::Entry* oldEntry = nullptr;
+		if (!entry.modified && !fs.hasCached(src / entry.path) && oldPack) {
+			oldEntry = oldPack->getAssetDatabase().getDatabase(entry.type).tryGet(entry.name);
+		}
+
 		Bytes fileData;
-		if (entry.modified || fs.hasCached(src / entry.path) || !oldPack) {
-			// Read from cache or filesystem
+		if (!oldEntry || oldEntry->packSize == 0) {
+			oldEntry = nullptr;
 			fileData = fs.readFile(src / entry.path);
-		} else {
-			// Read from pack
-			auto oldData = oldPack->getData(entry.name, entry.type, false);
-			if (oldData) {
-				auto data = dynamic_cast<ResourceDataStatic*>(oldData.get())->getSpan();
-				fileData = Bytes(reinterpret_cast<const Byte*>(data.data()), reinterpret_cast<const Byte*>(data.data()) + data.size());
-			} else {
-				// Read from cache after all...
-				fileData = fs.readFile(src / entry.path);
+			if (fileData.empty()) {
+				log.emplace_back(LoggerLevel::Error, "Unable to pack: \"" + (src / entry.path) + "\". File not found or empty.");
+				continue;
 			}
 		}
 
-		const size_t size = fileData.size();
-		if (size == 0) {
-			Logger::logError("Unable to pack: \"" + (src / entry.path) + "\". File not found or empty.");
-			continue;
+		// Align each entry, so mapped packs hand out aligned data
+		const uint64_t pos = alignUp(dataSize, uint64_t(AssetPackHeader::entryAlignment));
+		appendData(padding.byte_span().subspan(0, size_t(pos - dataSize)));
+
+		uint64_t size = 0;
+		if (oldEntry) {
+			// Block copy from the old pack
+			size = oldEntry->packSize;
+			copyBuffer.resize(size_t(std::min(size, uint64_t(copyChunkSize))));
+			for (uint64_t copied = 0; copied < size; ) {
+				const auto chunk = gsl::as_writable_bytes(gsl::span<Byte>(copyBuffer)).subspan(0, size_t(std::min(size - copied, uint64_t(copyChunkSize))));
+				oldPack->readData(size_t(oldEntry->packPos + copied), chunk);
+				appendData(chunk);
+				copied += chunk.size();
+			}
+		} else {
+			size = fileData.size();
+			appendData(fileData.byte_span());
 		}
-		
-		// Read data into pack data
-		const size_t pos = data.size();
-		data.reserve(nextPowerOf2(pos + size));
-		data.resize(pos + size);
-		memcpy(data.data() + pos, fileData.data(), size);
 
-		db.addAsset(entry.name, entry.type, AssetDatabase::Entry(toString(pos) + ":" + toString(size), entry.metadata));
+		// The location is stored in the pack's entry table, so the path is left empty
+		auto dbEntry = AssetDatabase::Entry(String(), entry.metadata);
+		dbEntry.packPos = pos;
+		dbEntry.packSize = size;
+		db.addAsset(entry.name, entry.type, std::move(dbEntry));
 
 		progress(float(i) / float(n), packId);
 		i++;
@@ -258,24 +399,34 @@ void AssetPacker::generatePack(Project& project, const String& packId, const Ass
 
 	oldPack = {}; // Release file handle!
 
-	if (!packListing.getEncryptionKey().isEmpty()) {
-		Logger::logInfo("- Encrypting \"" + packId + "\"...");
+	if (writer) {
+		AssetPackHeader header;
+		const auto index = pack.writeOutIndex(header, dataStart, dataSize);
+		writer->write(index.byte_span());
+		writer->writeAtStart(gsl::as_bytes(gsl::span<const AssetPackHeader>(&header, 1)));
+		writer->close();
+		writer = {};
+	} else {
+		log.emplace_back(LoggerLevel::Info, "- Encrypting \"" + packId + "\"...");
 		pack.encrypt(packListing.getEncryptionKey());
+		if (!FileSystem::writeFile(tmpDst, pack.writeOut())) {
+			throw Exception("Unable to write pack file " + tmpDst.getNativeString(), HalleyExceptions::Tools);
+		}
 	}
 
-	// Write pack
-	const auto packData = pack.writeOut();
-	bool packed = FileSystem::writeFile(dst, packData);
+	// Replace the old pack only once the new one is complete
+	bool packed = FileSystem::rename(tmpDst, dst);
 	if (!packed) {
 		// Try again
 		using namespace std::chrono_literals;
 		std::this_thread::sleep_for(200ms);
-		packed = FileSystem::writeFile(dst, packData);
+		packed = FileSystem::rename(tmpDst, dst);
 	}
 
 	if (packed) {
-		Logger::logInfo("- Packed " + toString(packListing.getEntries().size()) + " entries on \"" + packId + "\" (" + String::prettySize(data.size()) + ").");
+		log.emplace_back(LoggerLevel::Info, "- Packed " + toString(packListing.getEntries().size()) + " entries on \"" + packId + "\" (" + String::prettySize(static_cast<long long>(dataSize)) + ").");
 	} else {
+		FileSystem::remove(tmpDst);
 		throw Exception("Unable to write pack file " + dst.getNativeString(), HalleyExceptions::Tools);
 	}
 }
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <utility>
 #include "halley/tools/assets/import_assets_database.h"
 #include "halley/tools/project/project.h"
@@ -47,6 +48,13 @@ Project::Project(Path projectRootPath, Path halleyRootPath, Vector<String> disab
 	codegenDatabase = std::make_unique<ImportAssetsDatabase>(getGenPath(), getGenPath() / "import.db", getGenPath() / "assets.db", Vector<String>{ "" }, currentCodegenVersion + currentAssetVersion);
 	sharedCodegenDatabase = std::make_unique<ImportAssetsDatabase>(getSharedGenPath(), getSharedGenPath() / "import.db", getSharedGenPath() / "assets.db", Vector<String>{ "" }, currentCodegenVersion + currentAssetVersion);
 
+	// Build agents can point at a shared import cache through the environment, without touching the project
+	const char* importCacheEnv = std::getenv("HALLEY_IMPORT_CACHE");
+	const Path importCachePath = importCacheEnv && importCacheEnv[0] ? Path(importCacheEnv) : Path(properties->getImportCachePath());
+	if (!importCachePath.isEmpty()) {
+		importAssetsDatabase->setImportCacheDirectory(importCachePath.isAbsolute() ? importCachePath : rootPath / importCachePath);
+	}
+
 	fileSystemCache = std::make_unique<FileSystemCache>();
 }
 
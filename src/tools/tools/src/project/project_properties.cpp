@@ -83,6 +83,17 @@ float ProjectProperties::getDefaultZoom() const
 	return defaultZoom;
 }
 
+const String& ProjectProperties::getImportCachePath() const
+{
+	return importCachePath;
+}
+
+void ProjectProperties::setImportCachePath(String path)
+{
+	importCachePath = std::move(path);
+	dirty = true;
+}
+
 void ProjectProperties::loadDefaults()
 {
 	uuid = UUID::generate();
@@ -91,6 +102,7 @@ void ProjectProperties::loadDefaults()
 	binName = "";
 	importByExtension = false;
 	defaultZoom = 1.0f;
+	importCachePath = "";
 	platforms = {"pc"};
 }
 
@@ -124,6 +136,9 @@ void ProjectProperties::load()
 		if (node.hasKey("platforms")) {
 			platforms = node["platforms"].asVector<String>();
 		}
+		if (node.hasKey("importCachePath")) {
+			importCachePath = node["importCachePath"].asString();
+		}
 	}
 
 	save();
@@ -140,6 +155,9 @@ void ProjectProperties::save()
 	node["importByExtension"] = importByExtension;
 	node["defaultZoom"] = defaultZoom;
 	node["platforms"] = platforms;
+	if (!importCachePath.isEmpty()) {
+		node["importCachePath"] = importCachePath;
+	}
 
 	const auto curFile = Path::readFile(propertiesFile);
 	const auto yaml = YAMLConvert::generateYAML(node, YAMLConvert::EmitOptions());